@@ -0,0 +1,19 @@
+/*
+ * linux/arch/arm/include/asm/crc32.h
+ *
+ * NEON CRC32 folding routine, see arch/arm/lib/crc32-neon.S
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#ifndef __ASM_ARM_CRC32_H
+#define __ASM_ARM_CRC32_H
+
+#include <linux/types.h>
+
+/* must be called between kernel_neon_begin() and kernel_neon_end() */
+extern void crc32_neon_fold(u8 *acc, const u8 *buf, size_t chunks,
+			    const u64 *k);
+
+#endif /* __ASM_ARM_CRC32_H */
@@ -150,6 +150,7 @@ extern void __cpu_copy_user_highpage(struct page *to, struct page *from,
 
 #define clear_page(page)	memset((void *)(page), 0, PAGE_SIZE)
 extern void copy_page(void *to, const void *from);
+extern void copy_page_std(void *to, const void *from);
 
 #define __HAVE_ARCH_PAGECMP
 extern int cmp_page(const void *, const void *);
@@ -18,6 +18,7 @@
 #include <linux/io.h>
 
 #include <asm/checksum.h>
+#include <asm/crc32.h>
 #include <asm/ftrace.h>
 
 /*
@@ -94,6 +95,12 @@ EXPORT_SYMBOL(__copy_from_user);
 EXPORT_SYMBOL(__copy_to_user);
 EXPORT_SYMBOL(__clear_user);
 
+#ifdef CONFIG_ARM_NEON_COPY
+EXPORT_SYMBOL_GPL(copy_page_std);
+EXPORT_SYMBOL_GPL(__copy_from_user_std);
+EXPORT_SYMBOL_GPL(__copy_to_user_std);
+#endif
+
 EXPORT_SYMBOL(__get_user_1);
 EXPORT_SYMBOL(__get_user_2);
 EXPORT_SYMBOL(__get_user_4);
@@ -157,3 +164,7 @@ EXPORT_SYMBOL(__gnu_mcount_nc);
 #ifdef CONFIG_ARM_PATCH_PHYS_VIRT
 EXPORT_SYMBOL(__pv_phys_offset);
 #endif
+
+#ifdef CONFIG_CRC32_NEON
+EXPORT_SYMBOL_GPL(crc32_neon_fold);
+#endif
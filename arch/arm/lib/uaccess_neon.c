@@ -0,0 +1,159 @@
+/*
+ *  linux/arch/arm/lib/uaccess_neon.c
+ *
+ *  NEON accelerated copy_page and user copy routines
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Krait and Cortex-A15 sustain noticeably higher copy bandwidth through the
+ * 128 bit NEON load/store path than through ldm/stm. Saving the user's VFP
+ * state on kernel_neon_begin() is not free though, so the NEON kernels are
+ * only used for copies of at least neon_copy_threshold bytes, outside of
+ * interrupt context, and on the cores they were tuned for. Everything else
+ * goes through the _std routines exactly as before.
+ */
+
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/uaccess.h>
+#include <linux/hardirq.h>
+#include <asm/cputype.h>
+#include <asm/neon.h>
+#include <asm/page.h>
+
+extern void copy_page_neon(void *to, const void *from);
+extern unsigned long __copy_from_user_neon(void *to, const void __user *from,
+					   unsigned long n);
+extern unsigned long __copy_to_user_neon(void __user *to, const void *from,
+					 unsigned long n);
+
+/* -1: decide from the CPU id at boot, 0: never, 1: whenever NEON exists */
+static int neon_copy = -1;
+module_param(neon_copy, int, 0444);
+MODULE_PARM_DESC(neon_copy, "use NEON copy routines (-1 auto, 0 off, 1 on)");
+
+/* the NEON kernels need at least one whole 64 byte block */
+#define NEON_COPY_MIN_THRESHOLD	64
+
+static unsigned int neon_copy_threshold __read_mostly = 1024;
+
+static int neon_copy_threshold_set(const char *val,
+				   const struct kernel_param *kp)
+{
+	unsigned int threshold;
+	int ret;
+
+	ret = kstrtouint(val, 0, &threshold);
+	if (ret)
+		return ret;
+	if (threshold < NEON_COPY_MIN_THRESHOLD)
+		return -EINVAL;
+
+	*(unsigned int *)kp->arg = threshold;
+	return 0;
+}
+
+static struct kernel_param_ops neon_copy_threshold_ops = {
+	.set = neon_copy_threshold_set,
+	.get = param_get_uint,
+};
+
+module_param_cb(neon_copy_threshold, &neon_copy_threshold_ops,
+		&neon_copy_threshold, 0644);
+MODULE_PARM_DESC(neon_copy_threshold,
+		 "smallest user copy done with NEON (at least 64)");
+
+static bool neon_copy_active __read_mostly;
+
+static inline bool use_neon_copy(unsigned long n)
+{
+	return neon_copy_active && n >= neon_copy_threshold && !in_interrupt();
+}
+
+void copy_page(void *to, const void *from)
+{
+	if (!neon_copy_active || in_interrupt()) {
+		copy_page_std(to, from);
+		return;
+	}
+
+	kernel_neon_begin();
+	copy_page_neon(to, from);
+	kernel_neon_end();
+}
+
+unsigned long
+__copy_from_user(void *to, const void __user *from, unsigned long n)
+{
+	unsigned long blocks, done;
+
+	blocks = n & ~63UL;
+	if (!blocks || !use_neon_copy(n))
+		return __copy_from_user_std(to, from, n);
+
+	/*
+	 * Preemption is off between kernel_neon_begin() and kernel_neon_end(),
+	 * so a fault cannot be serviced here. Stop at the faulting block and
+	 * let the standard routine fault the page in, copy the remainder and
+	 * zero whatever could not be read.
+	 */
+	kernel_neon_begin();
+	pagefault_disable();
+	done = blocks - __copy_from_user_neon(to, from, blocks);
+	pagefault_enable();
+	kernel_neon_end();
+
+	if (done == n)
+		return 0;
+	return __copy_from_user_std(to + done, from + done, n - done);
+}
+
+unsigned long
+__copy_to_user(void __user *to, const void *from, unsigned long n)
+{
+	unsigned long blocks, done;
+
+	blocks = n & ~63UL;
+	if (!blocks || !use_neon_copy(n))
+		return __copy_to_user_std(to, from, n);
+
+	kernel_neon_begin();
+	pagefault_disable();
+	done = blocks - __copy_to_user_neon(to, from, blocks);
+	pagefault_enable();
+	kernel_neon_end();
+
+	if (done == n)
+		return 0;
+	return __copy_to_user_std(to + done, from + done, n - done);
+}
+
+static bool __init neon_copy_tuned_cpu(void)
+{
+	switch (read_cpuid_id() & 0xff00fff0) {
+	case 0x510004d0:	/* Krait 200 */
+	case 0x510006f0:	/* Krait 300/400 */
+	case 0x4100c0f0:	/* Cortex-A15 */
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* runs after vfp_init() has set HWCAP_NEON */
+static int __init uaccess_neon_init(void)
+{
+	if (!cpu_has_neon() || neon_copy == 0)
+		return 0;
+	if (neon_copy < 0 && !neon_copy_tuned_cpu())
+		return 0;
+
+	neon_copy_active = true;
+	pr_info("NEON copy_page/copy_*_user enabled (threshold %u bytes)\n",
+		neon_copy_threshold);
+	return 0;
+}
+arch_initcall(uaccess_neon_init);
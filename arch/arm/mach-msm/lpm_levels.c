@@ -26,6 +26,8 @@
 #include <linux/pm_qos.h>
 #include <linux/quickwakeup.h>
 #include <linux/of_platform.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <mach/mpm.h>
 #include <mach/cpuidle.h>
 #include <mach/event_timer.h>
@@ -125,9 +127,49 @@ static int msm_pm_sleep_time_override;
 module_param_named(sleep_time_override,
 	msm_pm_sleep_time_override, int, S_IRUGO | S_IWUSR | S_IWGRP);
 
+static bool lpm_prediction = true;
+module_param_named(lpm_prediction,
+	lpm_prediction, bool, S_IRUGO | S_IWUSR | S_IWGRP);
+
+static uint32_t ref_stddev = 500;
+module_param_named(ref_stddev,
+	ref_stddev, uint, S_IRUGO | S_IWUSR | S_IWGRP);
+
+static uint32_t tmr_add = 100;
+module_param_named(tmr_add,
+	tmr_add, uint, S_IRUGO | S_IWUSR | S_IWGRP);
+
 static int num_powered_cores;
 static struct hrtimer lpm_hrtimer;
 
+#define LPM_HIST_SAMPLES	8
+
+/*
+ * Per cpu record of the last idle periods, used to predict the next one
+ * when the cpu is woken up well ahead of its next timer by interrupts.
+ * Only ever touched by the owning cpu with interrupts disabled.
+ */
+struct lpm_history {
+	uint32_t resi[LPM_HIST_SAMPLES];
+	int nsamp;
+	int hptr;
+	uint32_t allowed;
+	uint32_t pred_timer_us;
+	bool predicted;
+};
+
+struct lpm_pred_stats {
+	unsigned long entries[CPUIDLE_STATE_MAX];
+	unsigned long too_deep[CPUIDLE_STATE_MAX];
+	unsigned long too_shallow[CPUIDLE_STATE_MAX];
+	unsigned long predicted;
+	unsigned long pred_timer_wakeups;
+};
+
+static DEFINE_PER_CPU(struct lpm_history, lpm_hist);
+static DEFINE_PER_CPU(struct lpm_pred_stats, lpm_pred_stats);
+static DEFINE_PER_CPU(struct hrtimer, lpm_pred_timer);
+
 static struct kobj_attribute lpm_l2_kattr = __ATTR(l2,  S_IRUGO|S_IWUSR,\
 		lpm_levels_attr_show, lpm_levels_attr_store);
 
@@ -491,8 +533,156 @@ static void msm_pm_set_timer(uint32_t modified_time_us)
 	hrtimer_start(&lpm_hrtimer, modified_ktime, HRTIMER_MODE_REL_PINNED);
 }
 
+static uint32_t lpm_level_power(struct power_params *pwr,
+		uint32_t next_wakeup_us)
+{
+	uint32_t power = pwr->ss_power;
+
+	if ((next_wakeup_us >> 10) <= pwr->time_overhead_us) {
+		power -= (pwr->time_overhead_us * pwr->ss_power)
+				/ next_wakeup_us;
+		power += pwr->energy_overhead / next_wakeup_us;
+	}
+	return power;
+}
+
+/*
+ * Predict the length of the coming idle period from the recent history of
+ * this cpu, the same way the menu governor finds a repeating interval: if
+ * the samples are tightly grouped their average is a good guess; if they
+ * are not, drop the largest ones (most likely timer driven long sleeps)
+ * and try again until too few samples are left. Returns 0 when there is
+ * no usable prediction.
+ */
+static uint32_t lpm_cpu_predict(struct lpm_history *h)
+{
+	uint64_t avg, variance, max;
+	uint64_t thresh = ULLONG_MAX;
+	int i, divisor;
+
+	if (h->nsamp < LPM_HIST_SAMPLES)
+		return 0;
+
+again:
+	max = 0;
+	avg = 0;
+	divisor = 0;
+	for (i = 0; i < LPM_HIST_SAMPLES; i++) {
+		uint64_t value = h->resi[i];
+
+		if (value <= thresh) {
+			avg += value;
+			divisor++;
+			if (value > max)
+				max = value;
+		}
+	}
+	do_div(avg, divisor);
+
+	variance = 0;
+	for (i = 0; i < LPM_HIST_SAMPLES; i++) {
+		int64_t diff = (int64_t)h->resi[i] - (int64_t)avg;
+
+		if (h->resi[i] <= thresh)
+			variance += diff * diff;
+	}
+	do_div(variance, divisor);
+
+	/*
+	 * Accept the average when the standard deviation is below
+	 * ref_stddev, or below a sixth of the average itself. Compare
+	 * squares to stay clear of a 64 bit square root.
+	 */
+	if (variance <= (uint64_t)ref_stddev * ref_stddev ||
+			avg * avg > 36 * variance)
+		return (uint32_t)avg;
+
+	if (divisor * 4 <= LPM_HIST_SAMPLES * 3)
+		return 0;
+
+	thresh = max - 1;
+	goto again;
+}
+
+static enum hrtimer_restart lpm_pred_timer_cb(struct hrtimer *h)
+{
+	return HRTIMER_NORESTART;
+}
+
+static void lpm_pred_timer_start(int cpu, uint32_t time_us)
+{
+	struct hrtimer *timer = &per_cpu(lpm_pred_timer, cpu);
+
+	per_cpu(lpm_hist, cpu).pred_timer_us = time_us;
+	hrtimer_start(timer, ns_to_ktime((u64)time_us * NSEC_PER_USEC),
+			HRTIMER_MODE_REL_PINNED);
+}
+
+/*
+ * Account the idle period that just ended: add it to the history, and
+ * compare the level that was picked against the one the power model would
+ * have picked had the residency been known up front.
+ */
+static void lpm_update_history(int cpu, int idx, uint32_t residency_us)
+{
+	struct lpm_history *h = &per_cpu(lpm_hist, cpu);
+	struct lpm_pred_stats *st = &per_cpu(lpm_pred_stats, cpu);
+	uint32_t best_pwr = ~0U;
+	int best = -1;
+	int i;
+
+	if (h->pred_timer_us) {
+		hrtimer_try_to_cancel(&per_cpu(lpm_pred_timer, cpu));
+		if (residency_us >= h->pred_timer_us) {
+			/*
+			 * The prediction was wrong and the cpu sat in a
+			 * shallow level until the safety timer fired. The
+			 * pattern is gone: start learning from scratch so
+			 * the next selection goes by the timers alone.
+			 */
+			st->pred_timer_wakeups++;
+			h->nsamp = 0;
+			h->hptr = 0;
+		}
+		h->pred_timer_us = 0;
+	}
+
+	if (idx < 0 || idx >= CPUIDLE_STATE_MAX)
+		return;
+
+	st->entries[idx]++;
+	if (h->predicted)
+		st->predicted++;
+
+	for (i = 0; i < sys_state.num_cpu_levels; i++) {
+		struct power_params *pwr = &sys_state.cpu_level[i].pwr;
+		uint32_t power;
+
+		if (!(h->allowed & BIT(i)))
+			continue;
+		if (residency_us <= pwr->time_overhead_us)
+			continue;
+		power = lpm_level_power(pwr, residency_us);
+		if (best_pwr >= power) {
+			best = i;
+			best_pwr = power;
+		}
+	}
+
+	if (best >= 0 && idx > best)
+		st->too_deep[idx]++;
+	else if (best >= 0 && idx < best)
+		st->too_shallow[idx]++;
+
+	if (h->nsamp < LPM_HIST_SAMPLES)
+		h->nsamp++;
+	h->resi[h->hptr] = residency_us;
+	h->hptr = (h->hptr + 1) % LPM_HIST_SAMPLES;
+}
+
 static noinline int lpm_cpu_power_select(struct cpuidle_device *dev, int *index)
 {
+	struct lpm_history *h = &per_cpu(lpm_hist, dev->cpu);
 	int best_level = -1;
 	uint32_t best_level_pwr = ~0U;
 	uint32_t latency_us = pm_qos_request(PM_QOS_CPU_DMA_LATENCY);
@@ -500,6 +690,7 @@ static noinline int lpm_cpu_power_select(struct cpuidle_device *dev, int *index)
 		(uint32_t)(ktime_to_us(tick_nohz_get_sleep_length()));
 	uint32_t modified_time_us = 0;
 	uint32_t next_event_us = 0;
+	uint32_t pred_us = 0;
 	uint32_t power;
 	int i;
 
@@ -509,6 +700,16 @@ static noinline int lpm_cpu_power_select(struct cpuidle_device *dev, int *index)
 	if (!dev->cpu)
 		next_event_us = (uint32_t)(ktime_to_us(get_next_event_time()));
 
+	h->allowed = 0;
+	h->predicted = false;
+	if (lpm_prediction) {
+		pred_us = lpm_cpu_predict(h);
+		if (pred_us && pred_us < sleep_us) {
+			sleep_us = pred_us;
+			h->predicted = true;
+		}
+	}
+
 	for (i = 0; i < sys_state.num_cpu_levels; i++) {
 		struct lpm_cpu_level *level = &sys_state.cpu_level[i];
 		struct power_params *pwr = &level->pwr;
@@ -528,6 +729,8 @@ static noinline int lpm_cpu_power_select(struct cpuidle_device *dev, int *index)
 		if (latency_us < pwr->latency_us)
 			continue;
 
+		h->allowed |= BIT(i);
+
 		if (next_event_us) {
 			if (next_event_us < pwr->latency_us)
 				continue;
@@ -547,14 +750,7 @@ static noinline int lpm_cpu_power_select(struct cpuidle_device *dev, int *index)
 			if (!dev->cpu && msm_rpm_waiting_for_ack())
 					break;
 
-		if ((next_wakeup_us >> 10) > pwr->time_overhead_us) {
-			power = pwr->ss_power;
-		} else {
-			power = pwr->ss_power;
-			power -= (pwr->time_overhead_us * pwr->ss_power)
-					/ next_wakeup_us;
-			power += pwr->energy_overhead / next_wakeup_us;
-		}
+		power = lpm_level_power(pwr, next_wakeup_us);
 
 		if (best_level_pwr >= power) {
 			best_level = i;
@@ -571,6 +767,15 @@ static noinline int lpm_cpu_power_select(struct cpuidle_device *dev, int *index)
 	if (modified_time_us && !dev->cpu)
 		msm_pm_set_timer(modified_time_us);
 
+	/*
+	 * A shallow level picked on the strength of the prediction alone
+	 * would be held for the whole sleep if the prediction is wrong.
+	 * Wake up a little after the predicted time to choose again.
+	 */
+	if (h->predicted && best_level >= 0 &&
+			best_level < sys_state.num_cpu_levels - 1)
+		lpm_pred_timer_start(dev->cpu, pred_us + tmr_add);
+
 	return best_level;
 }
 
@@ -756,6 +961,8 @@ static int lpm_cpuidle_enter(struct cpuidle_device *dev,
 	time = ktime_to_ns(ktime_get()) - time;
 	do_div(time, 1000);
 	dev->last_residency = (int)time;
+	if (!menu_select)
+		lpm_update_history(dev->cpu, idx, (uint32_t)time);
 	local_irq_enable();
 	return idx;
 }
@@ -860,6 +1067,70 @@ static void lpm_cpuidle_init(void)
 		pr_err("%s(): Failed to register CPUIDLE device\n", __func__);
 }
 
+static int lpm_pred_stats_show(struct seq_file *m, void *v)
+{
+	int cpu, i;
+
+	for_each_possible_cpu(cpu) {
+		struct lpm_pred_stats *st = &per_cpu(lpm_pred_stats, cpu);
+
+		seq_printf(m, "cpu%d: predicted %lu pred_timer_wakeups %lu\n",
+				cpu, st->predicted, st->pred_timer_wakeups);
+		for (i = 0; i < sys_state.num_cpu_levels; i++)
+			seq_printf(m,
+				"  %-24s entries %lu too_deep %lu too_shallow %lu\n",
+				sys_state.cpu_level[i].name, st->entries[i],
+				st->too_deep[i], st->too_shallow[i]);
+	}
+	return 0;
+}
+
+static int lpm_pred_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, lpm_pred_stats_show, inode->i_private);
+}
+
+/* Any write clears the counters of all cpus. */
+static ssize_t lpm_pred_stats_write(struct file *file,
+		const char __user *buf, size_t count, loff_t *ppos)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		memset(&per_cpu(lpm_pred_stats, cpu), 0,
+				sizeof(struct lpm_pred_stats));
+	return count;
+}
+
+static const struct file_operations lpm_pred_stats_fops = {
+	.open		= lpm_pred_stats_open,
+	.read		= seq_read,
+	.write		= lpm_pred_stats_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static void lpm_prediction_init(void)
+{
+	struct dentry *dent;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct hrtimer *timer = &per_cpu(lpm_pred_timer, cpu);
+
+		hrtimer_init(timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+		timer->function = lpm_pred_timer_cb;
+	}
+
+	dent = debugfs_create_dir("lpm_levels", NULL);
+	if (IS_ERR_OR_NULL(dent))
+		return;
+
+	if (!debugfs_create_file("prediction", S_IRUGO | S_IWUSR, dent, NULL,
+				&lpm_pred_stats_fops))
+		debugfs_remove(dent);
+}
+
 static int lpm_parse_power_params(struct device_node *node,
 		struct power_params *pwr)
 {
@@ -1095,6 +1366,7 @@ static int lpm_probe(struct platform_device *pdev)
 	platform_device_register(&lpm_dev);
 	suspend_set_ops(&lpm_suspend_ops);
 	hrtimer_init(&lpm_hrtimer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	lpm_prediction_init();
 	lpm_cpuidle_init();
 	return 0;
 fail:
@@ -1,6 +1,9 @@
 #include <linux/string.h>
 #include <asm/page.h>
-void copy_page(void *to, const void *from)
+void copy_page_std(void *to, const void *from)
 {
 	memcpy(to, from, PAGE_SIZE);
 }
+
+void copy_page(void *to, const void *from)
+	__attribute__((weak, alias("copy_page_std")));
@@ -69,4 +69,6 @@
 /* Instruct lower device to use last 4-bytes of skb data as FCS */
 #define SO_NOFCS		43
 
+#define SO_ZEROCOPY		60
+
 #endif /* __ASM_AVR32_SOCKET_H */
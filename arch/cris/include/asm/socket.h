@@ -71,6 +71,8 @@
 /* Instruct lower device to use last 4-bytes of skb data as FCS */
 #define SO_NOFCS		43
 
+#define SO_ZEROCOPY		60
+
 #endif /* _ASM_SOCKET_H */
 
 
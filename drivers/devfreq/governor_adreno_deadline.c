@@ -0,0 +1,422 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+#include <linux/debugfs.h>
+#include <linux/devfreq.h>
+#include <linux/errno.h>
+#include <linux/math64.h>
+#include <linux/module.h>
+#include <linux/msm_adreno_devfreq.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include "governor.h"
+
+/*
+ * Frame deadline governor for the Adreno GPU.
+ *
+ * kgsl reports the GPU time of every frame that ends with an
+ * END_OF_FRAME command batch. The GPU cycles of the next frame are
+ * predicted from the recent ones, and the GPU runs at the lowest
+ * frequency that gets through them within the vsync period, less some
+ * headroom. A frame heavier than the prediction raises it at once, a
+ * lighter one only lowers it gradually.
+ *
+ * Work that does not come in frames falls back on the load: when no frame
+ * has been seen for IDLE_VSYNCS vsync periods, the GPU runs at the lowest
+ * frequency that keeps it busy less than LOAD_TARGET percent of the time.
+ */
+
+#define DEVFREQ_ADRENO_DEADLINE	"adreno-deadline"
+#define TAG "adreno_deadline: "
+
+#define DEF_VSYNC_US		16667
+#define DEF_HEADROOM		10
+#define IDLE_VSYNCS		2
+#define LOAD_TARGET		90
+
+/* Slack histogram buckets of 1 msec, from -SLACK_NEG msec up */
+#define SLACK_BUCKET_US		1000
+#define SLACK_BUCKETS		32
+#define SLACK_NEG		8
+
+static unsigned int vsync_us = DEF_VSYNC_US;
+static unsigned int headroom = DEF_HEADROOM;
+
+struct deadline_data {
+	struct notifier_block nb;
+	struct devfreq *devfreq;
+	struct dentry *slack_file;
+	/* predicted cycles of the next frame */
+	u64 predict;
+	bool frame_pending;
+	/* usecs since the last frame, and the load over them */
+	u64 since_frame;
+	u64 total_time;
+	u64 busy_time;
+	unsigned int frames;
+	unsigned int missed;
+	unsigned int slack[MSM_ADRENO_MAX_PWRLEVELS][SLACK_BUCKETS];
+};
+
+static struct dentry *deadline_debugfs;
+
+/* The lowest frequency that does cycles in usecs */
+static unsigned long deadline_freq(struct devfreq *devfreq, u64 cycles,
+				   unsigned int usecs)
+{
+	struct devfreq_dev_profile *profile = devfreq->profile;
+	u64 freq = div_u64(cycles * USEC_PER_SEC, max(usecs, 1U));
+	int i;
+
+	for (i = profile->max_state - 1; i > 0; i--)
+		if (profile->freq_table[i] >= freq)
+			break;
+	return profile->freq_table[i];
+}
+
+static void deadline_frame(struct deadline_data *priv,
+			   struct adreno_frame_stats *frame)
+{
+	s64 slack = (s64)vsync_us - (frame->end - frame->start);
+	int level, bucket;
+	u64 cycles;
+
+	level = devfreq_get_freq_level(priv->devfreq, frame->freq);
+	if (level >= 0 && level < MSM_ADRENO_MAX_PWRLEVELS) {
+		if (slack < 0)
+			bucket = SLACK_NEG - 1 -
+				div_s64(-slack - 1, SLACK_BUCKET_US);
+		else
+			bucket = SLACK_NEG + div_s64(slack, SLACK_BUCKET_US);
+		bucket = clamp(bucket, 0, SLACK_BUCKETS - 1);
+		priv->slack[level][bucket]++;
+	}
+	priv->frames++;
+	if (slack < 0)
+		priv->missed++;
+
+	cycles = div_u64((u64)max_t(s64, frame->busy, 0) * frame->freq,
+			 USEC_PER_SEC);
+	priv->predict = max(cycles, (3 * priv->predict + cycles) / 4);
+	priv->frame_pending = true;
+	priv->since_frame = 0;
+	priv->total_time = 0;
+	priv->busy_time = 0;
+}
+
+static int deadline_get_target_freq(struct devfreq *devfreq,
+				    unsigned long *freq, u32 *flag)
+{
+	struct deadline_data *priv = devfreq->data;
+	struct devfreq_dev_status stats;
+	u64 cycles;
+	int result;
+
+	stats.private_data = NULL;
+	result = devfreq->profile->get_dev_status(devfreq->dev.parent, &stats);
+	if (result) {
+		pr_err(TAG "get_status failed %d\n", result);
+		return result;
+	}
+
+	*freq = stats.current_frequency;
+	*flag = 0;
+	priv->since_frame += stats.total_time;
+	priv->total_time += stats.total_time;
+	priv->busy_time += stats.busy_time;
+
+	if (priv->frame_pending) {
+		priv->frame_pending = false;
+		*freq = deadline_freq(devfreq, priv->predict,
+				      vsync_us * (100 - headroom) / 100);
+		return 0;
+	}
+
+	if (priv->since_frame < IDLE_VSYNCS * vsync_us ||
+	    priv->total_time < vsync_us)
+		return 0;
+
+	/*
+	 * No frames: the cycles a second of the recent load needs, to be
+	 * done in LOAD_TARGET percent of a second
+	 */
+	cycles = div64_u64(priv->busy_time * stats.current_frequency,
+			   priv->total_time);
+	*freq = deadline_freq(devfreq, cycles,
+			      LOAD_TARGET * USEC_PER_SEC / 100);
+	priv->total_time = 0;
+	priv->busy_time = 0;
+	return 0;
+}
+
+static int deadline_notify(struct notifier_block *nb, unsigned long type,
+			   void *data)
+{
+	struct deadline_data *priv = container_of(nb, struct deadline_data, nb);
+	struct devfreq *devfreq = priv->devfreq;
+	int result = 0;
+
+	switch (type) {
+	case ADRENO_DEVFREQ_NOTIFY_FRAME:
+	case ADRENO_DEVFREQ_NOTIFY_IDLE:
+	case ADRENO_DEVFREQ_NOTIFY_RETIRE:
+		mutex_lock(&devfreq->lock);
+		if (type == ADRENO_DEVFREQ_NOTIFY_FRAME)
+			deadline_frame(priv, data);
+		result = update_devfreq(devfreq);
+		mutex_unlock(&devfreq->lock);
+		break;
+	/* ignored by this governor */
+	case ADRENO_DEVFREQ_NOTIFY_SUBMIT:
+	default:
+		break;
+	}
+	return notifier_from_errno(result);
+}
+
+static int deadline_slack_show(struct seq_file *s, void *unused)
+{
+	struct deadline_data *priv = s->private;
+	struct devfreq_dev_profile *profile = priv->devfreq->profile;
+	int i, j;
+
+	seq_printf(s, "frames %u missed %u\n", priv->frames, priv->missed);
+	seq_puts(s, "slack_ms:");
+	for (j = 0; j < SLACK_BUCKETS; j++)
+		seq_printf(s, " %d", j - SLACK_NEG);
+	seq_putc(s, '\n');
+
+	for (i = 0; i < profile->max_state; i++) {
+		seq_printf(s, "%u:", profile->freq_table[i]);
+		for (j = 0; j < SLACK_BUCKETS; j++)
+			seq_printf(s, " %u", priv->slack[i][j]);
+		seq_putc(s, '\n');
+	}
+	return 0;
+}
+
+static int deadline_slack_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, deadline_slack_show, inode->i_private);
+}
+
+/* Writing anything clears the histograms */
+static ssize_t deadline_slack_write(struct file *file,
+				    const char __user *buf, size_t count,
+				    loff_t *ppos)
+{
+	struct deadline_data *priv =
+		((struct seq_file *)file->private_data)->private;
+	struct devfreq *devfreq = priv->devfreq;
+
+	mutex_lock(&devfreq->lock);
+	priv->frames = 0;
+	priv->missed = 0;
+	memset(priv->slack, 0, sizeof(priv->slack));
+	mutex_unlock(&devfreq->lock);
+	return count;
+}
+
+static const struct file_operations deadline_slack_fops = {
+	.open = deadline_slack_open,
+	.read = seq_read,
+	.write = deadline_slack_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int deadline_start(struct devfreq *devfreq)
+{
+	struct deadline_data *priv;
+	int ret;
+
+	if (devfreq->profile->max_state > MSM_ADRENO_MAX_PWRLEVELS) {
+		pr_err(TAG "too many power levels\n");
+		return -EINVAL;
+	}
+
+	priv = kzalloc(sizeof(*priv), GFP_KERNEL);
+	if (priv == NULL)
+		return -ENOMEM;
+
+	priv->devfreq = devfreq;
+	priv->nb.notifier_call = deadline_notify;
+	devfreq->data = priv;
+
+	ret = kgsl_devfreq_add_notifier(devfreq->dev.parent, &priv->nb);
+	if (ret) {
+		devfreq->data = NULL;
+		kfree(priv);
+		return ret;
+	}
+
+	if (deadline_debugfs)
+		priv->slack_file = debugfs_create_file("slack", 0644,
+				deadline_debugfs, priv, &deadline_slack_fops);
+	return 0;
+}
+
+static int deadline_stop(struct devfreq *devfreq)
+{
+	struct deadline_data *priv = devfreq->data;
+
+	kgsl_devfreq_del_notifier(devfreq->dev.parent, &priv->nb);
+	debugfs_remove(priv->slack_file);
+	devfreq->data = NULL;
+	kfree(priv);
+	return 0;
+}
+
+static int deadline_suspend(struct devfreq *devfreq)
+{
+	struct deadline_data *priv = devfreq->data;
+
+	priv->frame_pending = false;
+	priv->since_frame = 0;
+	priv->total_time = 0;
+	priv->busy_time = 0;
+	return 0;
+}
+
+static int deadline_resume(struct devfreq *devfreq)
+{
+	struct devfreq_dev_profile *profile = devfreq->profile;
+	unsigned long freq;
+
+	freq = profile->initial_freq;
+
+	return profile->target(devfreq->dev.parent, &freq, 0);
+}
+
+static ssize_t deadline_vsync_us_show(struct kobject *kobj,
+				      struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", vsync_us);
+}
+
+static ssize_t deadline_vsync_us_store(struct kobject *kobj,
+				       struct kobj_attribute *attr,
+				       const char *buf, size_t count)
+{
+	unsigned int val;
+
+	if (sscanf(buf, "%u", &val) != 1 || val < 1000 || val > 1000000)
+		return -EINVAL;
+
+	vsync_us = val;
+
+	return count;
+}
+
+static ssize_t deadline_headroom_show(struct kobject *kobj,
+				      struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", headroom);
+}
+
+static ssize_t deadline_headroom_store(struct kobject *kobj,
+				       struct kobj_attribute *attr,
+				       const char *buf, size_t count)
+{
+	unsigned int val;
+
+	if (sscanf(buf, "%u", &val) != 1 || val > 90)
+		return -EINVAL;
+
+	headroom = val;
+
+	return count;
+}
+
+static struct kobj_attribute vsync_us_attribute =
+	__ATTR(vsync_us, 0664, deadline_vsync_us_show,
+	       deadline_vsync_us_store);
+static struct kobj_attribute headroom_attribute =
+	__ATTR(headroom, 0664, deadline_headroom_show,
+	       deadline_headroom_store);
+
+static struct attribute *attrs[] = {
+	&vsync_us_attribute.attr,
+	&headroom_attribute.attr,
+	NULL,
+};
+
+static struct attribute_group attr_group = {
+	.attrs = attrs,
+	.name = DEVFREQ_ADRENO_DEADLINE,
+};
+
+static int deadline_handler(struct devfreq *devfreq, unsigned int event,
+			    void *data)
+{
+	int result;
+	BUG_ON(devfreq == NULL);
+
+	switch (event) {
+	case DEVFREQ_GOV_START:
+		result = deadline_start(devfreq);
+		if (!result)
+			result = devfreq_policy_add_files(devfreq, attr_group);
+		break;
+
+	case DEVFREQ_GOV_STOP:
+		devfreq_policy_remove_files(devfreq, attr_group);
+		result = deadline_stop(devfreq);
+		break;
+
+	case DEVFREQ_GOV_SUSPEND:
+		result = deadline_suspend(devfreq);
+		break;
+
+	case DEVFREQ_GOV_RESUME:
+		result = deadline_resume(devfreq);
+		break;
+
+	case DEVFREQ_GOV_INTERVAL:
+		/* ignored, this governor doesn't use polling */
+	default:
+		result = 0;
+		break;
+	}
+
+	return result;
+}
+
+static struct devfreq_governor adreno_deadline = {
+	.name = DEVFREQ_ADRENO_DEADLINE,
+	.get_target_freq = deadline_get_target_freq,
+	.event_handler = deadline_handler,
+};
+
+static int __init adreno_deadline_init(void)
+{
+	deadline_debugfs = debugfs_create_dir(DEVFREQ_ADRENO_DEADLINE, NULL);
+	if (IS_ERR(deadline_debugfs))
+		deadline_debugfs = NULL;
+
+	return devfreq_add_governor(&adreno_deadline);
+}
+subsys_initcall(adreno_deadline_init);
+
+static void __exit adreno_deadline_exit(void)
+{
+	int ret;
+
+	ret = devfreq_remove_governor(&adreno_deadline);
+	if (ret)
+		pr_err(TAG "failed to remove governor %d\n", ret);
+
+	debugfs_remove_recursive(deadline_debugfs);
+}
+module_exit(adreno_deadline_exit);
+
+MODULE_LICENSE("GPL v2");
@@ -104,6 +104,7 @@ void *ion_page_pool_alloc(struct ion_page_pool *pool, bool *from_pool)
 	}
 	return page;
 }
+EXPORT_SYMBOL(ion_page_pool_alloc);
 
 void ion_page_pool_free(struct ion_page_pool *pool, struct page* page)
 {
@@ -113,6 +114,7 @@ void ion_page_pool_free(struct ion_page_pool *pool, struct page* page)
 	if (ret)
 		ion_page_pool_free_pages(pool, page);
 }
+EXPORT_SYMBOL(ion_page_pool_free);
 
 static int ion_page_pool_total(struct ion_page_pool *pool, bool high)
 {
@@ -158,6 +160,7 @@ int ion_page_pool_shrink(struct ion_page_pool *pool, gfp_t gfp_mask,
 
 	return nr_freed;
 }
+EXPORT_SYMBOL(ion_page_pool_shrink);
 
 struct ion_page_pool *ion_page_pool_create(gfp_t gfp_mask, unsigned int order)
 {
@@ -176,11 +179,13 @@ struct ion_page_pool *ion_page_pool_create(gfp_t gfp_mask, unsigned int order)
 
 	return pool;
 }
+EXPORT_SYMBOL(ion_page_pool_create);
 
 void ion_page_pool_destroy(struct ion_page_pool *pool)
 {
 	kfree(pool);
 }
+EXPORT_SYMBOL(ion_page_pool_destroy);
 
 static int __init ion_page_pool_init(void)
 {
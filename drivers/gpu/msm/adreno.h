@@ -132,6 +132,10 @@ enum coresight_debug_reg {
  * submitted operation
  * @work: work_struct to put the dispatcher in a work queue
  * @kobj: kobject for the dispatcher directory in the device sysfs node
+ * @frame_start: Time in usecs the GPU started on the current frame, 0 if
+ * no command batch of the frame has retired yet
+ * @frame_busy: Usecs the GPU has spent on the current frame so far
+ * @last_retire: Time in usecs the last command batch retired
  */
 struct adreno_dispatcher {
 	struct mutex mutex;
@@ -147,6 +151,9 @@ struct adreno_dispatcher {
 	unsigned int tail;
 	struct work_struct work;
 	struct kobject kobj;
+	s64 frame_start;
+	s64 frame_busy;
+	s64 last_retire;
 };
 
 enum adreno_dispatcher_flags {
@@ -1803,6 +1803,7 @@ static void a2xx_cp_intrcallback(struct kgsl_device *device)
 	kgsl_regwrite(device, REG_CP_INT_ACK, status);
 
 	if (status & (CP_INT_CNTL__IB1_INT_MASK | CP_INT_CNTL__RB_INT_MASK)) {
+		kgsl_wake_waiters(device);
 		queue_work(device->work_queue, &device->ts_expired_ws);
 		adreno_dispatcher_schedule(device);
 	}
@@ -31,9 +31,18 @@ static unsigned int _context_cmdqueue_size = 50;
 /* Number of milliseconds to wait for the context queue to clear */
 static unsigned int _context_queue_wait = 10000;
 
-/* Number of command batches sent at a time from a single context */
+/*
+ * Number of command batches sent at a time from a context of the default
+ * priority, see _context_burst()
+ */
 static unsigned int _context_cmdbatch_burst = 5;
 
+/*
+ * Stop a burst between command batches when a more urgent context has
+ * commands pending
+ */
+static unsigned int _dispatcher_yield = 1;
+
 /*
  * GFT throttle parameters. If GFT recovered more than
  * X times in Y ms invalidate the context and do not attempt recovery.
@@ -43,7 +52,10 @@ static unsigned int _context_cmdbatch_burst = 5;
 static unsigned int _fault_throttle_time = 3000;
 static unsigned int _fault_throttle_burst = 3;
 
-/* Number of command batches inflight in the ringbuffer at any time */
+/*
+ * Number of command batches inflight in the ringbuffer at any time.  Contexts
+ * below the default priority only get part of it, see _context_inflight()
+ */
 static unsigned int _dispatcher_inflight = 15;
 
 /* Command batch timeout (in milliseconds) */
@@ -276,6 +288,68 @@ static inline int adreno_dispatcher_requeue_cmdbatch(
 	return 0;
 }
 
+/*
+ * Scale a per-context limit by the priority of the context: the default
+ * priority gets the limit as it is, the most urgent priority nearly twice
+ * as much and the least urgent one an eighth of it, but never nothing
+ */
+static inline unsigned int _priority_scale(struct adreno_context *drawctxt,
+		unsigned int limit)
+{
+	unsigned int levels = ADRENO_CONTEXT_MAX_PRIORITY + 1;
+
+	return max_t(unsigned int, 1,
+		DIV_ROUND_UP(limit * (levels - drawctxt->pending.prio),
+			levels - ADRENO_CONTEXT_DEFAULT_PRIORITY));
+}
+
+/* Number of command batches the context may send in one burst */
+static inline unsigned int _context_burst(struct adreno_context *drawctxt)
+{
+	return _priority_scale(drawctxt, _context_cmdbatch_burst);
+}
+
+/*
+ * Number of command batches that may be inflight when the context sends
+ * another one.  A background context keeps the ringbuffer short so that
+ * a more urgent command doesn't have to wait behind a long queue.
+ */
+static inline unsigned int _context_inflight(struct adreno_context *drawctxt)
+{
+	return min(_dispatcher_inflight,
+		_priority_scale(drawctxt, _dispatcher_inflight));
+}
+
+/**
+ * dispatcher_yield() - Check for a more urgent context
+ * @dispatcher: Pointer to the adreno dispatcher struct
+ * @drawctxt: Pointer to the context currently sending commands
+ *
+ * Return true if a context with a higher priority than @drawctxt is waiting
+ * on the pending list and the current burst should end.
+ */
+static bool dispatcher_yield(struct adreno_dispatcher *dispatcher,
+		struct adreno_context *drawctxt)
+{
+	struct adreno_context *first;
+	bool ret = false;
+
+	if (!_dispatcher_yield)
+		return false;
+
+	spin_lock(&dispatcher->plist_lock);
+
+	if (!plist_head_empty(&dispatcher->pending)) {
+		first = plist_first_entry(&dispatcher->pending,
+			struct adreno_context, pending);
+		ret = first->pending.prio < drawctxt->pending.prio;
+	}
+
+	spin_unlock(&dispatcher->plist_lock);
+
+	return ret;
+}
+
 /**
  * dispatcher_queue_context() - Queue a context in the dispatcher pending list
  * @dispatcher: Pointer to the adreno dispatcher struct
@@ -336,6 +410,7 @@ static int sendcmd(struct adreno_device *adreno_dev,
 		set_bit(ADRENO_DISPATCHER_POWER, &dispatcher->priv);
 	}
 
+	cmdbatch->submitted = ktime_to_us(ktime_get());
 	ret = adreno_ringbuffer_submitcmd(adreno_dev, cmdbatch);
 
 	/*
@@ -362,6 +437,8 @@ static int sendcmd(struct adreno_device *adreno_dev,
 	}
 
 	trace_adreno_cmdbatch_submitted(cmdbatch, dispatcher->inflight);
+	trace_adreno_cmdbatch_queue_wait(cmdbatch,
+		ADRENO_CONTEXT(cmdbatch->context)->pending.prio);
 
 	dispatcher->cmdqueue[dispatcher->tail] = cmdbatch;
 	dispatcher->tail = (dispatcher->tail + 1) %
@@ -404,12 +481,14 @@ static int dispatcher_context_sendcmds(struct adreno_device *adreno_dev,
 	int count = 0;
 	int requeued = 0;
 	unsigned int timestamp;
+	unsigned int burst = _context_burst(drawctxt);
+	unsigned int inflight = _context_inflight(drawctxt);
 
 	/*
-	 * Each context can send a specific number of command batches per cycle
+	 * Each context can send a number of command batches per cycle that
+	 * depends on its priority
 	 */
-	while ((count < _context_cmdbatch_burst) &&
-		(dispatcher->inflight < _dispatcher_inflight)) {
+	while ((count < burst) && (dispatcher->inflight < inflight)) {
 		int ret;
 		struct kgsl_cmdbatch *cmdbatch;
 
@@ -466,6 +545,14 @@ static int dispatcher_context_sendcmds(struct adreno_device *adreno_dev,
 		drawctxt->submitted_timestamp = timestamp;
 
 		count++;
+
+		/*
+		 * A more urgent context got commands while we were busy - let
+		 * it go ahead at this command batch boundary and put this
+		 * context back on the pending list behind it
+		 */
+		if (dispatcher_yield(dispatcher, drawctxt))
+			break;
 	}
 
 	/*
@@ -532,7 +619,14 @@ static int _adreno_dispatcher_issuecmds(struct adreno_device *adreno_dev)
 			continue;
 		}
 
-		ret = dispatcher_context_sendcmds(adreno_dev, drawctxt);
+		/*
+		 * If the context already has as many commands inflight as its
+		 * priority allows then leave it pending until some retire
+		 */
+		if (dispatcher->inflight >= _context_inflight(drawctxt))
+			ret = 1;
+		else
+			ret = dispatcher_context_sendcmds(adreno_dev, drawctxt);
 
 		if (ret > 0) {
 			spin_lock(&dispatcher->plist_lock);
@@ -741,6 +835,7 @@ int adreno_dispatcher_queue_cmd(struct adreno_device *adreno_dev,
 		cmdbatch->fault_policy = adreno_dev->ft_policy;
 
 	/* Put the command into the queue */
+	cmdbatch->queued = ktime_to_us(ktime_get());
 	drawctxt->cmdqueue[drawctxt->cmdqueue_tail] = cmdbatch;
 	drawctxt->cmdqueue_tail = (drawctxt->cmdqueue_tail + 1) %
 		ADRENO_CONTEXT_CMDQUEUE_SIZE;
@@ -1397,6 +1492,37 @@ static void _print_recovery(struct kgsl_device *device,
 		cmdbatch->fault_recovery);
 }
 
+/**
+ * _retire_frame_timing() - Account a retired command batch to its frame
+ * @adreno_dev: Pointer to an adreno_device struct
+ * @cmdbatch: Pointer to the command batch that just retired
+ *
+ * The GPU runs the command batches in order, so a batch started when it was
+ * submitted or when the one before it retired, whichever came last. Its time
+ * goes to the current frame. A batch submitted with KGSL_CONTEXT_END_OF_FRAME
+ * ends the frame, which is reported to the devfreq governor.
+ */
+static void _retire_frame_timing(struct adreno_device *adreno_dev,
+	struct kgsl_cmdbatch *cmdbatch)
+{
+	struct adreno_dispatcher *dispatcher = &adreno_dev->dispatcher;
+	s64 now = ktime_to_us(ktime_get());
+	s64 start = max(cmdbatch->submitted, dispatcher->last_retire);
+
+	if (dispatcher->frame_start == 0)
+		dispatcher->frame_start = start;
+	if (now > start)
+		dispatcher->frame_busy += now - start;
+	dispatcher->last_retire = now;
+
+	if (cmdbatch->flags & KGSL_CONTEXT_END_OF_FRAME) {
+		kgsl_pwrscale_frame(&adreno_dev->dev, dispatcher->frame_start,
+			now, dispatcher->frame_busy);
+		dispatcher->frame_start = 0;
+		dispatcher->frame_busy = 0;
+	}
+}
+
 /**
  * adreno_dispatcher_work() - Master work handler for the dispatcher
  * @work: Pointer to the work struct for the current work queue
@@ -1455,6 +1581,8 @@ static void adreno_dispatcher_work(struct work_struct *work)
 			trace_adreno_cmdbatch_retired(cmdbatch,
 				dispatcher->inflight - 1);
 
+			_retire_frame_timing(adreno_dev, cmdbatch);
+
 			/* Reduce the number of inflight command batches */
 			dispatcher->inflight--;
 
@@ -1543,6 +1671,7 @@ static void adreno_dispatcher_work(struct work_struct *work)
 	 * stragglers
 	 */
 	if (dispatcher->inflight == 0 && count) {
+		kgsl_wake_waiters(device);
 		kgsl_mutex_lock(&device->mutex, &device->mutex_owner);
 		queue_work(device->work_queue, &device->ts_expired_ws);
 		kgsl_mutex_unlock(&device->mutex, &device->mutex_owner);
@@ -1758,6 +1887,14 @@ struct dispatcher_attribute {
 		.value = &(_value), \
 	}
 
+#define DISPATCHER_BOOL_ATTR(_name, _mode, _value) \
+	struct dispatcher_attribute dispatcher_attr_##_name =  { \
+		.attr = { .name = __stringify(_name), .mode = _mode }, \
+		.show = _show_uint, \
+		.store = _store_bool, \
+		.value = &(_value), \
+	}
+
 #define to_dispatcher_attr(_a) \
 	container_of((_a), struct dispatcher_attribute, attr)
 #define to_dispatcher(k) container_of(k, struct adreno_dispatcher, kobj)
@@ -1780,6 +1917,21 @@ static ssize_t _store_uint(struct adreno_dispatcher *dispatcher,
 	return size;
 }
 
+static ssize_t _store_bool(struct adreno_dispatcher *dispatcher,
+		struct dispatcher_attribute *attr,
+		const char *buf, size_t size)
+{
+	unsigned int val = 0;
+	int ret;
+
+	ret = kgsl_sysfs_store(buf, 0, &val);
+	if (ret)
+		return ret;
+
+	*((unsigned int *) attr->value) = val ? 1 : 0;
+	return size;
+}
+
 static ssize_t _show_uint(struct adreno_dispatcher *dispatcher,
 		struct dispatcher_attribute *attr,
 		char *buf)
@@ -1800,6 +1952,7 @@ static DISPATCHER_UINT_ATTR(context_cmdqueue_size, 0644,
 	ADRENO_CONTEXT_CMDQUEUE_SIZE - 1, _context_cmdqueue_size);
 static DISPATCHER_UINT_ATTR(context_burst_count, 0644, 0,
 	_context_cmdbatch_burst);
+static DISPATCHER_BOOL_ATTR(yield, 0644, _dispatcher_yield);
 static DISPATCHER_UINT_ATTR(cmdbatch_timeout, 0644, 0, _cmdbatch_timeout);
 static DISPATCHER_UINT_ATTR(context_queue_wait, 0644, 0, _context_queue_wait);
 static DISPATCHER_UINT_ATTR(fault_detect_interval, 0644, 0,
@@ -1813,6 +1966,7 @@ static struct attribute *dispatcher_attrs[] = {
 	&dispatcher_attr_inflight.attr,
 	&dispatcher_attr_context_cmdqueue_size.attr,
 	&dispatcher_attr_context_burst_count.attr,
+	&dispatcher_attr_yield.attr,
 	&dispatcher_attr_cmdbatch_timeout.attr,
 	&dispatcher_attr_context_queue_wait.attr,
 	&dispatcher_attr_fault_detect_interval.attr,
@@ -134,28 +134,13 @@ void build_quad_vtxbuff(struct adreno_context *drawctxt,
 	*incmd = cmd;
 }
 
-static void wait_callback(struct kgsl_device *device, void *priv, u32 id,
-		u32 timestamp, u32 type)
+/* Stop waiting for a timestamp if the drawctxt got invalidated or destroyed */
+static bool _context_wait_abort(struct kgsl_context *context)
 {
-	struct adreno_context *drawctxt = priv;
-	wake_up_all(&drawctxt->waiting);
-}
-
-static int _check_context_timestamp(struct kgsl_device *device,
-		struct adreno_context *drawctxt, unsigned int timestamp)
-{
-	int ret = 0;
-
-	/* Bail if the drawctxt has been invalidated or destroyed */
-	if (kgsl_context_detached(&drawctxt->base) ||
-		drawctxt->state != ADRENO_CONTEXT_STATE_ACTIVE)
-		return 1;
-
-	kgsl_mutex_lock(&device->mutex, &device->mutex_owner);
-	ret = kgsl_check_timestamp(device, &drawctxt->base, timestamp);
-	kgsl_mutex_unlock(&device->mutex, &device->mutex_owner);
+	struct adreno_context *drawctxt = ADRENO_CONTEXT(context);
 
-	return ret;
+	return kgsl_context_detached(context) ||
+		drawctxt->state != ADRENO_CONTEXT_STATE_ACTIVE;
 }
 
 /**
@@ -213,11 +198,11 @@ done:
  * @adreno_dev: pointer to the adreno_device struct
  * @drawctxt: Pointer to the draw context to sleep for
  * @timetamp: Timestamp to wait on
- * @timeout: Number of jiffies to wait (0 for infinite)
+ * @timeout: Number of milliseconds to wait (0 for infinite)
  *
- * Register an event to wait for a timestamp on a context and sleep until it
- * has past.  Returns < 0 on error, -ETIMEDOUT if the timeout expires or 0
- * on success
+ * Sleep until the timestamp has passed without holding the device mutex,
+ * see kgsl_wait_timestamp().  Returns < 0 on error, -ETIMEDOUT if the
+ * timeout expires or 0 on success
  */
 int adreno_drawctxt_wait(struct adreno_device *adreno_dev,
 		struct kgsl_context *context,
@@ -225,8 +210,8 @@ int adreno_drawctxt_wait(struct adreno_device *adreno_dev,
 {
 	struct kgsl_device *device = &adreno_dev->dev;
 	struct adreno_context *drawctxt = ADRENO_CONTEXT(context);
-	int ret;
-	long ret_temp;
+	unsigned int queued;
+	int ret = 0;
 
 	if (kgsl_context_detached(context))
 		return -EINVAL;
@@ -234,46 +219,32 @@ int adreno_drawctxt_wait(struct adreno_device *adreno_dev,
 	if (drawctxt->state == ADRENO_CONTEXT_STATE_INVALID)
 		return -EDEADLK;
 
-	/* Needs to hold the device mutex */
-	BUG_ON(!mutex_is_locked(&device->mutex));
-
 	trace_adreno_drawctxt_wait_start(context->id, timestamp);
 
-	ret = kgsl_add_event(device, context->id, timestamp,
-		wait_callback, drawctxt, NULL);
-	if (ret)
-		goto done;
-
-	kgsl_mutex_unlock(&device->mutex, &device->mutex_owner);
-
-	if (timeout) {
-		long ret_temp;
-		ret_temp = msecs_to_jiffies(timeout);
-		__wait_event_interruptible_timeout(
-			drawctxt->waiting,
-			_check_context_timestamp(device, drawctxt, timestamp),
-			ret_temp);
-
-		if (ret_temp == 0)
-			ret = -ETIMEDOUT;
-		else if (ret_temp > 0)
-			ret = 0;
-		else
-			ret = (int) ret_temp;
-	} else {
-		__wait_event_interruptible(drawctxt->waiting,
-			_check_context_timestamp(device, drawctxt, timestamp),
-				ret_temp);
-		ret = (int)ret_temp;
+	/*
+	 * Unless the context makes up its own timestamps only allow waiting
+	 * for timestamps that have been queued.  The queued timestamp is
+	 * guarded by the device mutex, which is held just for the read.
+	 */
+	if (!(context->flags & KGSL_CONTEXT_USER_GENERATED_TS)) {
+		kgsl_mutex_lock(&device->mutex, &device->mutex_owner);
+		queued = kgsl_readtimestamp(device, context,
+			KGSL_TIMESTAMP_QUEUED);
+		kgsl_mutex_unlock(&device->mutex, &device->mutex_owner);
+
+		if (timestamp_cmp(timestamp, queued) > 0) {
+			ret = -EINVAL;
+			goto done;
+		}
 	}
 
-	kgsl_mutex_lock(&device->mutex, &device->mutex_owner);
+	ret = kgsl_wait_timestamp(device, context, timestamp,
+		msecs_to_jiffies(timeout), _context_wait_abort);
 
 	/* -EDEADLK if the context was invalidated while we were waiting */
 	if (drawctxt->state == ADRENO_CONTEXT_STATE_INVALID)
 		ret = -EDEADLK;
 
-
 	/* Return -EINVAL if the context was detached while we were waiting */
 	if (kgsl_context_detached(context))
 		ret = -EINVAL;
@@ -404,6 +375,7 @@ void adreno_drawctxt_invalidate(struct kgsl_device *device,
 	spin_unlock(&drawctxt->lock);
 
 	/* Give the bad news to everybody waiting around */
+	wake_up_all(&context->ts_waitq);
 	wake_up_all(&drawctxt->waiting);
 	wake_up_all(&drawctxt->wq);
 }
@@ -422,6 +394,7 @@ adreno_drawctxt_create(struct kgsl_device_private *dev_priv,
 	struct adreno_context *drawctxt;
 	struct kgsl_device *device = dev_priv->device;
 	struct adreno_device *adreno_dev = ADRENO_DEVICE(device);
+	unsigned int priority;
 	int ret;
 
 	drawctxt = kzalloc(sizeof(struct adreno_context), GFP_KERNEL);
@@ -444,6 +417,7 @@ adreno_drawctxt_create(struct kgsl_device_private *dev_priv,
 		KGSL_CONTEXT_USER_GENERATED_TS |
 		KGSL_CONTEXT_NO_FAULT_TOLERANCE |
 		KGSL_CONTEXT_TYPE_MASK |
+		KGSL_CONTEXT_PRIORITY_MASK |
 		KGSL_CONTEXT_PWR_CONSTRAINT);
 
 	/* Always enable per-context timestamps */
@@ -455,12 +429,16 @@ adreno_drawctxt_create(struct kgsl_device_private *dev_priv,
 	init_waitqueue_head(&drawctxt->waiting);
 
 	/*
-	 * Set up the plist node for the dispatcher.  For now all contexts have
-	 * the same priority, but later the priority will be set at create time
-	 * by the user
+	 * Set up the plist node for the dispatcher with the priority the user
+	 * asked for, or the default one if it didn't
 	 */
 
-	plist_node_init(&drawctxt->pending, ADRENO_CONTEXT_DEFAULT_PRIORITY);
+	priority = (drawctxt->base.flags & KGSL_CONTEXT_PRIORITY_MASK) >>
+		KGSL_CONTEXT_PRIORITY_SHIFT;
+	if (priority == KGSL_CONTEXT_PRIORITY_UNDEF)
+		priority = ADRENO_CONTEXT_DEFAULT_PRIORITY;
+
+	plist_node_init(&drawctxt->pending, priority);
 
 	if (adreno_dev->gpudev->ctxt_create) {
 		ret = adreno_dev->gpudev->ctxt_create(adreno_dev, drawctxt);
@@ -597,6 +575,7 @@ int adreno_drawctxt_detach(struct kgsl_context *context)
 		drawctxt->ops->detach(drawctxt);
 
 	/* wake threads waiting to submit commands from this context */
+	wake_up_all(&context->ts_waitq);
 	wake_up_all(&drawctxt->waiting);
 	wake_up_all(&drawctxt->wq);
 
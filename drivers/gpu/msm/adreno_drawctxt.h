@@ -33,7 +33,9 @@ struct adreno_context_type {
 
 #define ADRENO_CONTEXT_CMDQUEUE_SIZE 128
 
-#define ADRENO_CONTEXT_DEFAULT_PRIORITY 1
+/* Dispatcher priorities, lower is more urgent */
+#define ADRENO_CONTEXT_MAX_PRIORITY 15
+#define ADRENO_CONTEXT_DEFAULT_PRIORITY 8
 
 #define ADRENO_CONTEXT_STATE_ACTIVE 0
 #define ADRENO_CONTEXT_STATE_INVALID 1
@@ -72,6 +72,28 @@ DEFINE_EVENT(adreno_cmdbatch_template, adreno_cmdbatch_submitted,
 	TP_ARGS(cmdbatch, inflight)
 );
 
+TRACE_EVENT(adreno_cmdbatch_queue_wait,
+	TP_PROTO(struct kgsl_cmdbatch *cmdbatch, unsigned int prio),
+	TP_ARGS(cmdbatch, prio),
+	TP_STRUCT__entry(
+		__field(unsigned int, id)
+		__field(unsigned int, timestamp)
+		__field(unsigned int, prio)
+		__field(s64, wait)
+	),
+	TP_fast_assign(
+		__entry->id = cmdbatch->context->id;
+		__entry->timestamp = cmdbatch->timestamp;
+		__entry->prio = prio;
+		__entry->wait = cmdbatch->submitted - cmdbatch->queued;
+	),
+	TP_printk(
+		"ctx=%u ts=%u prio=%u wait_us=%lld",
+			__entry->id, __entry->timestamp, __entry->prio,
+			__entry->wait
+	)
+);
+
 TRACE_EVENT(adreno_cmdbatch_retired,
 	TP_PROTO(struct kgsl_cmdbatch *cmdbatch, int inflight),
 	TP_ARGS(cmdbatch, inflight),
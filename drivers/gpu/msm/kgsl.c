@@ -40,6 +40,7 @@
 #include "kgsl_device.h"
 #include "kgsl_trace.h"
 #include "kgsl_sync.h"
+#include "kgsl_pool.h"
 #include "adreno.h"
 
 #undef MODULE_PARAM_PREFIX
@@ -575,6 +576,10 @@ int kgsl_context_init(struct kgsl_device_private *dev_priv,
 	 */
 
 	INIT_LIST_HEAD(&context->events_list);
+
+	/* Timestamp waiters sleep on the context, see kgsl_wait_timestamp() */
+	init_waitqueue_head(&context->ts_waitq);
+	INIT_LIST_HEAD(&context->waiters_list);
 	return 0;
 fail_free_id:
 	write_lock(&device->context_lock);
@@ -1516,14 +1521,9 @@ static long kgsl_ioctl_device_waittimestamp(struct kgsl_device_private
 						void *data)
 {
 	struct kgsl_device_waittimestamp *param = data;
-	struct kgsl_device *device = dev_priv->device;
-	long result = -EINVAL;
 
-	kgsl_mutex_lock(&device->mutex, &device->mutex_owner);
-	result = _device_waittimestamp(dev_priv, NULL,
+	return _device_waittimestamp(dev_priv, NULL,
 			param->timestamp, param->timeout);
-	kgsl_mutex_unlock(&device->mutex, &device->mutex_owner);
-	return result;
 }
 
 static long kgsl_ioctl_device_waittimestamp_ctxtid(struct kgsl_device_private
@@ -1532,10 +1532,12 @@ static long kgsl_ioctl_device_waittimestamp_ctxtid(struct kgsl_device_private
 {
 	struct kgsl_device_waittimestamp_ctxtid *param = data;
 	struct kgsl_context *context;
-	struct kgsl_device *device = dev_priv->device;
 	long result = -EINVAL;
 
-	kgsl_mutex_lock(&device->mutex, &device->mutex_owner);
+	/*
+	 * The wait doesn't take the device mutex so that threads waiting on
+	 * their timestamps don't hold up each other or the submissions
+	 */
 	context = kgsl_context_get_owner(dev_priv, param->context_id);
 
 	if (context)
@@ -1543,7 +1545,6 @@ static long kgsl_ioctl_device_waittimestamp_ctxtid(struct kgsl_device_private
 			param->timestamp, param->timeout);
 
 	kgsl_context_put(context);
-	kgsl_mutex_unlock(&device->mutex, &device->mutex_owner);
 	return result;
 }
 
@@ -2384,7 +2385,18 @@ static long _cmdstream_readtimestamp(struct kgsl_device_private *dev_priv,
 		struct kgsl_context *context, unsigned int type,
 		unsigned int *timestamp)
 {
-	*timestamp = kgsl_readtimestamp(dev_priv->device, context, type);
+	struct kgsl_device *device = dev_priv->device;
+
+	/*
+	 * The retired and consumed timestamps come from the memstore, only the
+	 * queued one is guarded by the device mutex
+	 */
+	if (type == KGSL_TIMESTAMP_QUEUED) {
+		kgsl_mutex_lock(&device->mutex, &device->mutex_owner);
+		*timestamp = kgsl_readtimestamp(device, context, type);
+		kgsl_mutex_unlock(&device->mutex, &device->mutex_owner);
+	} else
+		*timestamp = kgsl_readtimestamp(device, context, type);
 
 	trace_kgsl_readtimestamp(dev_priv->device,
 			context ? context->id : KGSL_MEMSTORE_GLOBAL,
@@ -2398,14 +2410,9 @@ static long kgsl_ioctl_cmdstream_readtimestamp(struct kgsl_device_private
 						void *data)
 {
 	struct kgsl_cmdstream_readtimestamp *param = data;
-	struct kgsl_device *device = dev_priv->device;
-	long result = -EINVAL;
 
-	kgsl_mutex_lock(&device->mutex, &device->mutex_owner);
-	result = _cmdstream_readtimestamp(dev_priv, NULL,
+	return _cmdstream_readtimestamp(dev_priv, NULL,
 			param->type, &param->timestamp);
-	kgsl_mutex_unlock(&device->mutex, &device->mutex_owner);
-	return result;
 }
 
 static long kgsl_ioctl_cmdstream_readtimestamp_ctxtid(struct kgsl_device_private
@@ -2413,11 +2420,9 @@ static long kgsl_ioctl_cmdstream_readtimestamp_ctxtid(struct kgsl_device_private
 						void *data)
 {
 	struct kgsl_cmdstream_readtimestamp_ctxtid *param = data;
-	struct kgsl_device *device = dev_priv->device;
 	struct kgsl_context *context;
 	long result = -EINVAL;
 
-	kgsl_mutex_lock(&device->mutex, &device->mutex_owner);
 	context = kgsl_context_get_owner(dev_priv, param->context_id);
 
 	if (context)
@@ -2425,7 +2430,6 @@ static long kgsl_ioctl_cmdstream_readtimestamp_ctxtid(struct kgsl_device_private
 			param->type, &param->timestamp);
 
 	kgsl_context_put(context);
-	kgsl_mutex_unlock(&device->mutex, &device->mutex_owner);
 	return result;
 }
 
@@ -4449,6 +4453,7 @@ static void kgsl_core_exit(void)
 	}
 
 	kgsl_memfree_exit();
+	kgsl_pool_exit();
 	unregister_chrdev_region(kgsl_driver.major, KGSL_DEVICE_MAX);
 }
 
@@ -4522,6 +4527,10 @@ static int __init kgsl_core_init(void)
 
 	kgsl_memfree_init();
 
+	result = kgsl_pool_init();
+	if (result)
+		goto err;
+
 	return 0;
 
 err:
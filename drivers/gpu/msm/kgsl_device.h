@@ -97,6 +97,7 @@ struct kgsl_functable {
 	int (*getproperty) (struct kgsl_device *device,
 		enum kgsl_property_type type, void *value,
 		unsigned int sizebytes);
+	/* called without device->mutex held */
 	int (*waittimestamp) (struct kgsl_device *device,
 		struct kgsl_context *context, unsigned int timestamp,
 		unsigned int msecs);
@@ -175,6 +176,8 @@ struct kgsl_event {
  * @ibcount: Number of IBs in the command list
  * @ibdesc: Pointer to the list of IBs
  * @expires: Point in time when the cmdbatch is considered to be hung
+ * @queued: Time in usecs when the command was put on the context queue
+ * @submitted: Time in usecs when the command was written to the ringbuffer
  * @refcount: kref structure to maintain the reference count
  * @synclist: List of context/timestamp tuples to wait for before issuing
  * @timer: a timer used to track possible sync timeouts for this cmdbatch
@@ -194,6 +197,8 @@ struct kgsl_cmdbatch {
 	uint32_t ibcount;
 	struct kgsl_ibdesc *ibdesc;
 	unsigned long expires;
+	s64 queued;
+	s64 submitted;
 	struct kref refcount;
 	struct list_head synclist;
 	struct timer_list timer;
@@ -299,6 +304,14 @@ struct kgsl_device {
 	struct list_head events_pending_list;
 	unsigned int events_last_timestamp;
 
+	/*
+	 * Contexts with threads sleeping on one of their timestamps, for the
+	 * interrupt handler to wake. waiters_lock is taken from the interrupt
+	 * handler.
+	 */
+	struct list_head waiters;
+	spinlock_t waiters_lock;
+
 	/* Postmortem Control switches */
 	int pm_regs_enabled;
 	int pm_ib_enabled;
@@ -319,6 +332,8 @@ void kgsl_process_events(struct work_struct *work);
 	.context_idr = IDR_INIT((_dev).context_idr),\
 	.events = LIST_HEAD_INIT((_dev).events),\
 	.events_pending_list = LIST_HEAD_INIT((_dev).events_pending_list), \
+	.waiters = LIST_HEAD_INIT((_dev).waiters), \
+	.waiters_lock = __SPIN_LOCK_UNLOCKED((_dev).waiters_lock), \
 	.wait_queue = __WAIT_QUEUE_HEAD_INITIALIZER((_dev).wait_queue),\
 	.active_cnt_wq = __WAIT_QUEUE_HEAD_INITIALIZER((_dev).active_cnt_wq),\
 	.mutex = __MUTEX_INITIALIZER((_dev).mutex),\
@@ -356,6 +371,11 @@ struct kgsl_process_private;
  * @pwr_constraint: power constraint from userspace for this context
  * @fault_count: number of times gpu hanged in last _context_throttle_time ms
  * @fault_time: time of the first gpu hang in last _context_throttle_time ms
+ * @ts_waitq: wait queue for the threads waiting on a timestamp of the context
+ * @waiters: number of threads sleeping on @ts_waitq
+ * @waiters_list: node in the device list of contexts with waiters
+ * @retired: retired timestamp the waiters were last woken for
+ * @retired_time: time in usecs of the interrupt that last woke the waiters
  */
 struct kgsl_context {
 	struct kref refcount;
@@ -376,6 +396,11 @@ struct kgsl_context {
 	struct kgsl_pwr_constraint pwr_constraint;
 	unsigned int fault_count;
 	unsigned long fault_time;
+	wait_queue_head_t ts_waitq;
+	unsigned int waiters;
+	struct list_head waiters_list;
+	unsigned int retired;
+	s64 retired_time;
 };
 
 /**
@@ -437,6 +462,12 @@ int kgsl_add_event(struct kgsl_device *device, u32 id, u32 ts,
 void kgsl_cancel_event(struct kgsl_device *device, struct kgsl_context *context,
 		unsigned int timestamp, kgsl_event_func func, void *priv);
 
+int kgsl_wait_timestamp(struct kgsl_device *device,
+		struct kgsl_context *context, unsigned int timestamp,
+		unsigned long timeout, bool (*abort)(struct kgsl_context *));
+
+void kgsl_wake_waiters(struct kgsl_device *device);
+
 static inline void kgsl_process_add_stats(struct kgsl_process_private *priv,
 	unsigned int type, size_t size)
 {
@@ -14,6 +14,8 @@
 #include <linux/slab.h>
 #include <linux/list.h>
 #include <linux/module.h>
+#include <linux/sched.h>
+#include <linux/ktime.h>
 #include <kgsl_device.h>
 
 #include "kgsl_trace.h"
@@ -355,6 +357,122 @@ void kgsl_cancel_event(struct kgsl_device *device, struct kgsl_context *context,
 }
 EXPORT_SYMBOL(kgsl_cancel_event);
 
+static bool _wait_done(struct kgsl_device *device,
+		struct kgsl_context *context, unsigned int timestamp,
+		bool (*abort)(struct kgsl_context *))
+{
+	if (kgsl_check_timestamp(device, context, timestamp))
+		return true;
+
+	return abort ? abort(context) : false;
+}
+
+/**
+ * kgsl_wait_timestamp() - sleep until a context timestamp retires
+ * @device: Pointer to the KGSL device struct
+ * @context: Pointer to the KGSL context that owns the timestamp
+ * @timestamp: Timestamp to wait for
+ * @timeout: Number of jiffies to wait, 0 to wait forever
+ * @abort: Optional function that ends the wait when it returns true
+ *
+ * Wait for a timestamp without device->mutex and without an event: the
+ * waiter puts its context on the device list of contexts with waiters and
+ * kgsl_wake_waiters() wakes it from the interrupt handler as soon as the
+ * retired timestamp of the context moves.  Returns 0 if the timestamp
+ * retired or @abort said to stop, -ETIMEDOUT if the timeout expired or
+ * -ERESTARTSYS if a signal arrived.
+ */
+int kgsl_wait_timestamp(struct kgsl_device *device,
+		struct kgsl_context *context, unsigned int timestamp,
+		unsigned long timeout, bool (*abort)(struct kgsl_context *))
+{
+	unsigned long flags;
+	s64 start, retired_time;
+	long ret;
+
+	if (_wait_done(device, context, timestamp, abort))
+		return 0;
+
+	start = ktime_to_us(ktime_get());
+
+	spin_lock_irqsave(&device->waiters_lock, flags);
+	if (context->waiters++ == 0) {
+		context->retired = kgsl_readtimestamp(device, context,
+			KGSL_TIMESTAMP_RETIRED);
+		list_add_tail(&context->waiters_list, &device->waiters);
+	}
+	spin_unlock_irqrestore(&device->waiters_lock, flags);
+
+	if (timeout) {
+		ret = wait_event_interruptible_timeout(context->ts_waitq,
+			_wait_done(device, context, timestamp, abort),
+			timeout);
+
+		if (ret > 0)
+			ret = 0;
+		else if (ret == 0)
+			ret = -ETIMEDOUT;
+	} else {
+		ret = wait_event_interruptible(context->ts_waitq,
+			_wait_done(device, context, timestamp, abort));
+	}
+
+	/* retired_time is 64 bit, so it is only read whole under the lock */
+	spin_lock_irqsave(&device->waiters_lock, flags);
+	if (--context->waiters == 0)
+		list_del_init(&context->waiters_list);
+	retired_time = context->retired_time;
+	spin_unlock_irqrestore(&device->waiters_lock, flags);
+
+	/* Only an interrupt that came while we slept says how long it took */
+	if (ret == 0 && retired_time >= start &&
+		kgsl_check_timestamp(device, context, timestamp))
+		trace_kgsl_waittimestamp_wakeup(device, context->id, timestamp,
+			ktime_to_us(ktime_get()) - retired_time);
+
+	return (int) ret;
+}
+EXPORT_SYMBOL(kgsl_wait_timestamp);
+
+/**
+ * kgsl_wake_waiters() - wake the threads waiting on context timestamps
+ * @device: Pointer to the KGSL device struct
+ *
+ * Called from the interrupt handler after the GPU wrote a timestamp.  Reads
+ * the retired timestamp of each context with waiters from the memstore and
+ * wakes the waiters of the contexts where it moved.
+ */
+void kgsl_wake_waiters(struct kgsl_device *device)
+{
+	struct kgsl_context *context;
+	unsigned long flags;
+	unsigned int retired;
+	s64 now;
+
+	spin_lock_irqsave(&device->waiters_lock, flags);
+
+	if (list_empty(&device->waiters))
+		goto done;
+
+	now = ktime_to_us(ktime_get());
+
+	list_for_each_entry(context, &device->waiters, waiters_list) {
+		retired = kgsl_readtimestamp(device, context,
+			KGSL_TIMESTAMP_RETIRED);
+
+		if (retired == context->retired)
+			continue;
+
+		context->retired = retired;
+		context->retired_time = now;
+		wake_up_all(&context->ts_waitq);
+	}
+
+done:
+	spin_unlock_irqrestore(&device->waiters_lock, flags);
+}
+EXPORT_SYMBOL(kgsl_wake_waiters);
+
 static inline int _mark_next_event(struct kgsl_device *device,
 		struct list_head *head)
 {
@@ -0,0 +1,321 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include <linux/highmem.h>
+#include <linux/ion_page_pool.h>
+#include <linux/mm.h>
+#include <linux/sizes.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
+#include <asm/cacheflush.h>
+
+#include "kgsl.h"
+#include "kgsl_pool.h"
+
+/*
+ * Zeroes a block of 1 << order pages and writes it out of the CPU caches,
+ * so that the GPU sees zeroes whatever the mapping it is given later.
+ */
+static void kgsl_pool_zero_page(struct page *page, unsigned int order)
+{
+	size_t size = PAGE_SIZE << order;
+	unsigned int i;
+	void *ptr;
+
+	if (!PageHighMem(page)) {
+		ptr = page_address(page);
+		memset(ptr, 0, size);
+		dmac_flush_range(ptr, ptr + size);
+	} else {
+		for (i = 0; i < (1 << order); i++) {
+			ptr = kmap_atomic(nth_page(page, i));
+			clear_page(ptr);
+			dmac_flush_range(ptr, ptr + PAGE_SIZE);
+			kunmap_atomic(ptr);
+		}
+	}
+	outer_flush_range(page_to_phys(page), page_to_phys(page) + size);
+}
+
+#ifdef CONFIG_MSM_KGSL_PAGE_POOLS
+
+/*
+ * GPU buffers are built from blocks of the orders below, largest first,
+ * so that a big buffer takes a few allocations, gets a short scatterlist
+ * and can be mapped with 1M and 64K IOMMU pages. Free blocks are kept in
+ * ion page pools, zeroed and clean: freed buffers are handed to a worker
+ * that zeroes and flushes their blocks before putting them back. When a
+ * pool runs dry the block comes from the page allocator instead and is
+ * cleaned on the spot.
+ */
+static const unsigned int kgsl_pool_orders[] = { KGSL_POOL_MAX_ORDER, 4, 0 };
+
+#define KGSL_POOL_NUM ARRAY_SIZE(kgsl_pool_orders)
+
+/* Blocks freed beyond this many pages in the pools go back to the system */
+#define KGSL_POOL_MAX_PAGES (SZ_64M >> PAGE_SHIFT)
+
+struct kgsl_page_pool {
+	struct ion_page_pool *pool;
+	unsigned int order;
+	unsigned int hits;
+	unsigned int misses;
+};
+
+static struct kgsl_page_pool kgsl_pools[KGSL_POOL_NUM];
+
+/* Pages in the pools plus those waiting to be cleaned */
+static atomic_t kgsl_pool_pages = ATOMIC_INIT(0);
+
+/* Freed blocks waiting for the worker, chained through page->lru */
+static LIST_HEAD(kgsl_pool_dirty);
+static DEFINE_SPINLOCK(kgsl_pool_lock);
+
+static struct workqueue_struct *kgsl_pool_wq;
+
+static struct kgsl_page_pool *kgsl_pool_find(unsigned int order)
+{
+	int i;
+
+	for (i = 0; i < KGSL_POOL_NUM; i++)
+		if (kgsl_pools[i].pool && kgsl_pools[i].order == order)
+			return &kgsl_pools[i];
+	return NULL;
+}
+
+static void kgsl_pool_clean_work(struct work_struct *work)
+{
+	struct page *page, *tmp;
+	LIST_HEAD(dirty);
+
+	spin_lock(&kgsl_pool_lock);
+	list_splice_init(&kgsl_pool_dirty, &dirty);
+	spin_unlock(&kgsl_pool_lock);
+
+	list_for_each_entry_safe(page, tmp, &dirty, lru) {
+		unsigned int order = page_private(page);
+
+		list_del(&page->lru);
+		set_page_private(page, 0);
+		kgsl_pool_zero_page(page, order);
+		ion_page_pool_free(kgsl_pool_find(order)->pool, page);
+		cond_resched();
+	}
+}
+
+static DECLARE_WORK(kgsl_pool_work, kgsl_pool_clean_work);
+
+/**
+ * kgsl_pool_alloc_page() - Allocate a zeroed block of pages for a buffer
+ * @len: bytes of the buffer still to be allocated
+ * @order: on entry the largest order to try, on return the order of the
+ * block allocated
+ *
+ * Returns the first page of a block of 1 << *order pages that is zeroed
+ * and clean in the CPU caches, or NULL if no block of any order fits.
+ */
+struct page *kgsl_pool_alloc_page(size_t len, unsigned int *order)
+{
+	struct kgsl_page_pool *p;
+	struct page *page;
+	bool from_pool;
+	int i;
+
+	for (i = 0; i < KGSL_POOL_NUM; i++) {
+		p = &kgsl_pools[i];
+		if (p->order > *order || len < (PAGE_SIZE << p->order))
+			continue;
+
+		page = ion_page_pool_alloc(p->pool, &from_pool);
+		if (page == NULL)
+			continue;
+
+		if (from_pool) {
+			p->hits++;
+			atomic_sub(1 << p->order, &kgsl_pool_pages);
+		} else {
+			p->misses++;
+			kgsl_pool_zero_page(page, p->order);
+		}
+		*order = p->order;
+		return page;
+	}
+	return NULL;
+}
+
+/**
+ * kgsl_pool_free_page() - Free a block of pages of a buffer
+ * @page: first page of the block
+ * @order: order of the block
+ *
+ * The block is cleaned and put back in its pool in the background, unless
+ * the pools are full.
+ */
+void kgsl_pool_free_page(struct page *page, unsigned int order)
+{
+	if (kgsl_pool_find(order) == NULL) {
+		__free_pages(page, order);
+		return;
+	}
+
+	if (atomic_add_return(1 << order, &kgsl_pool_pages) >
+	    KGSL_POOL_MAX_PAGES) {
+		atomic_sub(1 << order, &kgsl_pool_pages);
+		__free_pages(page, order);
+		return;
+	}
+
+	set_page_private(page, order);
+	spin_lock(&kgsl_pool_lock);
+	list_add_tail(&page->lru, &kgsl_pool_dirty);
+	spin_unlock(&kgsl_pool_lock);
+
+	queue_work(kgsl_pool_wq, &kgsl_pool_work);
+}
+
+int kgsl_pool_stats_show(char *buf, int size)
+{
+	struct kgsl_page_pool *p;
+	int i, len = 0;
+
+	for (i = 0; i < KGSL_POOL_NUM; i++) {
+		p = &kgsl_pools[i];
+		if (p->pool == NULL)
+			continue;
+		len += snprintf(buf + len, size - len,
+			"pool %luK: %d free %u hits %u misses\n",
+			(PAGE_SIZE << p->order) >> 10,
+			p->pool->high_count + p->pool->low_count,
+			p->hits, p->misses);
+	}
+	return len;
+}
+
+/* Give back the smaller blocks first, they are the cheapest to replace */
+static int kgsl_pool_shrink(struct shrinker *shrinker,
+			    struct shrink_control *sc)
+{
+	int nr_total = 0, nr_freed = 0;
+	int i;
+
+	for (i = KGSL_POOL_NUM - 1; i >= 0; i--) {
+		if (nr_freed >= sc->nr_to_scan)
+			break;
+		nr_freed += ion_page_pool_shrink(kgsl_pools[i].pool,
+				sc->gfp_mask, sc->nr_to_scan - nr_freed);
+	}
+	atomic_sub(nr_freed, &kgsl_pool_pages);
+
+	for (i = 0; i < KGSL_POOL_NUM; i++)
+		nr_total += ion_page_pool_shrink(kgsl_pools[i].pool,
+				sc->gfp_mask, 0);
+	return nr_total;
+}
+
+static struct shrinker kgsl_pool_shrinker = {
+	.shrink = kgsl_pool_shrink,
+	.seeks = DEFAULT_SEEKS,
+};
+
+int kgsl_pool_init(void)
+{
+	gfp_t gfp;
+	int i;
+
+	kgsl_pool_wq = alloc_workqueue("kgsl-pool", WQ_UNBOUND, 1);
+	if (kgsl_pool_wq == NULL)
+		return -ENOMEM;
+
+	for (i = 0; i < KGSL_POOL_NUM; i++) {
+		/*
+		 * Do not try hard for high orders, smaller blocks will do.
+		 * They are compound so that the vmfault handler can take
+		 * references on the pages inside a block.
+		 */
+		gfp = GFP_HIGHUSER | __GFP_NOWARN;
+		if (kgsl_pool_orders[i])
+			gfp = (gfp | __GFP_COMP | __GFP_NORETRY |
+			       __GFP_NO_KSWAPD) & ~__GFP_WAIT;
+
+		kgsl_pools[i].order = kgsl_pool_orders[i];
+		kgsl_pools[i].pool = ion_page_pool_create(gfp,
+				kgsl_pool_orders[i]);
+		if (kgsl_pools[i].pool == NULL) {
+			kgsl_pool_exit();
+			return -ENOMEM;
+		}
+	}
+
+	register_shrinker(&kgsl_pool_shrinker);
+	return 0;
+}
+
+void kgsl_pool_exit(void)
+{
+	struct kgsl_page_pool *p;
+	int i;
+
+	if (kgsl_pool_wq == NULL)
+		return;
+
+	if (kgsl_pools[KGSL_POOL_NUM - 1].pool)
+		unregister_shrinker(&kgsl_pool_shrinker);
+
+	flush_workqueue(kgsl_pool_wq);
+	destroy_workqueue(kgsl_pool_wq);
+	kgsl_pool_wq = NULL;
+
+	for (i = 0; i < KGSL_POOL_NUM; i++) {
+		p = &kgsl_pools[i];
+		if (p->pool == NULL)
+			continue;
+		while (ion_page_pool_shrink(p->pool, GFP_HIGHUSER, INT_MAX))
+			;
+		ion_page_pool_destroy(p->pool);
+		p->pool = NULL;
+	}
+	atomic_set(&kgsl_pool_pages, 0);
+}
+
+#else
+
+struct page *kgsl_pool_alloc_page(size_t len, unsigned int *order)
+{
+	struct page *page = alloc_page(GFP_KERNEL | __GFP_HIGHMEM);
+
+	if (page)
+		kgsl_pool_zero_page(page, 0);
+	*order = 0;
+	return page;
+}
+
+void kgsl_pool_free_page(struct page *page, unsigned int order)
+{
+	__free_pages(page, order);
+}
+
+int kgsl_pool_stats_show(char *buf, int size)
+{
+	return 0;
+}
+
+int kgsl_pool_init(void)
+{
+	return 0;
+}
+
+void kgsl_pool_exit(void)
+{
+}
+
+#endif
@@ -316,6 +316,8 @@ int kgsl_devfreq_get_dev_status(struct device *dev,
 
 	kgsl_pwrctrl_busy_time(device, stat->total_time, stat->busy_time);
 	trace_kgsl_pwrstats(device, stat->total_time, &pwrscale->accum_stats);
+	trace_kgsl_devfreq_status(device, stat, &pwrscale->accum_stats,
+				  device->pwrctrl.bus_mod);
 	memset(&pwrscale->accum_stats, 0, sizeof(pwrscale->accum_stats));
 
 	kgsl_mutex_unlock(&device->mutex, &device->mutex_owner);
@@ -370,6 +372,42 @@ int kgsl_devfreq_add_notifier(struct device *dev, struct notifier_block *nb)
 	return srcu_notifier_chain_register(&device->pwrscale.nh, nb);
 }
 
+/**
+ * kgsl_pwrscale_frame() - report the GPU timing of a frame
+ * @device: The device
+ * @start: time in usecs the GPU started on the frame
+ * @end: time in usecs the last command batch of the frame retired
+ * @busy: usecs the GPU spent on the frame
+ *
+ * Queue an ADRENO_DEVFREQ_NOTIFY_FRAME notification for the frame. If the
+ * governor falls behind only the most recent frames are kept.
+ */
+void kgsl_pwrscale_frame(struct kgsl_device *device, s64 start, s64 end,
+			 s64 busy)
+{
+	struct kgsl_pwrscale *pwrscale = &device->pwrscale;
+	struct adreno_frame_stats *frame;
+	unsigned long flags;
+
+	if (!pwrscale->enabled || pwrscale->devfreqptr == NULL)
+		return;
+
+	spin_lock_irqsave(&pwrscale->frame_lock, flags);
+	if (pwrscale->frame_tail - pwrscale->frame_head == KGSL_PWRSCALE_FRAMES)
+		pwrscale->frame_head++;
+	frame = &pwrscale->frames[pwrscale->frame_tail++ &
+				  (KGSL_PWRSCALE_FRAMES - 1)];
+	frame->devfreq = pwrscale->devfreqptr;
+	frame->start = start;
+	frame->end = end;
+	frame->busy = busy;
+	frame->freq = kgsl_pwrctrl_active_freq(&device->pwrctrl);
+	spin_unlock_irqrestore(&pwrscale->frame_lock, flags);
+
+	queue_work(pwrscale->devfreq_wq, &pwrscale->devfreq_notify_ws);
+}
+EXPORT_SYMBOL(kgsl_pwrscale_frame);
+
 void kgsl_pwrscale_idle(struct kgsl_device *device)
 {
 	BUG_ON(!mutex_is_locked(&device->mutex));
@@ -428,6 +466,7 @@ int kgsl_pwrscale_init(struct device *dev, const char *governor)
 	profile = &pwrscale->ext_profile.profile;
 
 	srcu_init_notifier_head(&pwrscale->nh);
+	spin_lock_init(&pwrscale->frame_lock);
 
 	profile->initial_freq =
 		pwr->pwrlevels[pwr->default_pwrlevel].gpu_freq;
@@ -543,6 +582,22 @@ static void do_devfreq_notify(struct work_struct *work)
 	struct kgsl_pwrscale *pwrscale = container_of(work,
 			struct kgsl_pwrscale, devfreq_notify_ws);
 	struct devfreq *devfreq = pwrscale->devfreqptr;
+	struct adreno_frame_stats frame;
+	unsigned long flags;
+
+	spin_lock_irqsave(&pwrscale->frame_lock, flags);
+	while (pwrscale->frame_head != pwrscale->frame_tail) {
+		frame = pwrscale->frames[pwrscale->frame_head++ &
+					 (KGSL_PWRSCALE_FRAMES - 1)];
+		spin_unlock_irqrestore(&pwrscale->frame_lock, flags);
+
+		srcu_notifier_call_chain(&pwrscale->nh,
+					 ADRENO_DEVFREQ_NOTIFY_FRAME, &frame);
+
+		spin_lock_irqsave(&pwrscale->frame_lock, flags);
+	}
+	spin_unlock_irqrestore(&pwrscale->frame_lock, flags);
+
 	srcu_notifier_call_chain(&pwrscale->nh,
 				 ADRENO_DEVFREQ_NOTIFY_RETIRE,
 				 devfreq);
@@ -20,6 +20,9 @@
 /* devfreq governor call window in msec */
 #define KGSL_GOVERNOR_CALL_INTERVAL 5
 
+/* frames waiting for ADRENO_DEVFREQ_NOTIFY_FRAME, must be a power of 2 */
+#define KGSL_PWRSCALE_FRAMES 8
+
 struct kgsl_power_stats {
 	u64 busy_time;
 	u64 ram_time;
@@ -41,6 +44,10 @@ struct kgsl_pwrscale {
 	struct work_struct devfreq_resume_ws;
 	struct work_struct devfreq_notify_ws;
 	unsigned long next_governor_call;
+	spinlock_t frame_lock;
+	struct adreno_frame_stats frames[KGSL_PWRSCALE_FRAMES];
+	unsigned int frame_head;
+	unsigned int frame_tail;
 };
 
 int kgsl_pwrscale_init(struct device *dev, const char *governor);
@@ -52,6 +59,8 @@ void kgsl_pwrscale_busy(struct kgsl_device *device);
 void kgsl_pwrscale_idle(struct kgsl_device *device);
 void kgsl_pwrscale_sleep(struct kgsl_device *device);
 void kgsl_pwrscale_wake(struct kgsl_device *device);
+void kgsl_pwrscale_frame(struct kgsl_device *device, s64 start, s64 end,
+			 s64 busy);
 
 void kgsl_pwrscale_enable(struct kgsl_device *device);
 void kgsl_pwrscale_disable(struct kgsl_device *device);
@@ -23,6 +23,7 @@
 #include "kgsl_sharedmem.h"
 #include "kgsl_cffdump.h"
 #include "kgsl_device.h"
+#include "kgsl_pool.h"
 
 DEFINE_MUTEX(kernel_map_global_lock);
 
@@ -249,6 +250,15 @@ static int kgsl_drv_histogram_show(struct device *dev,
 			kgsl_driver.stats.histogram[i]);
 
 	len += snprintf(buf + len, PAGE_SIZE - len, "\n");
+
+	/* bucket i: page allocations that took less than 2^i us */
+	len += snprintf(buf + len, PAGE_SIZE - len, "alloc_us:");
+	for (i = 0; i < 16; i++)
+		len += snprintf(buf + len, PAGE_SIZE - len, " %d",
+			kgsl_driver.stats.alloc_latency[i]);
+
+	len += snprintf(buf + len, PAGE_SIZE - len, "\n");
+	len += kgsl_pool_stats_show(buf + len, PAGE_SIZE - len);
 	return len;
 }
 
@@ -434,7 +444,7 @@ static void kgsl_page_alloc_free(struct kgsl_memdesc *memdesc)
 
 	if (memdesc->sg)
 		for_each_sg(memdesc->sg, sg, sglen, i)
-			__free_pages(sg_page(sg), get_order(sg->length));
+			kgsl_pool_free_page(sg_page(sg), get_order(sg->length));
 }
 
 static int kgsl_contiguous_vmflags(struct kgsl_memdesc *memdesc)
@@ -631,8 +641,9 @@ _kgsl_sharedmem_page_alloc(struct kgsl_memdesc *memdesc,
 {
 	int order, ret = 0;
 	int len, sglen_alloc, sglen = 0;
-	void *ptr;
-	unsigned int align;
+	unsigned int align, page_order = KGSL_POOL_MAX_ORDER;
+	ktime_t start = ktime_get();
+	s64 usecs;
 
 	align = (memdesc->flags & KGSL_MEMALIGN_MASK) >> KGSL_MEMALIGN_SHIFT;
 
@@ -663,7 +674,8 @@ _kgsl_sharedmem_page_alloc(struct kgsl_memdesc *memdesc,
 	while (len > 0) {
 		struct page *page;
 
-		page = alloc_page(GFP_KERNEL | __GFP_HIGHMEM | __GFP_ZERO);
+		/* blocks come zeroed and clean, largest that fits first */
+		page = kgsl_pool_alloc_page(len, &page_order);
 
 		if (page == NULL) {
 			/*
@@ -682,25 +694,31 @@ _kgsl_sharedmem_page_alloc(struct kgsl_memdesc *memdesc,
 			goto done;
 		}
 
-		ptr = kmap_atomic(page);
-		dmac_flush_range(ptr, ptr + PAGE_SIZE);
-		kunmap_atomic(ptr);
-
-		sg_set_page(&memdesc->sg[sglen++], page, PAGE_SIZE, 0);
-		len -= PAGE_SIZE;
+		sg_set_page(&memdesc->sg[sglen++], page,
+			PAGE_SIZE << page_order, 0);
+		len -= PAGE_SIZE << page_order;
 	}
 
 	memdesc->sglen = sglen;
 	memdesc->size = size;
 
-	outer_cache_range_op_sg(memdesc->sg, memdesc->sglen,
-				KGSL_CACHE_OP_FLUSH);
+	/*
+	 * Let the GPU address follow the physical alignment of the first
+	 * block so that the IOMMU can use large pages for it.
+	 */
+	if (memdesc->sg->length >= SZ_1M && align < ilog2(SZ_1M))
+		kgsl_memdesc_set_align(memdesc, ilog2(SZ_1M));
+	else if (memdesc->sg->length >= SZ_64K && align < ilog2(SZ_64K))
+		kgsl_memdesc_set_align(memdesc, ilog2(SZ_64K));
 
 	order = get_order(size);
 
 	if (order < 16)
 		kgsl_driver.stats.histogram[order]++;
 
+	usecs = ktime_us_delta(ktime_get(), start);
+	kgsl_driver.stats.alloc_latency[min_t(int, fls64(usecs), 15)]++;
+
 done:
 	KGSL_STATS_ADD(memdesc->size, kgsl_driver.stats.page_alloc,
 		kgsl_driver.stats.page_alloc_max);
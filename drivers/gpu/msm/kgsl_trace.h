@@ -192,6 +192,40 @@ TRACE_EVENT(kgsl_waittimestamp_exit,
 	)
 );
 
+/*
+ * Tracepoint for the time from the timestamp interrupt to the wakeup of a
+ * thread waiting on the timestamp
+ */
+TRACE_EVENT(kgsl_waittimestamp_wakeup,
+
+	TP_PROTO(struct kgsl_device *device, unsigned int context_id,
+		 unsigned int wait_ts, s64 latency),
+
+	TP_ARGS(device, context_id, wait_ts, latency),
+
+	TP_STRUCT__entry(
+		__string(device_name, device->name)
+		__field(unsigned int, context_id)
+		__field(unsigned int, wait_ts)
+		__field(s64, latency)
+	),
+
+	TP_fast_assign(
+		__assign_str(device_name, device->name);
+		__entry->context_id = context_id;
+		__entry->wait_ts = wait_ts;
+		__entry->latency = latency;
+	),
+
+	TP_printk(
+		"d_name=%s ctx=%u ts=%u latency_us=%lld",
+		__get_str(device_name),
+		__entry->context_id,
+		__entry->wait_ts,
+		__entry->latency
+	)
+);
+
 DECLARE_EVENT_CLASS(kgsl_pwr_template,
 	TP_PROTO(struct kgsl_device *device, int on),
 
@@ -824,6 +858,43 @@ TRACE_EVENT(kgsl_pwrstats,
 	)
 );
 
+/*
+ * Tracepoint for the samples handed to the devfreq governor, in the format
+ * tools/power/adreno_devfreq_sim replays
+ */
+TRACE_EVENT(kgsl_devfreq_status,
+	TP_PROTO(struct kgsl_device *device, struct devfreq_dev_status *stat,
+		struct kgsl_power_stats *pstats, int bus_mod),
+
+	TP_ARGS(device, stat, pstats, bus_mod),
+	TP_STRUCT__entry(
+		__string(device_name, device->name)
+		__field(unsigned long, freq)
+		__field(unsigned long, total_time)
+		__field(unsigned long, busy_time)
+		__field(u64, ram_time)
+		__field(u64, ram_wait)
+		__field(int, bus_mod)
+	),
+
+	TP_fast_assign(
+		__assign_str(device_name, device->name);
+		__entry->freq = stat->current_frequency;
+		__entry->total_time = stat->total_time;
+		__entry->busy_time = stat->busy_time;
+		__entry->ram_time = pstats->ram_time;
+		__entry->ram_wait = pstats->ram_wait;
+		__entry->bus_mod = bus_mod;
+	),
+
+	TP_printk(
+		"d_name=%s freq=%lu total_time=%lu busy_time=%lu ram_time=%llu ram_wait=%llu bus_mod=%d",
+		__get_str(device_name), __entry->freq, __entry->total_time,
+		__entry->busy_time, __entry->ram_time, __entry->ram_wait,
+		__entry->bus_mod
+	)
+);
+
 DECLARE_EVENT_CLASS(syncpoint_timestamp_template,
 	TP_PROTO(struct kgsl_cmdbatch *cmdbatch, struct kgsl_context *context,
 		unsigned int timestamp),
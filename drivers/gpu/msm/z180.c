@@ -868,12 +868,15 @@ static int z180_waittimestamp(struct kgsl_device *device,
 	if (msecs == -1)
 		msecs = Z180_IDLE_TIMEOUT;
 
+	kgsl_mutex_lock(&device->mutex, &device->mutex_owner);
 	status = kgsl_active_count_get(device);
+	kgsl_mutex_unlock(&device->mutex, &device->mutex_owner);
+
 	if (!status) {
-		kgsl_mutex_unlock(&device->mutex, &device->mutex_owner);
 		status = z180_wait(device, context, timestamp, msecs);
 		kgsl_mutex_lock(&device->mutex, &device->mutex_owner);
 		kgsl_active_count_put(device);
+		kgsl_mutex_unlock(&device->mutex, &device->mutex_owner);
 	}
 
 	return status;
@@ -740,7 +740,7 @@ static ssize_t macvtap_get_user(struct macvtap_queue *q, struct msghdr *m,
 						   len);
 		if (!err && m && m->msg_control) {
 			struct ubuf_info *uarg = m->msg_control;
-			uarg->callback(uarg);
+			uarg->callback(uarg, false);
 		}
 	}
 
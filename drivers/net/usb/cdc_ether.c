@@ -465,7 +465,7 @@ static int cdc_manage_power(struct usbnet *dev, int on)
 
 static const struct driver_info	cdc_info = {
 	.description =	"CDC Ethernet Device",
-	.flags =	FLAG_ETHER | FLAG_POINTTOPOINT,
+	.flags =	FLAG_ETHER | FLAG_POINTTOPOINT | FLAG_RX_NAPI,
 	// .check_connect = cdc_check_connect,
 	.bind =		usbnet_cdc_bind,
 	.unbind =	usbnet_cdc_unbind,
@@ -475,7 +475,7 @@ static const struct driver_info	cdc_info = {
 
 static const struct driver_info wwan_info = {
 	.description =	"Mobile Broadband Network Device",
-	.flags =	FLAG_WWAN,
+	.flags =	FLAG_WWAN | FLAG_RX_NAPI,
 	.bind =		usbnet_cdc_bind,
 	.unbind =	usbnet_cdc_unbind,
 	.status =	usbnet_cdc_status,
@@ -28,6 +28,7 @@
 					sizeof(struct QMI_QOS_HDR_S))
 #define RMNET_HEADROOM			sizeof(struct QMI_QOS_HDR_S)
 #define RMNET_TAILROOM			MAX_PAD_BYTES(4);
+#define RMNET_RX_AGGR_MAX		(16 * 1024)
 
 static unsigned int no_rmnet_devs = 1;
 module_param(no_rmnet_devs, uint, S_IRUGO | S_IWUSR);
@@ -46,8 +47,25 @@ module_param(mux_enabled, ulong, S_IRUGO | S_IWUSR);
 static unsigned int no_fwd_rmnet_links;
 module_param(no_fwd_rmnet_links, uint, S_IRUGO | S_IWUSR);
 
+/*
+ * Rx urb size with mux enabled. Anything above one frame lets the modem
+ * pack several mux frames into a transfer; 0 sizes urbs for one frame.
+ */
+static unsigned int rx_aggr_size;
+module_param(rx_aggr_size, uint, S_IRUGO | S_IWUSR);
+
 struct usbnet	*unet_list[TOTAL_RMNET_DEV_COUNT];
 
+/* mux frames demultiplexed from the rx urbs of each usbnet */
+struct rmnet_usb_rx_stats {
+	unsigned long	frames;
+	unsigned long	aggr_urbs;	/* urbs carrying more than one frame */
+	unsigned int	max_frames;	/* most frames seen in one urb */
+	unsigned long	dmux_errors;
+};
+
+static struct rmnet_usb_rx_stats rx_stats[TOTAL_RMNET_DEV_COUNT];
+
 /* net device name prefixes, indexed by driver_info->data */
 static const char * const rmnet_names[] = {
 	"rmnet_usb%d",
@@ -281,20 +299,36 @@ static int rmnet_usb_bind(struct usbnet *usbnet, struct usb_interface *iface)
 		strlcpy(usbnet->net->name, rmnet_names[info->data],
 				IFNAMSIZ);
 
-	if (mux)
+	if (mux) {
 		usbnet->rx_urb_size = usbnet->hard_mtu + sizeof(struct mux_hdr)
 			+ MAX_PAD_BYTES(4);
+		if (rx_aggr_size > usbnet->rx_urb_size)
+			usbnet->rx_urb_size = min_t(size_t, rx_aggr_size,
+						    RMNET_RX_AGGR_MAX);
+	}
 out:
 	return status;
 }
 
-static int rmnet_usb_data_dmux(struct sk_buff *skb,  struct urb *rx_urb)
+/*
+ * Validates the mux frame at the head of skb. Returns its zero based mux id
+ * and the length of the packet it carries; *frame_len is the room the frame
+ * takes in the buffer, header and padding included.
+ */
+static int rmnet_usb_data_dmux(struct sk_buff *skb, size_t *pkt_len,
+		size_t *frame_len)
 {
 	struct mux_hdr	*hdr;
 	size_t		pad_len;
 	size_t		total_len;
 	unsigned int	mux_id;
 
+	if (skb->len < sizeof(struct mux_hdr)) {
+		pr_err_ratelimited("%s: Truncated mux header, len %u\n",
+				__func__, skb->len);
+		return -EINVAL;
+	}
+
 	hdr = (struct mux_hdr *)skb->data;
 	mux_id = hdr->mux_id;
 	if (!mux_id  || mux_id > no_rmnet_insts_per_dev) {
@@ -311,15 +345,15 @@ static int rmnet_usb_data_dmux(struct sk_buff *skb,  struct urb *rx_urb)
 	}
 
 	total_len = le16_to_cpu(hdr->pkt_len_w_padding);
-	if (!total_len || !(total_len - pad_len)) {
+	if (total_len <= pad_len ||
+	    total_len > skb->len - sizeof(struct mux_hdr)) {
 		pr_err_ratelimited("%s: Invalid pkt length %d\n", __func__,
 				total_len);
 		return -EINVAL;
 	}
 
-	skb->data = (unsigned char *)(hdr + 1);
-	skb_reset_tail_pointer(skb);
-	rx_urb->actual_length = total_len - pad_len;
+	*pkt_len = total_len - pad_len;
+	*frame_len = sizeof(struct mux_hdr) + total_len;
 
 	return mux_id - 1;
 }
@@ -381,34 +415,104 @@ static __be16 rmnet_ip_type_trans(struct sk_buff *skb)
 	return protocol;
 }
 
-static void rmnet_usb_rx_complete(struct urb *rx_urb)
+static int rmnet_usb_rx_protocol(struct usbnet *unet, struct sk_buff *skb)
 {
-	struct sk_buff	*skb = (struct sk_buff *) rx_urb->context;
-	struct skb_data	*entry = (struct skb_data *) skb->cb;
-	struct usbnet	*dev = entry->dev;
-	unsigned int	unet_offset;
-	unsigned int	unet_id;
-	int		mux_id;
+	if (test_bit(RMNET_MODE_LLP_IP, &unet->data[0])) {
+		skb_reset_mac_header(skb);
+		skb->protocol = rmnet_ip_type_trans(skb);
+		return 0;
+	}
 
-	unet_offset =  dev->driver_info->data * no_rmnet_insts_per_dev;
+	/* eth mode: usbnet_skb_return() would run eth_type_trans() against
+	 * the net device owning the urb rather than the mux channel
+	 */
+	if (skb->len < ETH_HLEN)
+		return -EINVAL;
+	skb->protocol = eth_type_trans(skb, unet->net);
 
-	if (!rx_urb->status && dev->data[4]) {
-		mux_id = rmnet_usb_data_dmux(skb, rx_urb);
+	return 0;
+}
+
+/*
+ * With mux enabled an rx urb may carry several frames back to back, for
+ * any of the mux channels of the device. They are all split out here in
+ * one pass: every frame but the last goes up as a clone sharing the urb
+ * buffer, the last one reuses the urb skb which usbnet then returns as a
+ * single packet. Frames go through the NAPI context of the usbnet owning
+ * the urb, with skb->dev pointing at the channel they belong to.
+ */
+static int rmnet_usb_data_deaggregate(struct usbnet *dev, struct sk_buff *skb)
+{
+	unsigned int			unet_offset;
+	struct rmnet_usb_rx_stats	*stats;
+	struct usbnet			*unet;
+	struct sk_buff			*frame;
+	size_t				pkt_len;
+	size_t				frame_len;
+	unsigned int			n = 0;
+	int				mux_id;
+	int				ret = 0;
+
+	unet_offset = dev->driver_info->data * no_rmnet_insts_per_dev;
+	stats = &rx_stats[unet_offset + dev->data[3]];
+
+	while (skb->len) {
+		mux_id = rmnet_usb_data_dmux(skb, &pkt_len, &frame_len);
 		if (mux_id < 0) {
-			/*resubmit urb and free skb in rx_complete*/
-			rx_urb->status = -EINVAL;
+			/* no way to find the next header */
+			stats->dmux_errors++;
+			break;
+		}
+
+		unet = unet_list[unet_offset + mux_id];
+		if (frame_len == skb->len) {
+			frame = skb;
 		} else {
-			/*map urb to actual network iface based on mux id*/
-			unet_id = unet_offset + mux_id;
-			skb->dev = unet_list[unet_id]->net;
+			frame = skb_clone(skb, GFP_ATOMIC);
+			skb_pull(skb, frame_len);
+			if (!frame) {
+				dev->net->stats.rx_dropped++;
+				continue;
+			}
+		}
+
+		skb_pull(frame, sizeof(struct mux_hdr));
+		skb_trim(frame, pkt_len);
+		if (!unet || rmnet_usb_rx_protocol(unet, frame)) {
+			stats->dmux_errors++;
+			if (frame == skb)
+				break;
+			dev_kfree_skb_any(frame);
+			continue;
 		}
+		frame->dev = unet->net;
+		n++;
+
+		DBG1("[%s] Rx packet #%lu len=%d\n",
+			unet->net->name, dev->net->stats.rx_packets,
+			frame->len);
+
+		if (frame == skb) {
+			ret = 1;
+			break;
+		}
+		usbnet_skb_return(dev, frame);
 	}
 
-	rx_complete(rx_urb);
+	stats->frames += n;
+	if (n > 1)
+		stats->aggr_urbs++;
+	if (n > stats->max_frames)
+		stats->max_frames = n;
+
+	return ret;
 }
 
 static int rmnet_usb_rx_fixup(struct usbnet *dev, struct sk_buff *skb)
 {
+	if (dev->data[4])
+		return rmnet_usb_data_deaggregate(dev, skb);
+
 	if (test_bit(RMNET_MODE_LLP_IP, &dev->data[0]))
 		skb->protocol = rmnet_ip_type_trans(skb);
 	else /*set zero for eth mode*/
@@ -603,6 +707,16 @@ static int rmnet_usb_data_status(struct seq_file *s, void *unused)
 			unet->net->stats.rx_length_errors);
 	seq_printf(s, "rx packets:         %lu\n", unet->net->stats.rx_packets);
 	seq_printf(s, "rx bytes:           %lu\n", unet->net->stats.rx_bytes);
+	if (unet->data[4]) {
+		struct rmnet_usb_rx_stats *stats = &rx_stats[unet->data[3] +
+			unet->driver_info->data * no_rmnet_insts_per_dev];
+
+		seq_printf(s, "rx mux frames:      %lu\n", stats->frames);
+		seq_printf(s, "rx aggregated urbs: %lu\n", stats->aggr_urbs);
+		seq_printf(s, "rx max frames/urb:  %u\n", stats->max_frames);
+		seq_printf(s, "rx dmux errors:     %lu\n", stats->dmux_errors);
+	}
+	seq_printf(s, "rx NAPI/GRO:        %d\n", unet->rx_napi);
 	seq_printf(s, "tx skb q len:       %u\n", unet->txq.qlen);
 	seq_printf(s, "tx errors:          %lu\n", unet->net->stats.tx_errors);
 	seq_printf(s, "tx packets:         %lu\n", unet->net->stats.tx_packets);
@@ -711,6 +825,7 @@ static int rmnet_usb_probe(struct usb_interface *iface,
 
 		/*store mux id for later access*/
 		unet->data[3] = n;
+		memset(&rx_stats[unet_id], 0, sizeof(rx_stats[unet_id]));
 
 		/*save mux info for control and usbnet devices*/
 		unet->data[1] = unet->data[4] = mux;
@@ -800,22 +915,20 @@ static void rmnet_usb_disconnect(struct usb_interface *intf)
 
 static struct driver_info rmnet_info = {
 	.description   = "RmNET net device",
-	.flags         = FLAG_SEND_ZLP,
+	.flags         = FLAG_SEND_ZLP | FLAG_RX_NAPI,
 	.bind          = rmnet_usb_bind,
 	.tx_fixup      = rmnet_usb_tx_fixup,
 	.rx_fixup      = rmnet_usb_rx_fixup,
-	.rx_complete   = rmnet_usb_rx_complete,
 	.manage_power  = rmnet_usb_manage_power,
 	.data          = 0,
 };
 
 static struct driver_info rmnet_usb_info = {
 	.description   = "RmNET net device",
-	.flags         = FLAG_SEND_ZLP,
+	.flags         = FLAG_SEND_ZLP | FLAG_RX_NAPI,
 	.bind          = rmnet_usb_bind,
 	.tx_fixup      = rmnet_usb_tx_fixup,
 	.rx_fixup      = rmnet_usb_rx_fixup,
-	.rx_complete   = rmnet_usb_rx_complete,
 	.manage_power  = rmnet_usb_manage_power,
 	.data          = 1,
 };
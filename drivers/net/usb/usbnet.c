@@ -95,6 +95,13 @@ static int msg_level = -1;
 module_param (msg_level, int, 0);
 MODULE_PARM_DESC (msg_level, "Override default message level");
 
+/* drivers flagged FLAG_RX_NAPI poll rx from NAPI unless this is cleared */
+static bool rx_napi = true;
+module_param(rx_napi, bool, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(rx_napi, "Use NAPI and GRO for rx when the driver allows it");
+
+#define USBNET_NAPI_WEIGHT	64
+
 /*-------------------------------------------------------------------------*/
 
 /* handles CDC Ethernet and many other network "bulk data" interfaces */
@@ -249,7 +256,17 @@ void usbnet_skb_return (struct usbnet *dev, struct sk_buff *skb)
 	if (skb_defer_rx_timestamp(skb))
 		return;
 
-	status = netif_rx_ni(skb);
+	/* rx_fixup() and rx_process() run from usbnet_poll(); paused
+	 * packets replayed by usbnet_resume_rx() still take netif_rx.
+	 */
+	if (dev->rx_napi && in_serving_softirq()) {
+		if (napi_gro_receive(&dev->napi, skb) == GRO_DROP)
+			status = NET_RX_DROP;
+		else
+			status = NET_RX_SUCCESS;
+	} else {
+		status = netif_rx_ni(skb);
+	}
 	if (status != NET_RX_SUCCESS)
 		netif_dbg(dev, rx_err, dev->net,
 			  "netif_rx status %d\n", status);
@@ -318,8 +335,12 @@ static enum skb_state defer_bh(struct usbnet *dev, struct sk_buff *skb,
 	spin_unlock(&list->lock);
 	spin_lock(&dev->done.lock);
 	__skb_queue_tail(&dev->done, skb);
-	if (dev->done.qlen == 1)
-		queue_work(usbnet_wq, &dev->bh_w);
+	if (dev->done.qlen == 1) {
+		if (dev->rx_napi)
+			napi_schedule(&dev->napi);
+		else
+			queue_work(usbnet_wq, &dev->bh_w);
+	}
 	spin_unlock_irqrestore(&dev->done.lock, flags);
 	return old_state;
 }
@@ -352,7 +373,7 @@ static int rx_submit (struct usbnet *dev, struct urb *urb, gfp_t flags)
 	unsigned long		lockflags;
 	size_t			size = dev->rx_urb_size;
 
-	skb = __netdev_alloc_skb_ip_align(dev->net, size, flags);
+	skb = __netdev_alloc_skb_recycle_ip_align(dev->net, size, flags);
 	if (!skb) {
 		netif_dbg(dev, rx_err, dev->net, "no rx skb\n");
 		usbnet_defer_kevent (dev, EVENT_RX_MEMORY);
@@ -729,6 +750,8 @@ int usbnet_stop (struct net_device *net)
 	dev->flags = 0;
 	del_timer_sync (&dev->delay);
 	cancel_work_sync(&dev->bh_w);
+	if (dev->rx_napi)
+		napi_disable(&dev->napi);
 	if (info->manage_power)
 		info->manage_power(dev, 0);
 	else
@@ -801,11 +824,16 @@ int usbnet_open (struct net_device *net)
 		   "simple");
 
 	// delay posting reads until we're fully open
+	if (dev->rx_napi)
+		napi_enable(&dev->napi);
 	queue_work(usbnet_wq, &dev->bh_w);
 	if (info->manage_power) {
 		retval = info->manage_power(dev, 1);
-		if (retval < 0)
+		if (retval < 0) {
+			if (dev->rx_napi)
+				napi_disable(&dev->napi);
 			goto done;
+		}
 		usb_autopm_put_interface(dev->intf);
 	}
 	return retval;
@@ -1213,20 +1241,21 @@ EXPORT_SYMBOL_GPL(usbnet_start_xmit);
 
 /*-------------------------------------------------------------------------*/
 
-// tasklet (work deferred from completions, in_irq) or timer
+// drain completed urbs, up to budget rx buffers; returns how many were seen
 
-static void usbnet_bh (unsigned long param)
+static int usbnet_bh_done(struct usbnet *dev, int budget)
 {
-	struct usbnet		*dev = (struct usbnet *) param;
 	struct sk_buff		*skb;
 	struct skb_data		*entry;
+	int			work = 0;
 
-	while ((skb = skb_dequeue (&dev->done))) {
+	while (work < budget && (skb = skb_dequeue (&dev->done))) {
 		entry = (struct skb_data *) skb->cb;
 		switch (entry->state) {
 		case rx_done:
 			entry->state = rx_cleanup;
 			rx_process (dev, skb);
+			work++;
 			continue;
 		case tx_done:
 		case rx_cleanup:
@@ -1237,7 +1266,11 @@ static void usbnet_bh (unsigned long param)
 			netdev_dbg(dev->net, "bogus skb state %d\n", entry->state);
 		}
 	}
+	return work;
+}
 
+static void usbnet_bh_refill(struct usbnet *dev)
+{
 	// waiting for all pending urbs to complete?
 	if (dev->wait) {
 		if ((dev->txq.qlen + dev->rxq.qlen + dev->done.qlen) == 0) {
@@ -1277,6 +1310,42 @@ static void usbnet_bh (unsigned long param)
 	}
 }
 
+// work (deferred from completions, in_irq) or timer
+
+static void usbnet_bh (unsigned long param)
+{
+	struct usbnet		*dev = (struct usbnet *) param;
+
+	// with NAPI, usbnet_poll() does it all
+	if (dev->rx_napi) {
+		local_bh_disable();
+		napi_schedule(&dev->napi);
+		local_bh_enable();
+		return;
+	}
+
+	usbnet_bh_done(dev, INT_MAX);
+	usbnet_bh_refill(dev);
+}
+
+static int usbnet_poll(struct napi_struct *napi, int budget)
+{
+	struct usbnet		*dev = container_of(napi, struct usbnet, napi);
+	int			work;
+
+	work = usbnet_bh_done(dev, budget);
+	if (work < budget) {
+		napi_complete(napi);
+		/* defer_bh() only schedules on an empty -> non-empty
+		 * transition, which may have raced with napi_complete()
+		 */
+		if (!skb_queue_empty(&dev->done))
+			napi_schedule(napi);
+		usbnet_bh_refill(dev);
+	}
+	return work;
+}
+
 static void usbnet_bh_w(struct work_struct *work)
 {
 	struct usbnet		*dev =
@@ -1412,6 +1481,10 @@ usbnet_probe (struct usb_interface *udev, const struct usb_device_id *prod)
 	dev->delay.data = (unsigned long) dev;
 	init_timer (&dev->delay);
 	mutex_init (&dev->phy_mutex);
+	if ((info->flags & FLAG_RX_NAPI) && rx_napi) {
+		netif_napi_add(net, &dev->napi, usbnet_poll, USBNET_NAPI_WEIGHT);
+		dev->rx_napi = true;
+	}
 
 	dev->net = net;
 	strcpy (net->name, "usb%d");
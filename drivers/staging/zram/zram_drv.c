@@ -42,6 +42,8 @@
 #define LZO_COMP_LEN 3
 #define LZ4_COMP "lz4"
 #define LZ4_COMP_LEN 3
+#define LZ4HC_COMP "lz4hc"
+#define LZ4HC_COMP_LEN 5
 #endif
 
 /* Globals */
@@ -162,10 +164,32 @@ static ssize_t comp_func_show(struct device *dev,
 	struct zram *zram = dev_to_zram(dev);
 
 	if (zram->lz4 == true)
-		return sprintf(buf, "%s\n", LZ4_COMP);
+		return sprintf(buf, "%s\n",
+				zram->lz4hc ? LZ4HC_COMP : LZ4_COMP);
 
 	return sprintf(buf, "%s\n", LZO_COMP);
 }
+
+static ssize_t comp_level_show(struct device *dev,
+    struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+
+	return sprintf(buf, "%d\n", zram->comp_level);
+}
+
+static size_t zram_workmem_size(struct zram *zram)
+{
+	if (zram->lz4 == true && zram->lz4hc)
+		return LZ4HC_MEM_COMPRESS;
+
+	return max_t(size_t, LZO1X_MEM_COMPRESS, LZ4_MEM_COMPRESS);
+}
+#else
+static size_t zram_workmem_size(struct zram *zram)
+{
+	return LZO1X_MEM_COMPRESS;
+}
 #endif
 
 static int zram_test_flag(struct zram_meta *meta, u32 index,
@@ -218,20 +242,21 @@ static inline int valid_io_request(struct zram *zram, struct bio *bio)
 static void zram_meta_free(struct zram_meta *meta)
 {
 	zs_destroy_pool(meta->mem_pool);
-	kfree(meta->compress_workmem);
+	vfree(meta->compress_workmem);
 	free_pages((unsigned long)meta->compress_buffer, 1);
 	vfree(meta->table);
 	kfree(meta);
 }
 
-static struct zram_meta *zram_meta_alloc(u64 disksize)
+static struct zram_meta *zram_meta_alloc(u64 disksize, size_t workmem_size)
 {
 	size_t num_pages;
 	struct zram_meta *meta = kmalloc(sizeof(*meta), GFP_KERNEL);
 	if (!meta)
 		goto out;
 
-	meta->compress_workmem = kzalloc(LZO1X_MEM_COMPRESS, GFP_KERNEL);
+	/* LZ4HC needs 256K of hash chains, too much for kmalloc */
+	meta->compress_workmem = vzalloc(workmem_size);
 	if (!meta->compress_workmem)
 		goto free_meta;
 
@@ -263,7 +288,7 @@ free_table:
 free_buffer:
 	free_pages((unsigned long)meta->compress_buffer, 1);
 free_workmem:
-	kfree(meta->compress_workmem);
+	vfree(meta->compress_workmem);
 free_meta:
 	kfree(meta);
 	meta = NULL;
@@ -488,9 +513,15 @@ static int zram_bvec_write(struct zram *zram, struct bio_vec *bvec, u32 index,
 		zram_free_page(zram, index);
 
 #ifdef CONFIG_LZ4_COMPRESS
-	if (zram->lz4 == true)
-		ret = lz4_compress(uncmem, PAGE_SIZE, src, &clen,
-					meta->compress_workmem);
+	if (zram->lz4 == true && zram->lz4hc)
+		ret = lz4hc_compress_level(uncmem, PAGE_SIZE, src, &clen,
+					meta->compress_workmem,
+					zram->comp_level ?: LZ4HC_MID_LEVEL);
+	else if (zram->lz4 == true)
+		ret = lz4_compress_fast(uncmem, PAGE_SIZE, src, &clen,
+					meta->compress_workmem,
+					zram->comp_level ?:
+					LZ4_ACCELERATION_DEFAULT);
 	else
 #endif
 		ret = lzo1x_1_compress(uncmem, PAGE_SIZE, src, &clen,
@@ -667,17 +698,20 @@ static ssize_t disksize_store(struct device *dev,
 		return -EINVAL;
 
 	disksize = PAGE_ALIGN(disksize);
-	meta = zram_meta_alloc(disksize);
-	if (!meta)
-		return -ENOMEM;
+	/* the workmem is sized for comp_func, which is stable under init_lock */
 	down_write(&zram->init_lock);
 	if (zram->init_done) {
 		up_write(&zram->init_lock);
-		zram_meta_free(meta);
 		pr_info("Cannot change disksize for initialized device\n");
 		return -EBUSY;
 	}
 
+	meta = zram_meta_alloc(disksize, zram_workmem_size(zram));
+	if (!meta) {
+		up_write(&zram->init_lock);
+		return -ENOMEM;
+	}
+
 	zram->disksize = disksize;
 	set_capacity(zram->disk, zram->disksize >> SECTOR_SHIFT);
 	zram_init_device(zram, meta);
@@ -739,11 +773,17 @@ static ssize_t comp_func_store(struct device *dev,
 	if (zram->init_done)
 		goto fail_store;
 
-	if (!strncmp(buf, LZ4_COMP, LZ4_COMP_LEN))
+	/* "lz4" is a prefix of "lz4hc", test the longer name first */
+	if (!strncmp(buf, LZ4HC_COMP, LZ4HC_COMP_LEN)) {
+		zram->lz4 = true;
+		zram->lz4hc = true;
+	} else if (!strncmp(buf, LZ4_COMP, LZ4_COMP_LEN)) {
 		zram->lz4 = true;
-	else if (!strncmp(buf, LZO_COMP, LZO_COMP_LEN))
+		zram->lz4hc = false;
+	} else if (!strncmp(buf, LZO_COMP, LZO_COMP_LEN)) {
 		zram->lz4 = false;
-	else
+		zram->lz4hc = false;
+	} else
 		goto fail_store;
 
   ret = len;
@@ -752,6 +792,34 @@ fail_store:
   up_write(&zram->init_lock);
   return ret;
 }
+
+/*
+ * Acceleration factor for lz4, or level for lz4hc; 0 selects the default
+ * of the current comp_func. Only used for new writes, so it may be changed
+ * on an initialized device.
+ */
+static ssize_t comp_level_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	int level, ret;
+
+	ret = kstrtoint(buf, 10, &level);
+	if (ret)
+		return ret;
+	if (level < 0 || level > LZ4_ACCELERATION_MAX)
+		return -EINVAL;
+
+	down_write(&zram->init_lock);
+	if (zram->lz4hc && level > LZ4HC_MAX_LEVEL) {
+		up_write(&zram->init_lock);
+		return -EINVAL;
+	}
+	zram->comp_level = level;
+	up_write(&zram->init_lock);
+
+	return len;
+}
 #endif
 
 static void __zram_make_request(struct zram *zram, struct bio *bio, int rw)
@@ -891,6 +959,8 @@ static DEVICE_ATTR(mem_used_total, S_IRUGO, mem_used_total_show, NULL);
 #ifdef CONFIG_LZ4_COMPRESS
 static DEVICE_ATTR(comp_func, S_IRUGO | S_IWUSR,
 		comp_func_show, comp_func_store);
+static DEVICE_ATTR(comp_level, S_IRUGO | S_IWUSR,
+		comp_level_show, comp_level_store);
 #endif
 
 static struct attribute *zram_disk_attrs[] = {
@@ -907,6 +977,7 @@ static struct attribute *zram_disk_attrs[] = {
 	&dev_attr_mem_used_total.attr,
 #ifdef CONFIG_LZ4_COMPRESS
 	&dev_attr_comp_func.attr,
+	&dev_attr_comp_level.attr,
 #endif
 	NULL,
 };
@@ -124,6 +124,8 @@ struct zram {
 #ifdef CONFIG_LZ4_COMPRESS
   /*if lz4 compress is used as zram compress function, lz4 is true*/
 	bool lz4;
+	bool lz4hc;	/* lz4 set too, compress with lz4hc_compress_level */
+	int comp_level;	/* lz4 acceleration or lz4hc level, 0 for default */
 #endif
 };
 #endif
@@ -12,6 +12,19 @@
 #define LZ4_MEM_COMPRESS	(4096 * sizeof(unsigned char *))
 #define LZ4HC_MEM_COMPRESS	(65538 * sizeof(unsigned char *))
 
+/* Range of the lz4_compress_fast() acceleration factor */
+#define LZ4_ACCELERATION_DEFAULT	1
+#define LZ4_ACCELERATION_MAX		65537
+
+/*
+ * Range of the lz4hc_compress_level() level, each one doubling the number
+ * of match candidates examined. LZ4HC_MAX_LEVEL is what lz4hc_compress()
+ * uses, the lower ones sit between LZ4 and full LZ4HC in speed and ratio.
+ */
+#define LZ4HC_MIN_LEVEL		1
+#define LZ4HC_MID_LEVEL		4
+#define LZ4HC_MAX_LEVEL		9
+
 /*
  * lz4_compressbound()
  * Provides the maximum size that LZ4 may output in a "worst case" scenario
@@ -39,6 +52,17 @@ static inline size_t lz4_compressbound(size_t isize)
 int lz4_compress(const unsigned char *src, size_t src_len,
 		unsigned char *dst, size_t *dst_len, void *wrkmem);
 
+/*
+ * lz4_compress_fast()
+ *	Same as lz4_compress(), with an acceleration factor between
+ *	LZ4_ACCELERATION_DEFAULT and LZ4_ACCELERATION_MAX. Larger values
+ *	search less and compress faster, at the cost of ratio. Out of range
+ *	values are clamped.
+ */
+int lz4_compress_fast(const unsigned char *src, size_t src_len,
+		unsigned char *dst, size_t *dst_len, void *wrkmem,
+		int acceleration);
+
  /*
   * lz4hc_compress()
   *	 src	 : source address of the original data
@@ -56,6 +80,14 @@ int lz4_compress(const unsigned char *src, size_t src_len,
 int lz4hc_compress(const unsigned char *src, size_t src_len,
 		unsigned char *dst, size_t *dst_len, void *wrkmem);
 
+/*
+ * lz4hc_compress_level()
+ *	Same as lz4hc_compress(), with a level between LZ4HC_MIN_LEVEL and
+ *	LZ4HC_MAX_LEVEL. Out of range values are clamped.
+ */
+int lz4hc_compress_level(const unsigned char *src, size_t src_len,
+		unsigned char *dst, size_t *dst_len, void *wrkmem, int level);
+
 /*
  * lz4_decompress()
  *	src     : source address of the compressed data
@@ -70,6 +102,15 @@ int lz4hc_compress(const unsigned char *src, size_t src_len,
 int lz4_decompress(const unsigned char *src, size_t *src_len,
 		unsigned char *dest, size_t actual_dest_len);
 
+#ifdef CONFIG_LZ4_DECOMPRESS_NEON
+/*
+ * lz4_decompress_generic()
+ *	Same as lz4_decompress(), but never uses the NEON copy kernels.
+ */
+int lz4_decompress_generic(const unsigned char *src, size_t *src_len,
+		unsigned char *dest, size_t actual_dest_len);
+#endif
+
 /*
  * lz4_decompress_unknownoutputsize()
  *	src     : source address of the compressed data
@@ -27,6 +27,12 @@ int lzo1x_1_compress(const unsigned char *src, size_t src_len,
 int lzo1x_decompress_safe(const unsigned char *src, size_t src_len,
 			  unsigned char *dst, size_t *dst_len);
 
+#ifdef CONFIG_LZO_DECOMPRESS_NEON
+/* the plain C decompressor, bypassing the NEON copy kernels */
+int lzo1x_decompress_safe_generic(const unsigned char *src, size_t src_len,
+				  unsigned char *dst, size_t *dst_len);
+#endif
+
 /*
  * Return values (< 0 = Error)
  */
@@ -7,6 +7,7 @@
 #define ADRENO_DEVFREQ_NOTIFY_SUBMIT	1
 #define ADRENO_DEVFREQ_NOTIFY_RETIRE	2
 #define ADRENO_DEVFREQ_NOTIFY_IDLE	3
+#define ADRENO_DEVFREQ_NOTIFY_FRAME	4
 
 struct device;
 
@@ -52,6 +53,25 @@ struct devfreq_conservative_data {
 	} bin;
 };
 
+/**
+ * struct adreno_frame_stats - GPU timing of one frame
+ * @devfreq: devfreq instance of the GPU
+ * @start: time in usecs the GPU started on the frame
+ * @end: time in usecs the command batch that ended the frame retired
+ * @busy: usecs the GPU spent on the command batches of the frame
+ * @freq: GPU frequency when the frame retired
+ *
+ * Data of ADRENO_DEVFREQ_NOTIFY_FRAME, sent for every command batch
+ * submitted with KGSL_CONTEXT_END_OF_FRAME.
+ */
+struct adreno_frame_stats {
+	struct devfreq *devfreq;
+	s64 start;
+	s64 end;
+	s64 busy;
+	unsigned long freq;
+};
+
 struct msm_adreno_extended_profile {
 	struct devfreq_msm_adreno_tz_data *private_data;
 	struct devfreq_dev_profile profile;
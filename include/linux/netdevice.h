@@ -217,6 +217,7 @@ enum {
 #ifdef CONFIG_RPS
 #include <linux/static_key.h>
 extern struct static_key rps_needed;
+extern int netdev_rps_auto;
 #endif
 
 struct neighbour;
@@ -1733,6 +1734,10 @@ struct softnet_data {
 	unsigned int		time_squeeze;
 	unsigned int		cpu_collision;
 	unsigned int		received_rps;
+	unsigned int		backlog_max;	/* input_pkt_queue high mark */
+	unsigned int		rps_steered;	/* sent to other cpus by rps */
+	unsigned int		rps_auto_picks;	/* flows (re)assigned a cpu */
+	unsigned int		rps_auto_wakes;	/* ... of which to an idle cpu */
 
 #ifdef CONFIG_RPS
 	struct softnet_data	*rps_ipi_list;
@@ -48,6 +48,18 @@
  * For the sched_{set,get}attr() calls
  */
 #define SCHED_FLAG_RESET_ON_FORK	0x01
+#define SCHED_FLAG_RECLAIM		0x02
+#define SCHED_FLAG_LATENCY_NICE		0x04
+
+/*
+ * Range of sched_attr::sched_latency_nice, a hint of how sensitive a
+ * fair task is to scheduling latency: negative values ask for quicker
+ * wakeup preemption and idle cpus, positive ones accept longer waits
+ * in exchange for longer slices.
+ */
+#define MIN_LATENCY_NICE	-20
+#define MAX_LATENCY_NICE	19
+#define LATENCY_NICE_WIDTH	(MAX_LATENCY_NICE - MIN_LATENCY_NICE + 1)
 
 #ifdef __KERNEL__
 
@@ -102,6 +114,7 @@ struct sched_param {
 #include <asm/processor.h>
 
 #define SCHED_ATTR_SIZE_VER0	48	/* sizeof first published struct */
+#define SCHED_ATTR_SIZE_VER1	56	/* add: latency_nice (+ padding) */
 
 /*
  * Extended scheduling parameters data structure.
@@ -139,6 +152,9 @@ struct sched_param {
  *  @sched_runtime	representative of the task's runtime
  *  @sched_period	representative of the task's period
  *
+ *  @sched_latency_nice	latency sensitivity hint (SCHED_NORMAL/BATCH),
+ *			only applied with SCHED_FLAG_LATENCY_NICE
+ *
  * Given this task model, there are a multiplicity of scheduling algorithms
  * and policies, that can be used to ensure all the tasks will make their
  * timing constraints.
@@ -163,6 +179,9 @@ struct sched_attr {
 	u64 sched_runtime;
 	u64 sched_deadline;
 	u64 sched_period;
+
+	/* SCHED_NORMAL, SCHED_BATCH */
+	s32 sched_latency_nice;
 };
 
 struct exec_domain;
@@ -846,6 +865,10 @@ struct sched_info {
 	/* timestamps */
 	unsigned long long last_arrival,/* when we last ran on a cpu */
 			   last_queued;	/* when we were last queued to run */
+#ifdef CONFIG_SCHEDSTATS
+	unsigned long long last_wakeup,	/* when we were last woken up */
+			   wait_carry;	/* wait accrued on previous rqs */
+#endif
 };
 #endif /* defined(CONFIG_SCHEDSTATS) || defined(CONFIG_TASK_DELAY_ACCT) */
 
@@ -1130,6 +1153,13 @@ struct sched_statistics {
 	u64			nr_wakeups_affine_attempts;
 	u64			nr_wakeups_passive;
 	u64			nr_wakeups_idle;
+
+	u64			nr_dl_throttled;
+	u64			nr_dl_overruns;
+	u64			nr_dl_deadline_misses;
+	u64			dl_runtime_used;
+	u64			dl_runtime_reserved;
+	u64			dl_runtime_reclaimed;
 };
 #endif
 
@@ -1175,6 +1205,8 @@ struct sched_entity {
 
 	u64			nr_migrations;
 
+	int			latency_nice;
+
 #ifdef CONFIG_SCHEDSTATS
 	struct sched_statistics statistics;
 #endif
@@ -1253,14 +1285,31 @@ struct sched_dl_entity {
 	 *
 	 * @dl_yielded tells if task gave up the cpu before consuming
 	 * all its available runtime during the last job.
+	 *
+	 * @dl_non_contending tells if the task blocked but its bandwidth
+	 * is still accounted as active, until the 0-lag time is reached
+	 * and inactive_timer fires.
 	 */
 	int dl_throttled, dl_new, dl_boosted, dl_yielded;
+	int dl_non_contending;
+
+	/*
+	 * Bandwidth this entity currently contributes to the running_bw
+	 * of its runqueue (zero when inactive), used for reclaiming.
+	 */
+	u64 dl_active_bw;
 
 	/*
 	 * Bandwidth enforcement timer. Each -deadline task has its
 	 * own bandwidth to be enforced, thus we need one timer per task.
 	 */
 	struct hrtimer dl_timer;
+
+	/*
+	 * Inactive timer, fires at the 0-lag time of a blocked task and
+	 * removes its bandwidth from the runqueue's active utilization.
+	 */
+	struct hrtimer inactive_timer;
 };
 
 struct rcu_node;
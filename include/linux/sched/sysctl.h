@@ -66,6 +66,7 @@ extern unsigned int sysctl_sched_downmigrate_pct;
 extern int sysctl_sched_upmigrate_min_nice;
 extern unsigned int sysctl_sched_powerband_limit_pct;
 extern unsigned int sysctl_sched_boost;
+extern unsigned int sysctl_sched_energy_aware;
 
 #else /* CONFIG_SCHED_HMP */
 
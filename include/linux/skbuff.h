@@ -230,16 +230,25 @@ enum {
 
 	/* generate wifi status information (where possible) */
 	SKBTX_WIFI_STATUS = 1 << 4,
+
+	/* zero-copy frags belong to a MSG_ZEROCOPY send and may be shared */
+	SKBTX_SOCK_ZEROCOPY = 1 << 5,
 };
 
 /*
  * The callback notifies userspace to release buffers when skb DMA is done in
  * lower device, the skb last reference should be 0 when calling this.
+ * zerocopy_success is false when the frags had to be copied into kernel
+ * pages first (see skb_copy_ubufs()).
  * The ctx field is used to track device context.
  * The desc field is used to track userspace buffer index.
+ *
+ * For MSG_ZEROCOPY sends (SKBTX_SOCK_ZEROCOPY) ctx is the sending socket,
+ * desc the notification id, and one ubuf_info is shared by all the skbs
+ * of a send call; see sock_zerocopy_alloc().
  */
 struct ubuf_info {
-	void (*callback)(struct ubuf_info *);
+	void (*callback)(struct ubuf_info *, bool zerocopy_success);
 	void *ctx;
 	unsigned long desc;
 };
@@ -368,6 +377,7 @@ typedef unsigned char *sk_buff_data_t;
  *	@wifi_acked_valid: wifi_acked was set
  *	@wifi_acked: whether frame was acked on wifi or not
  *	@no_fcs:  Request NIC to treat last 4 bytes as Ethernet FCS
+ *	@rx_recycle: buffer goes back to the skb recycle pool when freed
  *	@dma_cookie: a cookie to one of several possible DMA operations
  *		done by skb DMA functions
  *	@secmark: security marking
@@ -467,7 +477,8 @@ struct sk_buff {
 	__u8			wifi_acked_valid:1;
 	__u8			wifi_acked:1;
 	__u8			no_fcs:1;
-	/* 9/11 bit hole (depending on ndisc_nodetype presence) */
+	__u8			rx_recycle:1;
+	/* 8/10 bit hole (depending on ndisc_nodetype presence) */
 	kmemcheck_bitfield_end(flags2);
 
 #ifdef CONFIG_NET_DMA
@@ -577,6 +588,15 @@ extern bool skb_recycle_check(struct sk_buff *skb, int skb_size);
 
 extern struct sk_buff *skb_morph(struct sk_buff *dst, struct sk_buff *src);
 extern int skb_copy_ubufs(struct sk_buff *skb, gfp_t gfp_mask);
+extern struct ubuf_info *sock_zerocopy_alloc(struct sock *sk);
+extern void sock_zerocopy_put(struct ubuf_info *uarg, bool zerocopy);
+extern void sock_zerocopy_put_abort(struct ubuf_info *uarg);
+extern int skb_zerocopy_from_user(struct sk_buff *skb,
+				  const void __user *from, int len,
+				  struct ubuf_info *uarg);
+extern int skb_zerocopy_from_iovec(struct sk_buff *skb,
+				   const struct iovec *iov, int offset,
+				   int len, struct ubuf_info *uarg);
 extern struct sk_buff *skb_clone(struct sk_buff *skb,
 				 gfp_t priority);
 extern struct sk_buff *skb_copy(const struct sk_buff *skb,
@@ -1673,6 +1693,19 @@ static inline void skb_orphan(struct sk_buff *skb)
 	skb->sk		= NULL;
 }
 
+/**
+ *	skb_zerocopy_shared - frags are pinned pages of a MSG_ZEROCOPY send
+ *	@skb: buffer to check
+ *
+ *	Such frags may be shared by clones and copies of the skb for as long
+ *	as each of them holds a reference on the send's ubuf_info, so that
+ *	the sender is only told once the last one is gone.
+ */
+static inline bool skb_zerocopy_shared(const struct sk_buff *skb)
+{
+	return skb_shinfo(skb)->tx_flags & SKBTX_SOCK_ZEROCOPY;
+}
+
 /**
  *	skb_orphan_frags - orphan the frags contained in a buffer
  *	@skb: buffer to orphan frags from
@@ -1680,9 +1713,28 @@ static inline void skb_orphan(struct sk_buff *skb)
  *
  *	For each frag in the SKB which needs a destructor (i.e. has an
  *	owner) create a copy of that frag and release the original
- *	page by calling the destructor.
+ *	page by calling the destructor. MSG_ZEROCOPY frags are left alone,
+ *	they stay valid until the last skb sharing them is freed.
  */
 static inline int skb_orphan_frags(struct sk_buff *skb, gfp_t gfp_mask)
+{
+	if (likely(!(skb_shinfo(skb)->tx_flags & SKBTX_DEV_ZEROCOPY)))
+		return 0;
+	if (skb_zerocopy_shared(skb))
+		return 0;
+	return skb_copy_ubufs(skb, gfp_mask);
+}
+
+/**
+ *	skb_orphan_frags_rx - orphan the frags of a buffer being received
+ *	@skb: buffer to orphan frags from
+ *	@gfp_mask: allocation mask for replacement pages
+ *
+ *	Like skb_orphan_frags(), but for a buffer about to be queued to a
+ *	local receiver, which may hold it for an unbounded time: user pages
+ *	are always copied.
+ */
+static inline int skb_orphan_frags_rx(struct sk_buff *skb, gfp_t gfp_mask)
 {
 	if (likely(!(skb_shinfo(skb)->tx_flags & SKBTX_DEV_ZEROCOPY)))
 		return 0;
@@ -1766,6 +1818,41 @@ static inline struct sk_buff *netdev_alloc_skb_ip_align(struct net_device *dev,
 	return __netdev_alloc_skb_ip_align(dev, length, GFP_ATOMIC);
 }
 
+#ifdef CONFIG_SKB_RECYCLE
+extern struct sk_buff *__netdev_alloc_skb_recycle(struct net_device *dev,
+		unsigned int length, gfp_t gfp_mask);
+extern bool skb_recycle_put(struct sk_buff *skb);
+extern void skb_recycle_drain(void);
+extern int sysctl_skb_recycle_max;
+#else
+static inline struct sk_buff *__netdev_alloc_skb_recycle(struct net_device *dev,
+		unsigned int length, gfp_t gfp_mask)
+{
+	return __netdev_alloc_skb(dev, length, gfp_mask);
+}
+#endif
+
+/**
+ *	__netdev_alloc_skb_recycle_ip_align - rx skbuff from the recycle pool
+ *	@dev: network device to receive on
+ *	@length: length to allocate
+ *	@gfp: get_free_pages mask, passed to alloc_skb
+ *
+ *	Like __netdev_alloc_skb_ip_align(), but the buffer comes from and
+ *	returns to a per-cpu pool when CONFIG_SKB_RECYCLE is set. Meant for
+ *	drivers that allocate one linear buffer per received frame.
+ */
+static inline struct sk_buff *__netdev_alloc_skb_recycle_ip_align(
+		struct net_device *dev, unsigned int length, gfp_t gfp)
+{
+	struct sk_buff *skb;
+
+	skb = __netdev_alloc_skb_recycle(dev, length + NET_IP_ALIGN, gfp);
+	if (NET_IP_ALIGN && skb)
+		skb_reserve(skb, NET_IP_ALIGN);
+	return skb;
+}
+
 /**
  * skb_frag_page - retrieve the page refered to by a paged fragment
  * @frag: the paged fragment
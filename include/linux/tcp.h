@@ -106,6 +106,7 @@ enum {
 #define TCP_THIN_LINEAR_TIMEOUTS 16      /* Use linear timeouts for thin streams*/
 #define TCP_THIN_DUPACK         17      /* Fast retrans. after 1 dupack */
 #define TCP_USER_TIMEOUT	18	/* How long for loss retry before timeout */
+#define TCP_FASTOPEN		23	/* Enable FastOpen on listeners */
 
 /* for TCP_INFO socket option */
 #define TCPI_OPT_TIMESTAMPS	1
@@ -209,6 +210,7 @@ struct tcp_cookie_transactions {
 
 #include <linux/skbuff.h>
 #include <linux/dmaengine.h>
+#include <linux/win_minmax.h>
 #include <net/sock.h>
 #include <net/inet_connection_sock.h>
 #include <net/inet_timewait_sock.h>
@@ -290,6 +292,22 @@ struct tcp_request_sock {
 	u32				rcv_isn;
 	u32				snt_isn;
 	u32				snt_synack; /* synack sent time */
+	u32				rcv_nxt; /* the ack # by SYNACK. For
+						  * FastOpen it's the seq#
+						  * after data-in-SYN.
+						  */
+	struct sock			*listener; /* needed for TFO */
+};
+
+/* TCP Fast Open */
+#define TCP_FASTOPEN_COOKIE_MIN	4	/* Min Fast Open Cookie size in bytes */
+#define TCP_FASTOPEN_COOKIE_MAX	16	/* Max Fast Open Cookie size in bytes */
+#define TCP_FASTOPEN_COOKIE_SIZE 8	/* the size employed by this impl. */
+
+/* TCP Fast Open Cookie as stored in memory */
+struct tcp_fastopen_cookie {
+	s8	len;
+	u8	val[TCP_FASTOPEN_COOKIE_MAX];
 };
 
 static inline struct tcp_request_sock *tcp_rsk(const struct request_sock *req)
@@ -390,6 +408,15 @@ struct tcp_sock {
 	u32	prr_delivered;	/* Number of newly delivered packets to
 				 * receiver in Recovery. */
 	u32	prr_out;	/* Total number of pkts sent during Recovery. */
+	u32	delivered;	/* Total data packets delivered incl. rexmits */
+	u32	lost;		/* Total data packets lost incl. rexmits */
+	u32	app_limited;	/* limited until "delivered" reaches this val */
+	u32	first_tx_us;	/* start of window send phase */
+	u32	delivered_us;	/* time we reached "delivered" */
+	u32	rate_delivered;    /* saved rate sample: packets delivered */
+	u32	rate_interval_us;  /* saved rate sample: time elapsed */
+	u8	rate_app_limited:1;  /* rate_{delivered,interval_us} limited? */
+	struct minmax rtt_min;	/* windowed min of RTT samples, in us */
 
  	u32	rcv_wnd;	/* Current receiver window		*/
 	u32	write_seq;	/* Tail(+1) of data held in tcp send buffer */
@@ -473,6 +500,19 @@ struct tcp_sock {
 	 * contains related tcp_cookie_transactions fields.
 	 */
 	struct tcp_cookie_values  *cookie_values;
+
+/* TCP Fast Open */
+	struct tcp_fastopen_request *fastopen_req; /* active open in progress */
+	/* fastopen_rsk points to the request_sock that resulted in this big
+	 * socket; it is kept until the handshake completes to retransmit
+	 * the SYN-ACK.
+	 */
+	struct request_sock *fastopen_rsk;
+	int	fastopen_max_qlen;	/* listener: TFO children allowed */
+	atomic_t fastopen_qlen;		/* listener: TFO children in SYN_RECV */
+	u8	syn_fastopen:1,	/* SYN includes Fast Open option */
+		syn_data:1,	/* SYN includes data */
+		syn_data_acked:1; /* data in SYN is acked by SYN-ACK */
 };
 
 static inline struct tcp_sock *tcp_sk(const struct sock *sk)
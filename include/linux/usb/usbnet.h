@@ -57,6 +57,8 @@ struct usbnet {
 	struct urb		*interrupt;
 	struct usb_anchor	deferred;
 	struct work_struct	bh_w;
+	struct napi_struct	napi;		/* rx poll, with FLAG_RX_NAPI */
+	bool			rx_napi;
 
 	struct work_struct	kevent;
 	unsigned long		flags;
@@ -107,6 +109,12 @@ struct driver_info {
 #define FLAG_MULTI_PACKET	0x2000
 #define FLAG_RX_ASSEMBLE	0x4000	/* rx packets may span >1 frames */
 
+/*
+ * Process completed rx urbs from a NAPI poll rather than the bh work, and
+ * hand packets to GRO.  rx_fixup() then runs in softirq context.
+ */
+#define FLAG_RX_NAPI	0x8000
+
 	/* init device ... can sleep, or cause probe() failure */
 	int	(*bind)(struct usbnet *, struct usb_interface *);
 
@@ -16,10 +16,19 @@
 #ifndef __activity_stats_h
 #define __activity_stats_h
 
+struct sock;
+struct sk_buff;
+
 #ifdef CONFIG_NET_ACTIVITY_STATS
 void activity_stats_update(void);
+void activity_stats_uid_rx(const struct sock *sk, const struct sk_buff *skb);
+void activity_stats_uid_tx(const struct sock *sk, const struct sk_buff *skb);
 #else
 #define activity_stats_update(void) {}
+static inline void activity_stats_uid_rx(const struct sock *sk,
+					 const struct sk_buff *skb) {}
+static inline void activity_stats_uid_tx(const struct sock *sk,
+					 const struct sk_buff *skb) {}
 #endif
 
 #endif /* _NET_ACTIVITY_STATS_H */
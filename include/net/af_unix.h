@@ -61,11 +61,23 @@ struct unix_sock {
 	unsigned int		gc_maybe_cycle : 1;
 	unsigned char		recursion_level;
 	struct socket_wq	peer_wq;
+	struct sk_buff_head	skb_cache;	/* sent datagrams, for reuse */
 };
 #define unix_sk(__sk) ((struct unix_sock *)__sk)
 
 #define peer_wait peer_wq.wait
 
+/*
+ * Datagrams between these sizes are sent in buffers from the skb_cache.
+ * Below UNIX_SKB_CACHE_MIN a cache sized head would inflate truesize, and
+ * with it the sk_sndbuf charge, well past what kmalloc() hands out anyway.
+ */
+#define UNIX_SKB_CACHE_SIZE	SKB_WITH_OVERHEAD(2048)
+#define UNIX_SKB_CACHE_MIN	SKB_WITH_OVERHEAD(1024)
+
+/* upper bound of net.unix.skb_cache */
+#define UNIX_SKB_CACHE_MAX	64
+
 long unix_inq_len(struct sock *sk);
 long unix_outq_len(struct sock *sk);
 
@@ -206,6 +206,7 @@ struct cg_proto;
   *	@sk_write_queue: Packet sending queue
   *	@sk_async_wait_queue: DMA copied packets
   *	@sk_omem_alloc: "o" is "option" or "other"
+  *	@sk_zckey: next MSG_ZEROCOPY notification id
   *	@sk_wmem_queued: persistent queue size
   *	@sk_forward_alloc: space allocated forward
   *	@sk_allocation: allocation mode
@@ -218,6 +219,7 @@ struct cg_proto;
   *	@sk_gso_type: GSO type (e.g. %SKB_GSO_TCPV4)
   *	@sk_gso_max_size: Maximum GSO segment size to build
   *	@sk_gso_max_segs: Maximum number of GSO segments
+  *	@sk_pacing_rate: Pacing rate (if supported by transport/packet scheduler)
   *	@sk_lingertime: %SO_LINGER l_linger setting
   *	@sk_backlog: always used with the per-socket spinlock held
   *	@sk_callback_lock: used with the callbacks in the end of this struct
@@ -253,6 +255,7 @@ struct cg_proto;
   *	@sk_security: used by security modules
   *	@sk_mark: generic packet mark
   *	@sk_classid: this socket's cgroup classid
+  *	@sk_uid: user charged for this socket's traffic
   *	@sk_cgrp: this socket's cgroup-specific proto data
   *	@sk_write_pending: a write to stream socket waits to start
   *	@sk_state_change: callback to indicate change in the state of the sock
@@ -322,6 +325,7 @@ struct sock {
 	spinlock_t		sk_dst_lock;
 	atomic_t		sk_wmem_alloc;
 	atomic_t		sk_omem_alloc;
+	atomic_t		sk_zckey;
 	int			sk_sndbuf;
 	struct sk_buff_head	sk_write_queue;
 	kmemcheck_bitfield_begin(flags);
@@ -338,6 +342,7 @@ struct sock {
 	int			sk_gso_type;
 	unsigned int		sk_gso_max_size;
 	u16			sk_gso_max_segs;
+	u32			sk_pacing_rate; /* bytes per second */
 	int			sk_rcvlowat;
 	unsigned long	        sk_lingertime;
 	struct sk_buff_head	sk_error_queue;
@@ -370,6 +375,7 @@ struct sock {
 #endif
 	__u32			sk_mark;
 	u32			sk_classid;
+	uid_t			sk_uid;
 	struct cg_proto		*sk_cgrp;
 	void			(*sk_state_change)(struct sock *sk);
 	void			(*sk_data_ready)(struct sock *sk, int bytes);
@@ -1208,6 +1214,29 @@ void sk_prot_clear_portaddr_nulls(struct sock *sk, int size);
 #define SOCK_BINDADDR_LOCK	4
 #define SOCK_BINDPORT_LOCK	8
 
+/*
+ * sock_batch: state shared by the messages of one sendmmsg() or recvmmsg()
+ * call. The caller tells the protocol how many messages are left, the
+ * current one included, and calls ->flush once after the last message if
+ * the protocol set it, however the call ends. The protocol owns the rest
+ * and uses it for work it can do once per batch instead of per message.
+ */
+struct sock_batch {
+	void			(*flush)(struct sock_batch *batch);
+	unsigned int		remaining;
+	struct sock		*sk;
+	struct sk_buff_head	queue;
+	unsigned int		len;
+};
+
+static inline void sock_batch_init(struct sock_batch *batch)
+{
+	batch->flush = NULL;
+	batch->sk = NULL;
+	__skb_queue_head_init(&batch->queue);
+	batch->len = 0;
+}
+
 /* sock_iocb: used to kick off async processing of socket ios */
 struct sock_iocb {
 	struct list_head	list;
@@ -1219,6 +1248,7 @@ struct sock_iocb {
 	struct scm_cookie	*scm;
 	struct msghdr		*msg, async_msg;
 	struct kiocb		*kiocb;
+	struct sock_batch	*batch;		/* NULL outside a batch */
 };
 
 static inline struct sock_iocb *kiocb_to_siocb(struct kiocb *iocb)
@@ -1404,6 +1434,9 @@ extern struct sk_buff		*sock_wmalloc(struct sock *sk,
 extern struct sk_buff		*sock_rmalloc(struct sock *sk,
 					      unsigned long size, int force,
 					      gfp_t priority);
+extern struct sk_buff		*sock_omalloc(struct sock *sk,
+					      unsigned long size,
+					      gfp_t priority);
 extern void			sock_wfree(struct sk_buff *skb);
 extern void			sock_rfree(struct sk_buff *skb);
 
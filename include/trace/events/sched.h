@@ -169,6 +169,69 @@ TRACE_EVENT(sched_cpu_load,
 	__entry->power_cost)
 );
 
+TRACE_EVENT(sched_energy_cpu,
+
+	TP_PROTO(struct task_struct *p, int cpu, u64 cpu_load,
+		 unsigned int old_freq, unsigned int new_freq, u64 delta),
+
+	TP_ARGS(p, cpu, cpu_load, old_freq, new_freq, delta),
+
+	TP_STRUCT__entry(
+		__field(	pid_t,	pid			)
+		__field(	int,	cpu			)
+		__field(	u64,	cpu_load		)
+		__field(unsigned int,	old_freq		)
+		__field(unsigned int,	new_freq		)
+		__field(	u64,	delta			)
+	),
+
+	TP_fast_assign(
+		__entry->pid		= p->pid;
+		__entry->cpu		= cpu;
+		__entry->cpu_load	= cpu_load;
+		__entry->old_freq	= old_freq;
+		__entry->new_freq	= new_freq;
+		__entry->delta		= delta;
+	),
+
+	TP_printk("pid %d cpu %d load %llu freq %u -> %u energy_delta %llu",
+		__entry->pid, __entry->cpu, __entry->cpu_load,
+		__entry->old_freq, __entry->new_freq, __entry->delta)
+);
+
+TRACE_EVENT(sched_energy_select,
+
+	TP_PROTO(struct task_struct *p, int prev_cpu, int best_cpu,
+		 int small_task, u64 min_delta),
+
+	TP_ARGS(p, prev_cpu, best_cpu, small_task, min_delta),
+
+	TP_STRUCT__entry(
+		__array(	char,	comm,	TASK_COMM_LEN	)
+		__field(	pid_t,	pid			)
+		__field(unsigned int,	demand			)
+		__field(	int,	prev_cpu		)
+		__field(	int,	best_cpu		)
+		__field(	int,	small_task		)
+		__field(	u64,	min_delta		)
+	),
+
+	TP_fast_assign(
+		memcpy(__entry->comm, p->comm, TASK_COMM_LEN);
+		__entry->pid		= p->pid;
+		__entry->demand		= p->ravg.demand;
+		__entry->prev_cpu	= prev_cpu;
+		__entry->best_cpu	= best_cpu;
+		__entry->small_task	= small_task;
+		__entry->min_delta	= min_delta;
+	),
+
+	TP_printk("%d (%s): demand=%u small=%d prev_cpu=%d best_cpu=%d energy_delta=%llu",
+		__entry->pid, __entry->comm, __entry->demand,
+		__entry->small_task, __entry->prev_cpu, __entry->best_cpu,
+		__entry->min_delta)
+);
+
 #endif	/* CONFIG_SCHED_HMP */
 
 #if defined(CONFIG_SCHED_FREQ_INPUT) || defined(CONFIG_SCHED_HMP)
@@ -841,6 +841,8 @@ static void enqueue_task(struct rq *rq, struct task_struct *p, int flags)
 {
 	update_rq_clock(rq);
 	sched_info_queued(p);
+	if (flags & ENQUEUE_WAKEUP)
+		sched_info_woken(p);
 	p->sched_class->enqueue_task(rq, p, flags);
 #ifdef TRACE_CRAP
 	trace_sched_enq_deq_task(p, 1, cpumask_bits(&p->cpus_allowed)[0]);
@@ -2653,6 +2655,9 @@ static void __sched_fork(struct task_struct *p)
 
 	RB_CLEAR_NODE(&p->dl.rb_node);
 	hrtimer_init(&p->dl.dl_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	init_dl_inactive_task_timer(&p->dl);
+	p->dl.dl_non_contending = 0;
+	p->dl.dl_active_bw = 0;
 	__dl_clear_params(p);
 
 	INIT_LIST_HEAD(&p->rt.run_list);
@@ -2694,6 +2699,9 @@ int sched_fork(struct task_struct *p)
 		} else if (PRIO_TO_NICE(p->static_prio) < 0)
 			p->static_prio = NICE_TO_PRIO(0);
 
+		if (p->se.latency_nice < 0)
+			p->se.latency_nice = 0;
+
 		p->prio = p->normal_prio = __normal_prio(p);
 		set_load_weight(p);
 
@@ -5166,7 +5174,14 @@ recheck:
 			return -EINVAL;
 	}
 
-	if (attr->sched_flags & ~(SCHED_FLAG_RESET_ON_FORK))
+	if (attr->sched_flags & ~(SCHED_FLAG_RESET_ON_FORK |
+				  SCHED_FLAG_RECLAIM |
+				  SCHED_FLAG_LATENCY_NICE))
+		return -EINVAL;
+
+	if (attr->sched_flags & SCHED_FLAG_LATENCY_NICE &&
+	    (attr->sched_latency_nice < MIN_LATENCY_NICE ||
+	     attr->sched_latency_nice > MAX_LATENCY_NICE))
 		return -EINVAL;
 
 	/*
@@ -5191,6 +5206,11 @@ recheck:
 				return -EPERM;
 		}
 
+		/* can't ask for lower latency than we have */
+		if (attr->sched_flags & SCHED_FLAG_LATENCY_NICE &&
+		    attr->sched_latency_nice < p->se.latency_nice)
+			return -EPERM;
+
 		if (rt_policy(policy)) {
 			unsigned long rlim_rtprio =
 					task_rlimit(p, RLIMIT_RTPRIO);
@@ -5265,6 +5285,9 @@ recheck:
 			goto change;
 		if (dl_policy(policy))
 			goto change;
+		if (attr->sched_flags & SCHED_FLAG_LATENCY_NICE &&
+		    attr->sched_latency_nice != p->se.latency_nice)
+			goto change;
 
 		__task_rq_unlock(rq);
 		raw_spin_unlock_irqrestore(&p->pi_lock, flags);
@@ -5328,6 +5351,8 @@ change:
 		p->sched_class->put_prev_task(rq, p);
 
 	p->sched_reset_on_fork = reset_on_fork;
+	if (attr->sched_flags & SCHED_FLAG_LATENCY_NICE)
+		p->se.latency_nice = attr->sched_latency_nice;
 
 	oldprio = p->prio;
 	prev_class = p->sched_class;
@@ -5711,6 +5736,10 @@ SYSCALL_DEFINE4(sched_getattr, pid_t, pid, struct sched_attr __user *, uattr,
 	else
 		attr.sched_nice = TASK_NICE(p);
 
+	/* Only reported to callers that know about the field */
+	if (size >= SCHED_ATTR_SIZE_VER1)
+		attr.sched_latency_nice = p->se.latency_nice;
+
 	rcu_read_unlock();
 
 	retval = sched_read_attr(uattr, &attr, size);
@@ -8728,6 +8757,7 @@ static void free_sched_group(struct task_group *tg)
 {
 	free_fair_sched_group(tg);
 	free_rt_sched_group(tg);
+	free_sched_lat_hist(tg);
 	autogroup_free(tg);
 	kfree(tg);
 }
@@ -8748,6 +8778,9 @@ struct task_group *sched_create_group(struct task_group *parent)
 	if (!alloc_rt_sched_group(tg, parent))
 		goto err;
 
+	if (!alloc_sched_lat_hist(tg))
+		goto err;
+
 	spin_lock_irqsave(&task_group_lock, flags);
 	list_add_rcu(&tg->list, &task_groups);
 
@@ -9114,6 +9147,7 @@ static void sched_dl_do_global(void)
 		raw_spin_unlock_irqrestore(&dl_b->lock, flags);
 
 		rcu_read_unlock_sched();
+		init_dl_rq_bw_ratio(&cpu_rq(cpu)->dl);
 	}
 }
 
@@ -9293,6 +9327,24 @@ static int cpu_notify_on_migrate_write_u64(struct cgroup *cgrp,
 	return 0;
 }
 
+#ifdef CONFIG_SCHEDSTATS
+static int cpu_lat_hist_show(struct cgroup *cgrp, struct cftype *cft,
+			     struct seq_file *m)
+{
+	return sched_lat_hist_tg_show(cgroup_tg(cgrp), m);
+}
+
+static int cpu_lat_hist_write(struct cgroup *cgrp, struct cftype *cftype,
+			      u64 reset)
+{
+	if (reset)
+		return -EINVAL;
+
+	sched_lat_hist_tg_reset(cgroup_tg(cgrp));
+	return 0;
+}
+#endif
+
 #ifdef CONFIG_FAIR_GROUP_SCHED
 static int cpu_shares_write_u64(struct cgroup *cgrp, struct cftype *cftype,
 				u64 shareval)
@@ -9307,6 +9359,17 @@ static u64 cpu_shares_read_u64(struct cgroup *cgrp, struct cftype *cft)
 	return (u64) scale_load_down(tg->shares);
 }
 
+static int cpu_latency_nice_write_s64(struct cgroup *cgrp,
+				      struct cftype *cftype, s64 latency_nice)
+{
+	return sched_group_set_latency_nice(cgroup_tg(cgrp), latency_nice);
+}
+
+static s64 cpu_latency_nice_read_s64(struct cgroup *cgrp, struct cftype *cft)
+{
+	return cgroup_tg(cgrp)->latency_nice;
+}
+
 #ifdef CONFIG_CFS_BANDWIDTH
 static DEFINE_MUTEX(cfs_constraints_mutex);
 
@@ -9575,12 +9638,24 @@ static struct cftype cpu_files[] = {
 		.read_u64 = cpu_notify_on_migrate_read_u64,
 		.write_u64 = cpu_notify_on_migrate_write_u64,
 	},
+#ifdef CONFIG_SCHEDSTATS
+	{
+		.name = "lat_hist",
+		.read_seq_string = cpu_lat_hist_show,
+		.write_u64 = cpu_lat_hist_write,
+	},
+#endif
 #ifdef CONFIG_FAIR_GROUP_SCHED
 	{
 		.name = "shares",
 		.read_u64 = cpu_shares_read_u64,
 		.write_u64 = cpu_shares_write_u64,
 	},
+	{
+		.name = "latency_nice",
+		.read_s64 = cpu_latency_nice_read_s64,
+		.write_s64 = cpu_latency_nice_write_s64,
+	},
 #endif
 #ifdef CONFIG_CFS_BANDWIDTH
 	{
@@ -69,10 +69,26 @@ void init_dl_bw(struct dl_bw *dl_b)
 	dl_b->total_bw = 0;
 }
 
+void init_dl_rq_bw_ratio(struct dl_rq *dl_rq)
+{
+	if (global_rt_runtime() == RUNTIME_INF) {
+		dl_rq->bw_ratio = 1 << RATIO_SHIFT;
+		dl_rq->max_bw = BW_UNIT;
+	} else {
+		dl_rq->bw_ratio = to_ratio(global_rt_runtime(),
+			global_rt_period()) >> (BW_SHIFT - RATIO_SHIFT);
+		dl_rq->max_bw = to_ratio(global_rt_period(),
+					 global_rt_runtime());
+	}
+}
+
 void init_dl_rq(struct dl_rq *dl_rq, struct rq *rq)
 {
 	dl_rq->rb_root = RB_ROOT;
 
+	dl_rq->running_bw = 0;
+	init_dl_rq_bw_ratio(dl_rq);
+
 #ifdef CONFIG_SMP
 	/* zero means no -deadline tasks */
 	dl_rq->earliest_dl.curr = dl_rq->earliest_dl.next = 0;
@@ -233,6 +249,141 @@ static void __dequeue_task_dl(struct rq *rq, struct task_struct *p, int flags);
 static void check_preempt_curr_dl(struct rq *rq, struct task_struct *p,
 				  int flags);
 
+/*
+ * Active utilization (running_bw) tracking, needed by GRUB reclaiming.
+ *
+ * A -deadline task contributes its bandwidth to the running_bw of its
+ * rq from the moment it becomes runnable until the "0-lag time" after
+ * it blocks, that is the instant at which its residual runtime would
+ * have been consumed at exactly its reserved rate:
+ *
+ *   0-lag = deadline - runtime * dl_period / dl_runtime
+ *
+ * Between blocking and the 0-lag time the task is "active non
+ * contending" and an hrtimer (inactive_timer) is armed to remove its
+ * bandwidth; waking up before it fires just cancels the timer.
+ *
+ * dl_active_bw records what was actually added, so that add and sub
+ * always balance, even if sched_setattr() changed dl_bw in between,
+ * and both are no-ops when called a second time.
+ */
+static inline
+void add_running_bw(struct sched_dl_entity *dl_se, struct dl_rq *dl_rq)
+{
+	if (dl_se->dl_active_bw)
+		return;
+
+	dl_se->dl_active_bw = dl_se->dl_bw;
+	dl_rq->running_bw += dl_se->dl_bw;
+}
+
+static inline
+void sub_running_bw(struct sched_dl_entity *dl_se, struct dl_rq *dl_rq)
+{
+	u64 bw = dl_se->dl_active_bw;
+
+	dl_se->dl_active_bw = 0;
+	if (WARN_ON_ONCE(dl_rq->running_bw < bw))
+		dl_rq->running_bw = 0;
+	else
+		dl_rq->running_bw -= bw;
+}
+
+/*
+ * Must be called with the rq lock of the task held. If the inactive
+ * timer callback is already running and can't be cancelled, it will
+ * find dl_non_contending cleared, leave running_bw alone and drop the
+ * task reference itself.
+ */
+static void clear_dl_non_contending(struct sched_dl_entity *dl_se)
+{
+	if (!dl_se->dl_non_contending)
+		return;
+
+	dl_se->dl_non_contending = 0;
+	if (hrtimer_try_to_cancel(&dl_se->inactive_timer) == 1)
+		put_task_struct(dl_task_of(dl_se));
+}
+
+static void task_non_contending(struct task_struct *p)
+{
+	struct sched_dl_entity *dl_se = &p->dl;
+	struct hrtimer *timer = &dl_se->inactive_timer;
+	struct dl_rq *dl_rq = dl_rq_of_se(dl_se);
+	struct rq *rq = rq_of_dl_rq(dl_rq);
+	s64 zerolag_time;
+
+	if (!dl_se->dl_active_bw || dl_se->dl_non_contending)
+		return;
+
+	zerolag_time = dl_se->deadline -
+		div64_long(dl_se->runtime * dl_se->dl_period,
+			   dl_se->dl_runtime);
+	zerolag_time -= rq_clock(rq);
+
+	/*
+	 * If the 0-lag time already passed, or an earlier inactive timer
+	 * callback is still running, the bandwidth is released right now.
+	 */
+	if (zerolag_time < 0 || hrtimer_active(timer)) {
+		sub_running_bw(dl_se, dl_rq);
+		return;
+	}
+
+	dl_se->dl_non_contending = 1;
+	get_task_struct(p);
+	__hrtimer_start_range_ns(timer, ns_to_ktime(zerolag_time),
+				 0, HRTIMER_MODE_REL, 0);
+}
+
+static void task_contending(struct sched_dl_entity *dl_se)
+{
+	clear_dl_non_contending(dl_se);
+	add_running_bw(dl_se, dl_rq_of_se(dl_se));
+}
+
+static enum hrtimer_restart inactive_task_timer(struct hrtimer *timer)
+{
+	struct sched_dl_entity *dl_se = container_of(timer,
+						     struct sched_dl_entity,
+						     inactive_timer);
+	struct task_struct *p = dl_task_of(dl_se);
+	struct rq *rq;
+again:
+	rq = task_rq(p);
+	raw_spin_lock(&rq->lock);
+
+	if (rq != task_rq(p)) {
+		/* Task was moved, retrying. */
+		raw_spin_unlock(&rq->lock);
+		goto again;
+	}
+
+	if (dl_se->dl_non_contending) {
+		dl_se->dl_non_contending = 0;
+		sub_running_bw(dl_se, &rq->dl);
+	}
+	raw_spin_unlock(&rq->lock);
+
+	put_task_struct(p);
+
+	return HRTIMER_NORESTART;
+}
+
+void init_dl_inactive_task_timer(struct sched_dl_entity *dl_se)
+{
+	struct hrtimer *timer = &dl_se->inactive_timer;
+
+	hrtimer_init(timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	timer->function = inactive_task_timer;
+}
+
+static inline void dl_stat_reserve(struct sched_dl_entity *dl_se, u64 runtime)
+{
+	schedstat_add(&dl_task_of(dl_se)->se.statistics,
+		      dl_runtime_reserved, runtime);
+}
+
 /*
  * We are being explicitly informed that a new instance is starting,
  * and this means that:
@@ -261,6 +412,7 @@ static inline void setup_new_dl_entity(struct sched_dl_entity *dl_se,
 	dl_se->deadline = rq_clock(rq) + pi_se->dl_deadline;
 	dl_se->runtime = pi_se->dl_runtime;
 	dl_se->dl_new = 0;
+	dl_stat_reserve(dl_se, pi_se->dl_runtime);
 }
 
 /*
@@ -296,6 +448,7 @@ static void replenish_dl_entity(struct sched_dl_entity *dl_se,
 	if (dl_se->dl_deadline == 0) {
 		dl_se->deadline = rq_clock(rq) + pi_se->dl_deadline;
 		dl_se->runtime = pi_se->dl_runtime;
+		dl_stat_reserve(dl_se, pi_se->dl_runtime);
 	}
 
 	/*
@@ -307,6 +460,7 @@ static void replenish_dl_entity(struct sched_dl_entity *dl_se,
 	while (dl_se->runtime <= 0) {
 		dl_se->deadline += pi_se->dl_period;
 		dl_se->runtime += pi_se->dl_runtime;
+		dl_stat_reserve(dl_se, pi_se->dl_runtime);
 	}
 
 	/*
@@ -407,6 +561,7 @@ static void update_dl_entity(struct sched_dl_entity *dl_se,
 	    dl_entity_overflow(dl_se, pi_se, rq_clock(rq))) {
 		dl_se->deadline = rq_clock(rq) + pi_se->dl_deadline;
 		dl_se->runtime = pi_se->dl_runtime;
+		dl_stat_reserve(dl_se, pi_se->dl_runtime);
 	}
 }
 
@@ -554,6 +709,13 @@ int dl_runtime_exceeded(struct rq *rq, struct sched_dl_entity *dl_se)
 	if (!rorun && !dmiss)
 		return 0;
 
+	if (rorun)
+		schedstat_inc(&dl_task_of(dl_se)->se.statistics,
+			      nr_dl_overruns);
+	if (dmiss)
+		schedstat_inc(&dl_task_of(dl_se)->se.statistics,
+			      nr_dl_deadline_misses);
+
 	/*
 	 * If we are beyond our current deadline and we are still
 	 * executing, then we have already used some of the runtime of
@@ -570,6 +732,42 @@ int dl_runtime_exceeded(struct rq *rq, struct sched_dl_entity *dl_se)
 
 extern bool sched_rt_bandwidth_account(struct rt_rq *rt_rq);
 
+/*
+ * GRUB (Greedy Reclamation of Unused Bandwidth) lets a task flagged
+ * with SCHED_FLAG_RECLAIM consume the bandwidth that is not used by
+ * the active -deadline tasks of its rq, by depleting its runtime at
+ * rate Uact rather than 1:
+ *
+ *   dq = -max{ Ui / Umax, 1 - Umax + running_bw } dt
+ *
+ * where Umax is the fraction of the CPU -deadline tasks are allowed
+ * to use (sched_rt_runtime_us / sched_rt_period_us). Inactive and
+ * unallocated bandwidth is thus given away, but never the (1 - Umax)
+ * share kept for the other scheduling classes, and a task is never
+ * charged less than its own share of Umax.
+ *
+ * Admission control is global (per root domain), so a single rq may
+ * temporarily have more than Umax active: there nothing is reclaimed.
+ */
+static u64 grub_reclaim(u64 delta, struct rq *rq,
+			struct sched_dl_entity *dl_se)
+{
+	struct dl_rq *dl_rq = &rq->dl;
+	u64 u_act_min = (dl_se->dl_bw * dl_rq->bw_ratio) >> RATIO_SHIFT;
+	u64 u_act;
+
+	if (dl_rq->running_bw >= dl_rq->max_bw)
+		return delta;
+
+	u_act = BW_UNIT - (dl_rq->max_bw - dl_rq->running_bw);
+	if (u_act < u_act_min)
+		u_act = u_act_min;
+	if (u_act >= BW_UNIT)
+		return delta;
+
+	return (delta * u_act) >> BW_SHIFT;
+}
+
 /*
  * Update the current task's runtime statistics (provided it is still
  * a -deadline task and has not been removed from the dl_rq).
@@ -578,7 +776,7 @@ static void update_curr_dl(struct rq *rq)
 {
 	struct task_struct *curr = rq->curr;
 	struct sched_dl_entity *dl_se = &curr->dl;
-	u64 delta_exec;
+	u64 delta_exec, scaled_delta_exec;
 
 	if (!dl_task(curr) || !on_dl_rq(dl_se))
 		return;
@@ -606,12 +804,22 @@ static void update_curr_dl(struct rq *rq)
 
 	sched_rt_avg_update(rq, delta_exec);
 
-	dl_se->runtime -= delta_exec;
+	schedstat_add(&curr->se.statistics, dl_runtime_used, delta_exec);
+
+	scaled_delta_exec = delta_exec;
+	if (unlikely(dl_se->flags & SCHED_FLAG_RECLAIM)) {
+		scaled_delta_exec = grub_reclaim(delta_exec, rq, dl_se);
+		schedstat_add(&curr->se.statistics, dl_runtime_reclaimed,
+			      delta_exec - scaled_delta_exec);
+	}
+
+	dl_se->runtime -= scaled_delta_exec;
 	if (dl_runtime_exceeded(rq, dl_se)) {
 		__dequeue_task_dl(rq, curr, 0);
-		if (likely(start_dl_timer(dl_se, curr->dl.dl_boosted)))
+		if (likely(start_dl_timer(dl_se, curr->dl.dl_boosted))) {
 			dl_se->dl_throttled = 1;
-		else
+			schedstat_inc(&curr->se.statistics, nr_dl_throttled);
+		} else
 			enqueue_task_dl(rq, curr, ENQUEUE_REPLENISH);
 
 		if (!is_leftmost(curr, &rq->dl))
@@ -842,6 +1050,14 @@ static void enqueue_task_dl(struct rq *rq, struct task_struct *p, int flags)
 		return;
 	}
 
+	/*
+	 * Whatever the reason we are being enqueued (wakeup, migration,
+	 * change of parameters or of class), the task is active from now
+	 * on. This is a no-op for a replenishment, as a throttled task
+	 * keeps its bandwidth.
+	 */
+	task_contending(&p->dl);
+
 	/*
 	 * If p is throttled, we do nothing. In fact, if it exhausted
 	 * its budget it needs a replenishment and, since it now is on
@@ -867,17 +1083,27 @@ static void dequeue_task_dl(struct rq *rq, struct task_struct *p, int flags)
 {
 	update_curr_dl(rq);
 	__dequeue_task_dl(rq, p, flags);
+
+	/*
+	 * A task going to sleep keeps its bandwidth active until its
+	 * 0-lag time; in any other case it is leaving this rq (or this
+	 * class, or changing parameters) and enqueue_task_dl() will add
+	 * it back wherever it ends up.
+	 */
+	if (flags & DEQUEUE_SLEEP)
+		task_non_contending(p);
+	else
+		sub_running_bw(&p->dl, &rq->dl);
 }
 
 /*
  * Yield task semantic for -deadline tasks is:
  *
  *   get off from the CPU until our next instance, with
- *   a new runtime. This is of little use now, since we
- *   don't have a bandwidth reclaiming mechanism. Anyway,
- *   bandwidth reclaiming is planned for the future, and
- *   yield_task_dl will indicate that some spare budget
- *   is available for other task instances to use it.
+ *   a new runtime. The task stays active until then, so
+ *   the budget it gives up is not reclaimed by GRUB; a
+ *   task that wants to hand its spare bandwidth over to
+ *   SCHED_FLAG_RECLAIM tasks should block instead.
  */
 static void yield_task_dl(struct rq *rq)
 {
@@ -900,6 +1126,27 @@ static void yield_task_dl(struct rq *rq)
 
 static int find_later_rq(struct task_struct *task);
 
+/*
+ * Called from set_task_cpu(). Runnable tasks are moved by dequeue and
+ * enqueue, which already transfer their bandwidth; a task being woken
+ * up on another CPU instead may still be active non contending on the
+ * old rq, and it has to take its bandwidth with it. We hold p->pi_lock
+ * here, not the rq lock.
+ */
+static void migrate_task_rq_dl(struct task_struct *p, int next_cpu)
+{
+	struct rq *rq;
+
+	if (p->state != TASK_WAKING)
+		return;
+
+	rq = task_rq(p);
+	raw_spin_lock(&rq->lock);
+	clear_dl_non_contending(&p->dl);
+	sub_running_bw(&p->dl, &rq->dl);
+	raw_spin_unlock(&rq->lock);
+}
+
 static int
 select_task_rq_dl(struct task_struct *p, int sd_flag, int flags)
 {
@@ -1558,6 +1805,13 @@ static void switched_from_dl(struct rq *rq, struct task_struct *p)
 	if (hrtimer_active(&p->dl.dl_timer) && !dl_policy(p->policy))
 		hrtimer_try_to_cancel(&p->dl.dl_timer);
 
+	/*
+	 * A sleeping task may still be accounted as active here, until
+	 * its 0-lag time: it is not a -deadline task anymore, drop it.
+	 */
+	clear_dl_non_contending(&p->dl);
+	sub_running_bw(&p->dl, &rq->dl);
+
 	__dl_clear_params(p);
 
 #ifdef CONFIG_SMP
@@ -1653,6 +1907,7 @@ const struct sched_class dl_sched_class = {
 
 #ifdef CONFIG_SMP
 	.select_task_rq		= select_task_rq_dl,
+	.migrate_task_rq	= migrate_task_rq_dl,
 	.set_cpus_allowed       = set_cpus_allowed_dl,
 	.rq_online              = rq_online_dl,
 	.rq_offline             = rq_offline_dl,
@@ -1670,3 +1925,12 @@ const struct sched_class dl_sched_class = {
 	.switched_from		= switched_from_dl,
 	.switched_to		= switched_to_dl,
 };
+
+#ifdef CONFIG_SCHED_DEBUG
+extern void print_dl_rq(struct seq_file *m, int cpu, struct dl_rq *dl_rq);
+
+void print_dl_stats(struct seq_file *m, int cpu)
+{
+	print_dl_rq(m, cpu, &cpu_rq(cpu)->dl);
+}
+#endif /* CONFIG_SCHED_DEBUG */
@@ -259,6 +259,21 @@ void print_rt_rq(struct seq_file *m, int cpu, struct rt_rq *rt_rq)
 #undef P
 }
 
+void print_dl_rq(struct seq_file *m, int cpu, struct dl_rq *dl_rq)
+{
+	SEQ_printf(m, "\ndl_rq[%d]:\n", cpu);
+
+#define P(x) \
+	SEQ_printf(m, "  .%-30s: %Ld\n", #x, (long long)(dl_rq->x))
+
+	P(dl_nr_running);
+	P(running_bw);
+	P(max_bw);
+	P(bw_ratio);
+
+#undef P
+}
+
 extern __read_mostly int sched_clock_running;
 
 static void print_cpu(struct seq_file *m, int cpu)
@@ -336,6 +351,7 @@ static void print_cpu(struct seq_file *m, int cpu)
 	spin_lock_irqsave(&sched_debug_lock, flags);
 	print_cfs_stats(m, cpu);
 	print_rt_stats(m, cpu);
+	print_dl_stats(m, cpu);
 
 	rcu_read_lock();
 	print_rq(m, rq, cpu);
@@ -503,6 +519,14 @@ void proc_sched_show_task(struct task_struct *p, struct seq_file *m)
 	P(se.statistics.nr_wakeups_affine_attempts);
 	P(se.statistics.nr_wakeups_passive);
 	P(se.statistics.nr_wakeups_idle);
+	if (task_has_dl_policy(p)) {
+		P(se.statistics.nr_dl_throttled);
+		P(se.statistics.nr_dl_overruns);
+		P(se.statistics.nr_dl_deadline_misses);
+		PN(se.statistics.dl_runtime_used);
+		PN(se.statistics.dl_runtime_reserved);
+		PN(se.statistics.dl_runtime_reclaimed);
+	}
 
 #if defined(CONFIG_SMP) && defined(CONFIG_FAIR_GROUP_SCHED)
 	__P(load_avg);
@@ -542,6 +566,15 @@ void proc_sched_show_task(struct task_struct *p, struct seq_file *m)
 	P(se.load.weight);
 	P(policy);
 	P(prio);
+	P(se.latency_nice);
+	if (task_has_dl_policy(p)) {
+		PN(dl.dl_runtime);
+		PN(dl.dl_deadline);
+		PN(dl.dl_period);
+		P(dl.dl_bw);
+		P(dl.dl_active_bw);
+		P(dl.flags);
+	}
 #undef PN
 #undef __PN
 #undef P
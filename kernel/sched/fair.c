@@ -1124,6 +1124,13 @@ int __read_mostly sysctl_sched_upmigrate_min_nice = 15;
  */
 unsigned int sysctl_sched_boost;
 
+/*
+ * Energy-aware placement: place waking tasks on the CPU whose estimated
+ * power draw grows the least once the task's demand is added, using the
+ * per-frequency power table of each CPU. Needs sched_enable_hmp.
+ */
+unsigned int __read_mostly sysctl_sched_energy_aware;
+
 static inline int available_cpu_capacity(int cpu)
 {
 	struct rq *rq = cpu_rq(cpu);
@@ -1482,6 +1489,116 @@ static int best_small_task_cpu(struct task_struct *p)
 	return best_fallback_cpu;
 }
 
+/*
+ * Frequency @cpu has to run at to serve @load, where @load has already
+ * been scaled to @cpu.
+ */
+static unsigned int load_to_freq(int cpu, u64 load)
+{
+	struct rq *rq = cpu_rq(cpu);
+	u64 freq;
+
+	freq = div64_u64(load * rq->max_possible_freq, max_task_load());
+	if (freq < rq->min_freq)
+		freq = rq->min_freq;
+	if (rq->max_freq && freq > rq->max_freq)
+		freq = rq->max_freq;
+
+	return freq;
+}
+
+/*
+ * Power proxy for @cpu serving @load: the power table cost at the
+ * frequency the load needs, weighted by the fraction of time the cpu is
+ * busy at that frequency.
+ */
+static u64 cpu_energy(int cpu, u64 load)
+{
+	struct rq *rq = cpu_rq(cpu);
+	unsigned int freq;
+	u64 busy;
+
+	if (!load)
+		return 0;
+
+	freq = load_to_freq(cpu, load);
+	if (!freq)
+		return power_cost_at_freq(cpu, 0);
+
+	/* fraction of time busy at freq, in 1/1024 units */
+	busy = div64_u64(load * rq->max_possible_freq * 1024,
+			 (u64)freq * max_task_load());
+	if (busy > 1024)
+		busy = 1024;
+
+	return ((u64)power_cost_at_freq(cpu, freq) * busy) >> 10;
+}
+
+/* Are two energy costs within sysctl_sched_powerband_limit_pct? */
+static inline int energy_in_band(u64 cost, u64 base)
+{
+	u64 limit = div64_u64(base * sysctl_sched_powerband_limit_pct, 100);
+
+	return cost <= base + limit && cost + limit >= base;
+}
+
+/*
+ * Pick the cpu where adding @p costs the least energy. Among cpus in the
+ * same power band, small tasks are packed onto the busiest one, so that
+ * idle cpus stay idle and busy ones stay at low frequency, while other
+ * tasks are spread onto the least loaded one. Returns -1 if no cpu can
+ * take the task without crossing its spill threshold.
+ */
+static int select_energy_cpu(struct task_struct *p)
+{
+	int i, best_cpu = -1, prev_cpu = task_cpu(p);
+	int small_task = is_small_task(p);
+	u64 load, task, delta, old_energy, min_delta = 0, best_load = 0;
+
+	for_each_cpu_and(i, tsk_cpus_allowed(p), cpu_online_mask) {
+		struct rq *rq = cpu_rq(i);
+
+		if (!task_will_fit(p, i) || spill_threshold_crossed(p, rq, i))
+			continue;
+
+		load = cpu_load(i);
+		task = scale_load_to_cpu(task_load(p), i);
+		old_energy = cpu_energy(i, load);
+		delta = cpu_energy(i, load + task);
+		delta = delta > old_energy ? delta - old_energy : 0;
+		if (!load && rq->cstate)
+			delta += rq->wakeup_energy;
+
+		trace_sched_energy_cpu(p, i, load, load_to_freq(i, load),
+				       load_to_freq(i, load + task), delta);
+
+		if (best_cpu < 0 ||
+		    (delta < min_delta && !energy_in_band(delta, min_delta))) {
+			best_cpu = i;
+			best_load = load;
+			min_delta = delta;
+			continue;
+		}
+
+		if (!energy_in_band(delta, min_delta))
+			continue;
+
+		if ((small_task ? load > best_load : load < best_load) ||
+		    (load == best_load && i == prev_cpu)) {
+			best_cpu = i;
+			best_load = load;
+		}
+
+		if (delta < min_delta)
+			min_delta = delta;
+	}
+
+	trace_sched_energy_select(p, prev_cpu, best_cpu, small_task,
+				  min_delta);
+
+	return best_cpu;
+}
+
 /* return cheapest cpu that can fit this task */
 static int select_best_cpu(struct task_struct *p, int target)
 {
@@ -1493,6 +1610,12 @@ static int select_best_cpu(struct task_struct *p, int target)
 
 	trace_sched_task_load(p);
 
+	if (sysctl_sched_energy_aware && !sched_boost()) {
+		best_cpu = select_energy_cpu(p);
+		if (best_cpu >= 0)
+			goto done;
+	}
+
 	if (small_task) {
 		best_cpu = best_small_task_cpu(p);
 		goto done;
@@ -2629,6 +2752,13 @@ check_preempt_tick(struct cfs_rq *cfs_rq, struct sched_entity *curr)
 	s64 delta;
 
 	ideal_runtime = sched_slice(cfs_rq, curr);
+	/*
+	 * Latency tolerant entities are let run up to twice their slice
+	 * before tick preemption, they gain throughput by switching less.
+	 */
+	if (curr->latency_nice > 0)
+		ideal_runtime += (ideal_runtime / (LATENCY_NICE_WIDTH / 2)) *
+				 curr->latency_nice;
 	delta_exec = curr->sum_exec_runtime - curr->prev_sum_exec_runtime;
 	if (delta_exec > ideal_runtime) {
 		resched_task(rq_of(cfs_rq)->curr);
@@ -4153,7 +4283,8 @@ static int select_idle_sibling(struct task_struct *p, int target)
 
 	if (!sysctl_sched_wake_to_idle &&
 	    !(current->flags & PF_WAKE_UP_IDLE) &&
-	    !(p->flags & PF_WAKE_UP_IDLE))
+	    !(p->flags & PF_WAKE_UP_IDLE) &&
+	    p->se.latency_nice >= 0)
 		return target;
 
 	/*
@@ -4179,6 +4310,24 @@ next:
 			sg = sg->next;
 		} while (sg != sd->groups);
 	}
+
+	/*
+	 * No fully idle group: a latency sensitive task would rather
+	 * share a core or cluster than wait behind the target's current
+	 * task, take any idle cpu sharing the cache.
+	 */
+	if (p->se.latency_nice < 0) {
+		sd = rcu_dereference(per_cpu(sd_llc, target));
+		if (!sd)
+			goto done;
+
+		for_each_cpu_and(i, sched_domain_span(sd), tsk_cpus_allowed(p)) {
+			if (idle_cpu(i)) {
+				target = i;
+				break;
+			}
+		}
+	}
 done:
 	return target;
 }
@@ -4364,6 +4513,29 @@ wakeup_gran(struct sched_entity *curr, struct sched_entity *se)
 	return calc_delta_fair(gran, se);
 }
 
+/*
+ * Latency nice offset applied when 'se' wakes up against 'curr', in ns:
+ * negative values make preemption easier. The offset is relative to
+ * 'curr' but capped by the own value of 'se', so that a latency
+ * sensitive task gains at most its own advantage even against a batch
+ * task, and a latency tolerant task always pays its own penalty. At the
+ * extremes the offset is about one sched_latency period.
+ */
+static s64 wakeup_latency_offset(struct sched_entity *curr,
+				 struct sched_entity *se)
+{
+	int latency_nice;
+
+	if (likely(!curr->latency_nice && !se->latency_nice))
+		return 0;
+
+	latency_nice = max(se->latency_nice - curr->latency_nice,
+			   se->latency_nice);
+
+	return div_s64((s64)latency_nice * sysctl_sched_latency,
+		       LATENCY_NICE_WIDTH / 2);
+}
+
 /*
  * Should 'se' preempt 'curr'.
  *
@@ -4383,6 +4555,7 @@ wakeup_preempt_entity(struct sched_entity *curr, struct sched_entity *se)
 {
 	s64 gran, vdiff = curr->vruntime - se->vruntime;
 
+	vdiff -= wakeup_latency_offset(curr, se);
 	if (vdiff <= 0)
 		return -1;
 
@@ -7284,6 +7457,35 @@ done:
 	mutex_unlock(&shares_mutex);
 	return 0;
 }
+
+/*
+ * The latency nice of a group applies to its entities on every cpu,
+ * that is when its tasks compete with tasks outside of the group.
+ */
+int sched_group_set_latency_nice(struct task_group *tg, long latency_nice)
+{
+	int i;
+	unsigned long flags;
+
+	if (!tg->se[0])
+		return -EINVAL;
+
+	if (latency_nice < MIN_LATENCY_NICE || latency_nice > MAX_LATENCY_NICE)
+		return -EINVAL;
+
+	mutex_lock(&shares_mutex);
+	tg->latency_nice = latency_nice;
+	for_each_possible_cpu(i) {
+		struct rq *rq = cpu_rq(i);
+
+		raw_spin_lock_irqsave(&rq->lock, flags);
+		tg->se[i]->latency_nice = latency_nice;
+		raw_spin_unlock_irqrestore(&rq->lock, flags);
+	}
+	mutex_unlock(&shares_mutex);
+
+	return 0;
+}
 #else /* CONFIG_FAIR_GROUP_SCHED */
 
 void free_fair_sched_group(struct task_group *tg) { }
@@ -71,6 +71,14 @@ extern __read_mostly int scheduler_running;
  */
 #define DL_SCALE (10)
 
+/*
+ * Fixed point used for -deadline bandwidths (see to_ratio()), and for
+ * the Umax^-1 ratio used by bandwidth reclaiming.
+ */
+#define BW_SHIFT	20
+#define BW_UNIT		(1 << BW_SHIFT)
+#define RATIO_SHIFT	8
+
 /*
  * These are the 'tuning knobs' of the scheduler:
  */
@@ -179,6 +187,23 @@ struct dl_bw {
 	u64 bw, total_bw;
 };
 
+#ifdef CONFIG_SCHEDSTATS
+/*
+ * Log2 histograms of the wakeup latency (from wakeup to running) and of
+ * the runqueue wait (from being queued, also after a preemption, to
+ * running) of tasks. Bucket i counts the waits shorter than 1024ns << i
+ * not counted by the previous ones, the last bucket all the longer ones.
+ * They are kept per cpu, in the rq and in each task group, and updated
+ * under the rq lock of the cpu the task runs on.
+ */
+#define SCHED_LAT_HIST_BUCKETS	20
+
+struct sched_lat_hist {
+	unsigned long wakeup[SCHED_LAT_HIST_BUCKETS];
+	unsigned long rq_wait[SCHED_LAT_HIST_BUCKETS];
+};
+#endif
+
 extern struct mutex sched_domains_mutex;
 
 #ifdef CONFIG_CGROUP_SCHED
@@ -220,12 +245,17 @@ struct task_group {
 	/* runqueue "owned" by this group on each cpu */
 	struct cfs_rq **cfs_rq;
 	unsigned long shares;
+	int latency_nice;
 
 	atomic_t load_weight;
 	atomic64_t load_avg;
 	atomic_t runnable_avg;
 #endif
 
+#ifdef CONFIG_SCHEDSTATS
+	struct sched_lat_hist __percpu *lat_hist;
+#endif
+
 #ifdef CONFIG_RT_GROUP_SCHED
 	struct sched_rt_entity **rt_se;
 	struct rt_rq **rt_rq;
@@ -299,6 +329,16 @@ extern void init_tg_rt_entry(struct task_group *tg, struct rt_rq *rt_rq,
 		struct sched_rt_entity *rt_se, int cpu,
 		struct sched_rt_entity *parent);
 
+#ifdef CONFIG_SCHEDSTATS
+extern int alloc_sched_lat_hist(struct task_group *tg);
+extern void free_sched_lat_hist(struct task_group *tg);
+extern int sched_lat_hist_tg_show(struct task_group *tg, struct seq_file *m);
+extern void sched_lat_hist_tg_reset(struct task_group *tg);
+#else
+static inline int alloc_sched_lat_hist(struct task_group *tg) { return 1; }
+static inline void free_sched_lat_hist(struct task_group *tg) { }
+#endif
+
 extern struct task_group *sched_create_group(struct task_group *parent);
 extern void sched_destroy_group(struct task_group *tg);
 
@@ -306,6 +346,8 @@ extern void sched_move_task(struct task_struct *tsk);
 
 #ifdef CONFIG_FAIR_GROUP_SCHED
 extern int sched_group_set_shares(struct task_group *tg, unsigned long shares);
+extern int sched_group_set_latency_nice(struct task_group *tg,
+					long latency_nice);
 #endif
 
 #else /* CONFIG_CGROUP_SCHED */
@@ -449,6 +491,17 @@ struct dl_rq {
 
 	unsigned long dl_nr_running;
 
+	/*
+	 * Utilization of the -deadline tasks that are active (runnable,
+	 * or blocked but not yet past their 0-lag time) on this rq, and
+	 * the parameters used by GRUB to reclaim the rest of it: max_bw
+	 * is the bandwidth -deadline tasks may use (Umax) and bw_ratio
+	 * is Umax^-1, both from the global rt runtime/period.
+	 */
+	u64 running_bw;
+	u64 max_bw;
+	u64 bw_ratio;
+
 #ifdef CONFIG_SMP
 	/*
 	 * Deadline values of the currently executing and the
@@ -671,6 +724,8 @@ struct rq {
 	/* try_to_wake_up() stats */
 	unsigned int ttwu_count;
 	unsigned int ttwu_local;
+
+	struct sched_lat_hist lat_hist;
 #endif
 
 #ifdef CONFIG_SMP
@@ -1334,6 +1389,8 @@ extern void init_rt_bandwidth(struct rt_bandwidth *rt_b, u64 period, u64 runtime
 extern struct dl_bandwidth def_dl_bandwidth;
 extern void init_dl_bandwidth(struct dl_bandwidth *dl_b, u64 period, u64 runtime);
 extern void init_dl_task_timer(struct sched_dl_entity *dl_se);
+extern void init_dl_inactive_task_timer(struct sched_dl_entity *dl_se);
+extern void init_dl_rq_bw_ratio(struct dl_rq *dl_rq);
 
 unsigned long to_ratio(u64 period, u64 runtime);
 
@@ -1677,6 +1734,7 @@ extern struct sched_entity *__pick_first_entity(struct cfs_rq *cfs_rq);
 extern struct sched_entity *__pick_last_entity(struct cfs_rq *cfs_rq);
 extern void print_cfs_stats(struct seq_file *m, int cpu);
 extern void print_rt_stats(struct seq_file *m, int cpu);
+extern void print_dl_stats(struct seq_file *m, int cpu);
 
 extern void init_cfs_rq(struct cfs_rq *cfs_rq);
 extern void init_rt_rq(struct rt_rq *rt_rq, struct rq *rq);
@@ -12,6 +12,9 @@
  */
 #define SCHEDSTAT_VERSION 15
 
+/* same, for /proc/sched_lat_hist and the cpu cgroup's cpu.lat_hist */
+#define SCHED_LAT_HIST_VERSION 1
+
 static int show_schedstat(struct seq_file *seq, void *v)
 {
 	int cpu;
@@ -104,9 +107,198 @@ static const struct file_operations proc_schedstat_operations = {
 	.release = single_release,
 };
 
+static inline int sched_lat_hist_bucket(unsigned long long delta)
+{
+	if (delta >= 1024ULL << (SCHED_LAT_HIST_BUCKETS - 2))
+		return SCHED_LAT_HIST_BUCKETS - 1;
+
+	return fls((unsigned long)(delta >> 10));
+}
+
+static inline struct sched_lat_hist *
+task_group_lat_hist(struct task_struct *t, struct rq *rq)
+{
+#ifdef CONFIG_CGROUP_SCHED
+	struct task_group *tg = task_group(t);
+
+	if (tg != &root_task_group)
+		return per_cpu_ptr(tg->lat_hist, cpu_of(rq));
+#endif
+	return NULL;
+}
+
+/*
+ * Called from sched_info_arrive(), with the rq lock held, when a task
+ * finally hits the cpu after waiting @wait on this rq.
+ */
+void sched_lat_hist_arrive(struct rq *rq, struct task_struct *t,
+			   unsigned long long now, unsigned long long wait)
+{
+	struct sched_lat_hist *tg_hist = task_group_lat_hist(t, rq);
+	int b;
+
+	wait += t->sched_info.wait_carry;
+	t->sched_info.wait_carry = 0;
+
+	b = sched_lat_hist_bucket(wait);
+	rq->lat_hist.rq_wait[b]++;
+	if (tg_hist)
+		tg_hist->rq_wait[b]++;
+
+	if (!t->sched_info.last_wakeup)
+		return;
+
+	b = sched_lat_hist_bucket(now - t->sched_info.last_wakeup);
+	t->sched_info.last_wakeup = 0;
+	rq->lat_hist.wakeup[b]++;
+	if (tg_hist)
+		tg_hist->wakeup[b]++;
+}
+
+static void lat_hist_show_header(struct seq_file *m)
+{
+	int i;
+
+	seq_printf(m, "version %d\n", SCHED_LAT_HIST_VERSION);
+	seq_printf(m, "bucket_ns");
+	for (i = 0; i < SCHED_LAT_HIST_BUCKETS - 1; i++)
+		seq_printf(m, " %u", 1024U << i);
+	seq_printf(m, " inf\n");
+}
+
+static void lat_hist_show_one(struct seq_file *m, const char *name,
+			      const char *what, const unsigned long *hist)
+{
+	int i;
+
+	seq_printf(m, "%s %s", name, what);
+	for (i = 0; i < SCHED_LAT_HIST_BUCKETS; i++)
+		seq_printf(m, " %lu", hist[i]);
+	seq_printf(m, "\n");
+}
+
+/*
+ * Prints one line per cpu and per histogram, then the sum over all the
+ * cpus. @hist(cpu) is read without locking, the counters of a line may
+ * be slightly out of sync with each other.
+ */
+static void lat_hist_show(struct seq_file *m,
+			  struct sched_lat_hist *(*hist)(void *, int),
+			  void *data)
+{
+	struct sched_lat_hist total;
+	char name[16];
+	int cpu, i;
+
+	memset(&total, 0, sizeof(total));
+	lat_hist_show_header(m);
+	for_each_online_cpu(cpu) {
+		struct sched_lat_hist *h = hist(data, cpu);
+
+		snprintf(name, sizeof(name), "cpu%d", cpu);
+		lat_hist_show_one(m, name, "wakeup", h->wakeup);
+		lat_hist_show_one(m, name, "rq_wait", h->rq_wait);
+		for (i = 0; i < SCHED_LAT_HIST_BUCKETS; i++) {
+			total.wakeup[i] += h->wakeup[i];
+			total.rq_wait[i] += h->rq_wait[i];
+		}
+	}
+	lat_hist_show_one(m, "all", "wakeup", total.wakeup);
+	lat_hist_show_one(m, "all", "rq_wait", total.rq_wait);
+}
+
+static void lat_hist_reset(struct sched_lat_hist *(*hist)(void *, int),
+			   void *data)
+{
+	unsigned long flags;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct rq *rq = cpu_rq(cpu);
+
+		raw_spin_lock_irqsave(&rq->lock, flags);
+		memset(hist(data, cpu), 0, sizeof(struct sched_lat_hist));
+		raw_spin_unlock_irqrestore(&rq->lock, flags);
+	}
+}
+
+static struct sched_lat_hist *rq_lat_hist(void *data, int cpu)
+{
+	return &cpu_rq(cpu)->lat_hist;
+}
+
+#ifdef CONFIG_CGROUP_SCHED
+static struct sched_lat_hist *tg_lat_hist(void *data, int cpu)
+{
+	struct task_group *tg = data;
+
+	return per_cpu_ptr(tg->lat_hist, cpu);
+}
+
+int alloc_sched_lat_hist(struct task_group *tg)
+{
+	tg->lat_hist = alloc_percpu(struct sched_lat_hist);
+
+	return tg->lat_hist != NULL;
+}
+
+void free_sched_lat_hist(struct task_group *tg)
+{
+	free_percpu(tg->lat_hist);
+}
+
+/* The root group covers every task, that is the per-rq histograms */
+int sched_lat_hist_tg_show(struct task_group *tg, struct seq_file *m)
+{
+	if (tg == &root_task_group)
+		lat_hist_show(m, rq_lat_hist, NULL);
+	else
+		lat_hist_show(m, tg_lat_hist, tg);
+	return 0;
+}
+
+void sched_lat_hist_tg_reset(struct task_group *tg)
+{
+	if (tg == &root_task_group)
+		lat_hist_reset(rq_lat_hist, NULL);
+	else
+		lat_hist_reset(tg_lat_hist, tg);
+}
+#endif
+
+static int show_sched_lat_hist(struct seq_file *m, void *v)
+{
+	lat_hist_show(m, rq_lat_hist, NULL);
+	return 0;
+}
+
+static int sched_lat_hist_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, show_sched_lat_hist, NULL);
+}
+
+/* Writing anything resets the histograms of all the cpus */
+static ssize_t sched_lat_hist_write(struct file *file,
+				    const char __user *buf,
+				    size_t count, loff_t *ppos)
+{
+	lat_hist_reset(rq_lat_hist, NULL);
+	return count;
+}
+
+static const struct file_operations proc_sched_lat_hist_operations = {
+	.open    = sched_lat_hist_open,
+	.read    = seq_read,
+	.write   = sched_lat_hist_write,
+	.llseek  = seq_lseek,
+	.release = single_release,
+};
+
 static int __init proc_schedstat_init(void)
 {
 	proc_create("schedstat", 0, NULL, &proc_schedstat_operations);
+	proc_create("sched_lat_hist", S_IRUGO | S_IWUSR, NULL,
+		    &proc_sched_lat_hist_operations);
 	return 0;
 }
 module_init(proc_schedstat_init);
@@ -29,6 +29,25 @@ rq_sched_info_dequeued(struct rq *rq, unsigned long long delta)
 	if (rq)
 		rq->rq_sched_info.run_delay += delta;
 }
+
+extern void sched_lat_hist_arrive(struct rq *rq, struct task_struct *t,
+				  unsigned long long now,
+				  unsigned long long wait);
+
+static inline void sched_info_woken(struct task_struct *t)
+{
+	t->sched_info.last_wakeup = rq_clock(task_rq(t));
+}
+
+/*
+ * The wait of a task moved to another rq before it could run is
+ * carried over, so that the histograms see the whole of it.
+ */
+static inline void
+sched_lat_hist_dequeued(struct task_struct *t, unsigned long long delta)
+{
+	t->sched_info.wait_carry += delta;
+}
 # define schedstat_inc(rq, field)	do { (rq)->field++; } while (0)
 # define schedstat_add(rq, field, amt)	do { (rq)->field += (amt); } while (0)
 # define schedstat_set(var, val)	do { var = (val); } while (0)
@@ -42,6 +61,14 @@ rq_sched_info_dequeued(struct rq *rq, unsigned long long delta)
 static inline void
 rq_sched_info_depart(struct rq *rq, unsigned long long delta)
 {}
+static inline void
+sched_lat_hist_arrive(struct rq *rq, struct task_struct *t,
+		      unsigned long long now, unsigned long long wait)
+{}
+static inline void
+sched_lat_hist_dequeued(struct task_struct *t, unsigned long long delta)
+{}
+# define sched_info_woken(t)		do { } while (0)
 # define schedstat_inc(rq, field)	do { } while (0)
 # define schedstat_add(rq, field, amt)	do { } while (0)
 # define schedstat_set(var, val)	do { } while (0)
@@ -70,6 +97,7 @@ static inline void sched_info_dequeued(struct task_struct *t)
 	t->sched_info.run_delay += delta;
 
 	rq_sched_info_dequeued(task_rq(t), delta);
+	sched_lat_hist_dequeued(t, delta);
 }
 
 /*
@@ -89,6 +117,7 @@ static void sched_info_arrive(struct task_struct *t)
 	t->sched_info.pcount++;
 
 	rq_sched_info_arrive(task_rq(t), delta);
+	sched_lat_hist_arrive(task_rq(t), t, now, delta);
 }
 
 /*
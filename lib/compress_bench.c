@@ -0,0 +1,811 @@
+/*
+ * In-kernel compression benchmark
+ *
+ * Runs the in-tree compressors over a corpus supplied through debugfs and
+ * reports compression ratio, compress/decompress throughput and per chunk
+ * latency percentiles, either on one CPU or on every online CPU at once.
+ *
+ *   cd /sys/kernel/debug/compress_bench
+ *   cat swap-sample.bin > corpus		# appends, '>' truncates first
+ *   echo lz4 > algo				# or lzo, lz4hc, deflate, xz, all
+ *   echo 4096 > chunk_size			# bytes per compression call
+ *   echo 1 > all_cpus				# or pick one with 'cpu'
+ *   echo 1 > run
+ *   cat results
+ *
+ * The corpus is cut in chunk_size pieces which are compressed one by one,
+ * the way zram does with pages. xz has no in-kernel compressor, so it is
+ * only run when the corpus itself is an xz stream, which is then decoded
+ * chunk_size bytes of output at a time.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/debugfs.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+#include <linux/slab.h>
+#include <linux/kthread.h>
+#include <linux/completion.h>
+#include <linux/cpu.h>
+#include <linux/ktime.h>
+#include <linux/sort.h>
+#include <linux/mutex.h>
+#include <linux/lzo.h>
+#include <linux/lz4.h>
+#include <linux/zlib.h>
+#include <linux/xz.h>
+
+static unsigned int max_corpus_mb = 32;
+module_param(max_corpus_mb, uint, 0444);
+MODULE_PARM_DESC(max_corpus_mb, "largest corpus accepted, in MiB");
+
+#define CB_MIN_CHUNK		512
+#define CB_MAX_CHUNK		(64 << 10)
+#define CB_XZ_DICT_MAX		(8 << 20)
+#define CB_RESULTS_SIZE		(4 * PAGE_SIZE)
+
+struct cb_worker;
+
+struct cb_algo {
+	const char *name;
+	int (*init)(struct cb_worker *w);
+	void (*exit)(struct cb_worker *w);
+	/* NULL for decompress-only formats, see cb_run_xz() */
+	int (*compress)(struct cb_worker *w, const u8 *src, size_t src_len,
+			u8 *dst, size_t *dst_len);
+	int (*decompress)(struct cb_worker *w, const u8 *src, size_t src_len,
+			  u8 *dst, size_t *dst_len);
+};
+
+struct cb_worker {
+	const struct cb_algo *algo;
+	struct task_struct *task;
+	struct completion done;
+	int cpu;
+	int ret;
+
+	void *wrkmem;
+	z_stream zstream;
+	struct xz_dec *xz;
+
+	u8 *comp;		/* nr_chunks slots of 'stride' bytes */
+	size_t *comp_len;
+	u8 *out;		/* one chunk */
+	size_t stride;
+
+	u32 *comp_lat;		/* per chunk latency in ns */
+	u32 *decomp_lat;
+	unsigned int nr_samples;
+
+	u64 in_bytes;		/* uncompressed bytes handled */
+	u64 out_bytes;		/* compressed bytes produced or consumed */
+	u64 comp_ns;
+	u64 decomp_ns;
+};
+
+static DEFINE_MUTEX(cb_lock);
+static struct dentry *cb_dir;
+
+/* all protected by cb_lock */
+static u8 *corpus;
+static size_t corpus_len;
+static size_t corpus_alloc;
+static char *results;
+static size_t results_len;
+static char algo_name[16] = "all";
+
+/* debugfs knobs, copied to run_chunk/run_loops when a run starts */
+static u32 chunk_size = PAGE_SIZE;
+static u32 loops = 1;
+static u32 bench_cpu;
+static u32 all_cpus;
+
+static size_t run_chunk;
+static unsigned int run_loops;
+
+static size_t nr_chunks(void)
+{
+	return DIV_ROUND_UP(corpus_len, run_chunk);
+}
+
+static size_t chunk_len(size_t i)
+{
+	return min_t(size_t, run_chunk, corpus_len - i * run_chunk);
+}
+
+/* lzo */
+
+static int cb_lzo_init(struct cb_worker *w)
+{
+	w->wrkmem = vmalloc(LZO1X_MEM_COMPRESS);
+	return w->wrkmem ? 0 : -ENOMEM;
+}
+
+static void cb_vfree_wrkmem(struct cb_worker *w)
+{
+	vfree(w->wrkmem);
+}
+
+static int cb_lzo_compress(struct cb_worker *w, const u8 *src,
+			   size_t src_len, u8 *dst, size_t *dst_len)
+{
+	return lzo1x_1_compress(src, src_len, dst, dst_len, w->wrkmem) ?
+		-EINVAL : 0;
+}
+
+static int cb_lzo_decompress(struct cb_worker *w, const u8 *src,
+			     size_t src_len, u8 *dst, size_t *dst_len)
+{
+	return lzo1x_decompress_safe(src, src_len, dst, dst_len) ?
+		-EINVAL : 0;
+}
+
+/* lz4 and lz4hc share the decompressor */
+
+static int cb_lz4_init(struct cb_worker *w)
+{
+	w->wrkmem = vmalloc(LZ4_MEM_COMPRESS);
+	return w->wrkmem ? 0 : -ENOMEM;
+}
+
+static int cb_lz4hc_init(struct cb_worker *w)
+{
+	w->wrkmem = vmalloc(LZ4HC_MEM_COMPRESS);
+	return w->wrkmem ? 0 : -ENOMEM;
+}
+
+static int cb_lz4_compress(struct cb_worker *w, const u8 *src,
+			   size_t src_len, u8 *dst, size_t *dst_len)
+{
+	return lz4_compress(src, src_len, dst, dst_len, w->wrkmem);
+}
+
+static int cb_lz4hc_compress(struct cb_worker *w, const u8 *src,
+			     size_t src_len, u8 *dst, size_t *dst_len)
+{
+	return lz4hc_compress(src, src_len, dst, dst_len, w->wrkmem);
+}
+
+static int cb_lz4_decompress(struct cb_worker *w, const u8 *src,
+			     size_t src_len, u8 *dst, size_t *dst_len)
+{
+	return lz4_decompress_unknownoutputsize(src, src_len, dst, dst_len);
+}
+
+/* deflate, zlib format at the default level */
+
+static int cb_deflate_init(struct cb_worker *w)
+{
+	int size = max(zlib_deflate_workspacesize(MAX_WBITS, DEF_MEM_LEVEL),
+		       zlib_inflate_workspacesize());
+
+	w->wrkmem = vmalloc(size);
+	if (!w->wrkmem)
+		return -ENOMEM;
+	return 0;
+}
+
+static int cb_deflate_compress(struct cb_worker *w, const u8 *src,
+			       size_t src_len, u8 *dst, size_t *dst_len)
+{
+	z_stream *s = &w->zstream;
+	int ret;
+
+	s->workspace = w->wrkmem;
+	ret = zlib_deflateInit2(s, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+				MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+	if (ret != Z_OK)
+		return -EINVAL;
+
+	s->next_in = src;
+	s->avail_in = src_len;
+	s->next_out = dst;
+	s->avail_out = *dst_len;
+	ret = zlib_deflate(s, Z_FINISH);
+	zlib_deflateEnd(s);
+	if (ret != Z_STREAM_END)
+		return -EINVAL;
+
+	*dst_len = s->total_out;
+	return 0;
+}
+
+static int cb_deflate_decompress(struct cb_worker *w, const u8 *src,
+				 size_t src_len, u8 *dst, size_t *dst_len)
+{
+	z_stream *s = &w->zstream;
+	int ret;
+
+	s->workspace = w->wrkmem;
+	ret = zlib_inflateInit2(s, MAX_WBITS);
+	if (ret != Z_OK)
+		return -EINVAL;
+
+	s->next_in = src;
+	s->avail_in = src_len;
+	s->next_out = dst;
+	s->avail_out = *dst_len;
+	ret = zlib_inflate(s, Z_FINISH);
+	zlib_inflateEnd(s);
+	if (ret != Z_STREAM_END)
+		return -EINVAL;
+
+	*dst_len = s->total_out;
+	return 0;
+}
+
+/* xz, decompression only */
+
+static int cb_xz_init(struct cb_worker *w)
+{
+	w->xz = xz_dec_init(XZ_DYNALLOC, CB_XZ_DICT_MAX);
+	return w->xz ? 0 : -ENOMEM;
+}
+
+static void cb_xz_exit(struct cb_worker *w)
+{
+	xz_dec_end(w->xz);
+}
+
+static const struct cb_algo cb_algos[] = {
+	{
+		.name		= "lzo",
+		.init		= cb_lzo_init,
+		.exit		= cb_vfree_wrkmem,
+		.compress	= cb_lzo_compress,
+		.decompress	= cb_lzo_decompress,
+	}, {
+		.name		= "lz4",
+		.init		= cb_lz4_init,
+		.exit		= cb_vfree_wrkmem,
+		.compress	= cb_lz4_compress,
+		.decompress	= cb_lz4_decompress,
+	}, {
+		.name		= "lz4hc",
+		.init		= cb_lz4hc_init,
+		.exit		= cb_vfree_wrkmem,
+		.compress	= cb_lz4hc_compress,
+		.decompress	= cb_lz4_decompress,
+	}, {
+		.name		= "deflate",
+		.init		= cb_deflate_init,
+		.exit		= cb_vfree_wrkmem,
+		.compress	= cb_deflate_compress,
+		.decompress	= cb_deflate_decompress,
+	}, {
+		.name		= "xz",
+		.init		= cb_xz_init,
+		.exit		= cb_xz_exit,
+	},
+};
+
+static inline u32 cb_elapsed(ktime_t start)
+{
+	s64 ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	return min_t(s64, ns, U32_MAX);
+}
+
+/* Compress every chunk, then decompress and check every chunk, loops times */
+static int cb_run_chunks(struct cb_worker *w)
+{
+	const struct cb_algo *algo = w->algo;
+	size_t n = nr_chunks(), i;
+	unsigned int pass;
+	int ret;
+
+	for (pass = 0; pass < run_loops; pass++) {
+		for (i = 0; i < n; i++) {
+			const u8 *src = corpus + i * run_chunk;
+			size_t len = chunk_len(i);
+			ktime_t start;
+			u32 ns;
+
+			w->comp_len[i] = w->stride;
+			start = ktime_get();
+			ret = algo->compress(w, src, len, w->comp + i * w->stride,
+					     &w->comp_len[i]);
+			ns = cb_elapsed(start);
+			if (ret)
+				return ret;
+			w->comp_lat[i] = ns;
+			w->comp_ns += ns;
+			w->in_bytes += len;
+			w->out_bytes += w->comp_len[i];
+		}
+
+		for (i = 0; i < n; i++) {
+			size_t len = run_chunk;
+			ktime_t start;
+			u32 ns;
+
+			start = ktime_get();
+			ret = algo->decompress(w, w->comp + i * w->stride,
+					       w->comp_len[i], w->out, &len);
+			ns = cb_elapsed(start);
+			if (ret)
+				return ret;
+			if (len != chunk_len(i) ||
+			    memcmp(w->out, corpus + i * run_chunk, len))
+				return -EILSEQ;
+			w->decomp_lat[i] = ns;
+			w->decomp_ns += ns;
+		}
+		cond_resched();
+	}
+	w->nr_samples = n;
+
+	return 0;
+}
+
+/* Decode an xz corpus chunk_size bytes of output at a time */
+static int cb_run_xz(struct cb_worker *w)
+{
+	size_t max_samples = nr_chunks();
+	unsigned int pass;
+
+	w->nr_samples = 0;
+	for (pass = 0; pass < run_loops; pass++) {
+		struct xz_buf b = {
+			.in		= corpus,
+			.in_size	= corpus_len,
+			.out		= w->out,
+			.out_size	= run_chunk,
+		};
+		enum xz_ret xret;
+		unsigned int sample = 0;
+
+		xz_dec_reset(w->xz);
+		do {
+			ktime_t start = ktime_get();
+			u32 ns;
+
+			b.out_pos = 0;
+			xret = xz_dec_run(w->xz, &b);
+			ns = cb_elapsed(start);
+			w->decomp_ns += ns;
+			w->in_bytes += b.out_pos;
+			if (sample < max_samples)
+				w->decomp_lat[sample++] = ns;
+		} while (xret == XZ_OK);
+
+		if (xret != XZ_STREAM_END)
+			return -EILSEQ;
+		w->out_bytes += corpus_len;
+		w->nr_samples = sample;
+		cond_resched();
+	}
+
+	return 0;
+}
+
+static int cb_worker_fn(void *data)
+{
+	struct cb_worker *w = data;
+
+	w->ret = w->algo->compress ? cb_run_chunks(w) : cb_run_xz(w);
+	complete(&w->done);
+
+	/* the creator reaps us with kthread_stop() */
+	while (!kthread_should_stop()) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (!kthread_should_stop())
+			schedule();
+		__set_current_state(TASK_RUNNING);
+	}
+
+	return 0;
+}
+
+static void cb_worker_free(struct cb_worker *w)
+{
+	if (w->algo)
+		w->algo->exit(w);
+	vfree(w->decomp_lat);
+	vfree(w->comp_lat);
+	kfree(w->out);
+	vfree(w->comp_len);
+	vfree(w->comp);
+}
+
+static int cb_worker_alloc(struct cb_worker *w, const struct cb_algo *algo,
+			   int cpu)
+{
+	size_t n = nr_chunks();
+	int ret;
+
+	memset(w, 0, sizeof(*w));
+	w->cpu = cpu;
+	init_completion(&w->done);
+
+	/* worst case of all the compressors, deflate adds the most */
+	w->stride = run_chunk + run_chunk / 8 + 64;
+	w->out = kmalloc(run_chunk, GFP_KERNEL);
+	w->comp_lat = vmalloc(n * sizeof(u32));
+	w->decomp_lat = vmalloc(n * sizeof(u32));
+	if (!w->out || !w->comp_lat || !w->decomp_lat)
+		goto nomem;
+
+	if (algo->compress) {
+		w->comp = vmalloc(n * w->stride);
+		w->comp_len = vmalloc(n * sizeof(size_t));
+		if (!w->comp || !w->comp_len)
+			goto nomem;
+	}
+
+	ret = algo->init(w);
+	if (ret) {
+		cb_worker_free(w);
+		return ret;
+	}
+	w->algo = algo;
+
+	return 0;
+
+nomem:
+	cb_worker_free(w);
+	return -ENOMEM;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+	u32 x = *(const u32 *)a, y = *(const u32 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* Merge the samples of all workers and print p50/p90/p99/max in us */
+static void cb_report_lat(const char *what, struct cb_worker *workers,
+			  int nr_workers, bool comp)
+{
+	unsigned int total = 0, i, pos = 0;
+	u32 *all;
+	int j;
+
+	for (j = 0; j < nr_workers; j++)
+		total += workers[j].nr_samples;
+	if (!total)
+		return;
+
+	all = vmalloc(total * sizeof(u32));
+	if (!all)
+		return;
+	for (j = 0; j < nr_workers; j++) {
+		u32 *lat = comp ? workers[j].comp_lat : workers[j].decomp_lat;
+
+		for (i = 0; i < workers[j].nr_samples; i++)
+			all[pos++] = lat[i];
+	}
+	sort(all, total, sizeof(u32), cmp_u32, NULL);
+
+	results_len += scnprintf(results + results_len,
+			CB_RESULTS_SIZE - results_len,
+			"  %-10s latency us: p50 %u.%03u p90 %u.%03u p99 %u.%03u max %u.%03u\n",
+			what,
+			all[total / 2] / 1000, all[total / 2] % 1000,
+			all[total * 9 / 10] / 1000, all[total * 9 / 10] % 1000,
+			all[total * 99 / 100] / 1000,
+			all[total * 99 / 100] % 1000,
+			all[total - 1] / 1000, all[total - 1] % 1000);
+	vfree(all);
+}
+
+static unsigned long cb_mbps(u64 bytes, u64 ns)
+{
+	return div64_u64(bytes * NSEC_PER_SEC, ns ?: 1) >> 20;
+}
+
+static int cb_run_algo(const struct cb_algo *algo)
+{
+	struct cb_worker *workers;
+	u64 in = 0, out = 0, comp_ns = 0, decomp_ns = 0, wall_ns;
+	int nr_workers, cpu, i = 0, ret = 0;
+	char comp_mbps[24];
+	ktime_t start;
+
+	if (!algo->compress &&
+	    (corpus_len < 6 || memcmp(corpus, "\3757zXZ", 6))) {
+		results_len += scnprintf(results + results_len,
+				CB_RESULTS_SIZE - results_len,
+				"%s: skipped, corpus is not an xz stream\n",
+				algo->name);
+		return 0;
+	}
+
+	get_online_cpus();
+	nr_workers = all_cpus ? num_online_cpus() : 1;
+	if (!all_cpus && (bench_cpu >= nr_cpu_ids || !cpu_online(bench_cpu))) {
+		ret = -EINVAL;
+		goto out_cpus;
+	}
+
+	workers = kcalloc(nr_workers, sizeof(*workers), GFP_KERNEL);
+	if (!workers) {
+		ret = -ENOMEM;
+		goto out_cpus;
+	}
+
+	for_each_online_cpu(cpu) {
+		if (!all_cpus && cpu != bench_cpu)
+			continue;
+		ret = cb_worker_alloc(&workers[i], algo, cpu);
+		if (ret)
+			goto out_free;
+		workers[i].task = kthread_create(cb_worker_fn, &workers[i],
+						 "compress_bench/%d", cpu);
+		if (IS_ERR(workers[i].task)) {
+			ret = PTR_ERR(workers[i].task);
+			workers[i].task = NULL;
+			i++;
+			goto out_free;
+		}
+		kthread_bind(workers[i].task, cpu);
+		i++;
+	}
+
+	start = ktime_get();
+	for (i = 0; i < nr_workers; i++)
+		wake_up_process(workers[i].task);
+	for (i = 0; i < nr_workers; i++)
+		wait_for_completion(&workers[i].done);
+	wall_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	for (i = 0; i < nr_workers; i++) {
+		if (workers[i].ret && !ret) {
+			ret = workers[i].ret;
+			pr_err("compress_bench: %s failed on cpu %d (%d)\n",
+			       algo->name, workers[i].cpu, ret);
+		}
+		in += workers[i].in_bytes;
+		out += workers[i].out_bytes;
+		comp_ns += workers[i].comp_ns;
+		decomp_ns += workers[i].decomp_ns;
+	}
+	if (ret)
+		goto out_free;
+
+	/* decompress-only algorithms have nothing to show for compression */
+	if (comp_ns)
+		snprintf(comp_mbps, sizeof(comp_mbps), "%lu MB/s",
+			 cb_mbps(in, comp_ns));
+	else
+		strlcpy(comp_mbps, "n/a", sizeof(comp_mbps));
+
+	results_len += scnprintf(results + results_len,
+			CB_RESULTS_SIZE - results_len,
+			"%s: %d cpu(s), %zu bytes x %u, chunk %u\n"
+			"  ratio %llu.%02llu%%, per cpu compress %s, decompress %lu MB/s, aggregate %lu MB/s\n",
+			algo->name, nr_workers, corpus_len, run_loops, run_chunk,
+			div64_u64(out * 100, in ?: 1),
+			div64_u64(out * 10000, in ?: 1) % 100,
+			comp_mbps, cb_mbps(in, decomp_ns),
+			cb_mbps(in, wall_ns));
+	if (algo->compress)
+		cb_report_lat("compress", workers, nr_workers, true);
+	cb_report_lat("decompress", workers, nr_workers, false);
+
+	i = nr_workers;
+out_free:
+	while (i--) {
+		if (workers[i].task)
+			kthread_stop(workers[i].task);
+		cb_worker_free(&workers[i]);
+	}
+	kfree(workers);
+out_cpus:
+	put_online_cpus();
+	return ret;
+}
+
+static int cb_run(void)
+{
+	bool all = !strcmp(algo_name, "all");
+	int i, ret = -EINVAL;
+
+	if (!corpus_len)
+		return -ENODATA;
+	if (chunk_size < CB_MIN_CHUNK || chunk_size > CB_MAX_CHUNK || !loops)
+		return -EINVAL;
+	run_chunk = chunk_size;
+	run_loops = loops;
+
+	results_len = 0;
+	results[0] = '\0';
+	for (i = 0; i < ARRAY_SIZE(cb_algos); i++) {
+		if (!all && strcmp(algo_name, cb_algos[i].name))
+			continue;
+		ret = cb_run_algo(&cb_algos[i]);
+		if (ret)
+			break;
+	}
+
+	return ret;
+}
+
+static int corpus_open(struct inode *inode, struct file *file)
+{
+	if (file->f_flags & O_TRUNC) {
+		mutex_lock(&cb_lock);
+		corpus_len = 0;
+		mutex_unlock(&cb_lock);
+	}
+	return nonseekable_open(inode, file);
+}
+
+/* Append to the corpus, growing the buffer by doubling */
+static ssize_t corpus_write(struct file *file, const char __user *buf,
+			    size_t count, loff_t *ppos)
+{
+	size_t max = (size_t)max_corpus_mb << 20;
+	ssize_t ret = count;
+
+	mutex_lock(&cb_lock);
+	if (corpus_len + count > max) {
+		ret = -EFBIG;
+		goto out;
+	}
+	if (corpus_len + count > corpus_alloc) {
+		size_t alloc = max_t(size_t, corpus_alloc * 2, PAGE_SIZE);
+		u8 *p;
+
+		while (alloc < corpus_len + count)
+			alloc *= 2;
+		alloc = min(alloc, max);
+		p = vmalloc(alloc);
+		if (!p) {
+			ret = -ENOMEM;
+			goto out;
+		}
+		if (corpus)
+			memcpy(p, corpus, corpus_len);
+		vfree(corpus);
+		corpus = p;
+		corpus_alloc = alloc;
+	}
+	if (copy_from_user(corpus + corpus_len, buf, count)) {
+		ret = -EFAULT;
+		goto out;
+	}
+	corpus_len += count;
+out:
+	mutex_unlock(&cb_lock);
+	return ret;
+}
+
+static const struct file_operations corpus_fops = {
+	.owner	= THIS_MODULE,
+	.open	= corpus_open,
+	.write	= corpus_write,
+	.llseek	= no_llseek,
+};
+
+static ssize_t algo_read(struct file *file, char __user *buf, size_t count,
+			 loff_t *ppos)
+{
+	char tmp[sizeof(algo_name) + 1];
+	int len;
+
+	mutex_lock(&cb_lock);
+	len = scnprintf(tmp, sizeof(tmp), "%s\n", algo_name);
+	mutex_unlock(&cb_lock);
+
+	return simple_read_from_buffer(buf, count, ppos, tmp, len);
+}
+
+static ssize_t algo_write(struct file *file, const char __user *buf,
+			  size_t count, loff_t *ppos)
+{
+	char tmp[sizeof(algo_name)];
+	int i;
+
+	if (count >= sizeof(tmp))
+		return -EINVAL;
+	if (copy_from_user(tmp, buf, count))
+		return -EFAULT;
+	tmp[count] = '\0';
+	strim(tmp);
+
+	if (strcmp(tmp, "all")) {
+		for (i = 0; i < ARRAY_SIZE(cb_algos); i++)
+			if (!strcmp(tmp, cb_algos[i].name))
+				break;
+		if (i == ARRAY_SIZE(cb_algos))
+			return -EINVAL;
+	}
+
+	mutex_lock(&cb_lock);
+	strlcpy(algo_name, strim(tmp), sizeof(algo_name));
+	mutex_unlock(&cb_lock);
+
+	return count;
+}
+
+static const struct file_operations algo_fops = {
+	.owner	= THIS_MODULE,
+	.open	= simple_open,
+	.read	= algo_read,
+	.write	= algo_write,
+	.llseek	= default_llseek,
+};
+
+static ssize_t run_write(struct file *file, const char __user *buf,
+			 size_t count, loff_t *ppos)
+{
+	int ret;
+
+	mutex_lock(&cb_lock);
+	ret = cb_run();
+	mutex_unlock(&cb_lock);
+
+	return ret ? ret : count;
+}
+
+static const struct file_operations run_fops = {
+	.owner	= THIS_MODULE,
+	.open	= simple_open,
+	.write	= run_write,
+	.llseek	= noop_llseek,
+};
+
+static ssize_t results_read(struct file *file, char __user *buf,
+			    size_t count, loff_t *ppos)
+{
+	ssize_t ret;
+
+	mutex_lock(&cb_lock);
+	ret = simple_read_from_buffer(buf, count, ppos, results, results_len);
+	mutex_unlock(&cb_lock);
+
+	return ret;
+}
+
+static const struct file_operations results_fops = {
+	.owner	= THIS_MODULE,
+	.open	= simple_open,
+	.read	= results_read,
+	.llseek	= default_llseek,
+};
+
+static int __init compress_bench_init(void)
+{
+	results = kzalloc(CB_RESULTS_SIZE, GFP_KERNEL);
+	if (!results)
+		return -ENOMEM;
+
+	cb_dir = debugfs_create_dir("compress_bench", NULL);
+	if (IS_ERR_OR_NULL(cb_dir)) {
+		kfree(results);
+		return -ENODEV;
+	}
+
+	debugfs_create_file("corpus", S_IWUSR, cb_dir, NULL, &corpus_fops);
+	debugfs_create_file("algo", S_IRUSR | S_IWUSR, cb_dir, NULL,
+			    &algo_fops);
+	debugfs_create_file("run", S_IWUSR, cb_dir, NULL, &run_fops);
+	debugfs_create_file("results", S_IRUSR, cb_dir, NULL, &results_fops);
+	debugfs_create_u32("chunk_size", S_IRUSR | S_IWUSR, cb_dir,
+			   &chunk_size);
+	debugfs_create_u32("loops", S_IRUSR | S_IWUSR, cb_dir, &loops);
+	debugfs_create_u32("cpu", S_IRUSR | S_IWUSR, cb_dir, &bench_cpu);
+	debugfs_create_bool("all_cpus", S_IRUSR | S_IWUSR, cb_dir, &all_cpus);
+
+	return 0;
+}
+
+static void __exit compress_bench_exit(void)
+{
+	debugfs_remove_recursive(cb_dir);
+	vfree(corpus);
+	kfree(results);
+}
+
+module_init(compress_bench_init);
+module_exit(compress_bench_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Compression ratio, throughput and latency benchmark");
@@ -174,6 +174,63 @@ static inline u32 __pure crc32_le_generic(u32 crc, unsigned char const *p,
 	return crc;
 }
 
+#ifdef CONFIG_CRC32_NEON
+#include <linux/hardirq.h>
+#include <asm/unaligned.h>
+#include <asm/neon.h>
+#include <asm/crc32.h>
+
+/*
+ * Below this length the cost of saving the VFP state in kernel_neon_begin()
+ * is not recovered.
+ */
+#define CRC32_NEON_MIN_LEN	256
+
+/* bit reflected x^575, x^511, x^191 and x^127 mod P, see crc32-neon.S */
+static const u64 crc32_neon_k[4] = {
+	0x653d982200000000ULL, 0xcad38e8f00000000ULL,
+	0x65673b4600000000ULL, 0x9ba54c6f00000000ULL,
+};
+static const u64 crc32c_neon_k[4] = {
+	0x1c19243b00000000ULL, 0x75bba45b00000000ULL,
+	0x3743f7bd00000000ULL, 0x3171d43000000000ULL,
+};
+
+static inline bool crc32_use_neon(size_t len)
+{
+	return len >= CRC32_NEON_MIN_LEN && cpu_has_neon() && !in_interrupt();
+}
+
+/*
+ * Fold all whole 64 byte chunks with NEON down to 16 bytes that leave the
+ * same remainder, then let the table code reduce those and the tail.
+ */
+static u32 crc32_le_neon(u32 crc, unsigned char const *p, size_t len,
+			 const u32 (*tab)[256], u32 polynomial, const u64 *k)
+{
+	u8 acc[64];
+	size_t chunks = len / 64 - 1;
+
+	memcpy(acc, p, sizeof(acc));
+	put_unaligned_le32(get_unaligned_le32(acc) ^ crc, acc);
+
+	kernel_neon_begin();
+	crc32_neon_fold(acc, p + sizeof(acc), chunks, k);
+	kernel_neon_end();
+
+	crc = crc32_le_generic(0, acc, 16, tab, polynomial);
+	p += (chunks + 1) * 64;
+	return crc32_le_generic(crc, p, len % 64, tab, polynomial);
+}
+#else
+static inline bool crc32_use_neon(size_t len)
+{
+	return false;
+}
+
+#define crc32_le_neon(crc, p, len, tab, polynomial, k)	(crc)
+#endif /* CONFIG_CRC32_NEON */
+
 #if CRC_LE_BITS == 1
 u32 __pure crc32_le(u32 crc, unsigned char const *p, size_t len)
 {
@@ -186,10 +243,16 @@ u32 __pure __crc32c_le(u32 crc, unsigned char const *p, size_t len)
 #else
 u32 __pure crc32_le(u32 crc, unsigned char const *p, size_t len)
 {
+	if (crc32_use_neon(len))
+		return crc32_le_neon(crc, p, len, crc32table_le, CRCPOLY_LE,
+				     crc32_neon_k);
 	return crc32_le_generic(crc, p, len, crc32table_le, CRCPOLY_LE);
 }
 u32 __pure __crc32c_le(u32 crc, unsigned char const *p, size_t len)
 {
+	if (crc32_use_neon(len))
+		return crc32_le_neon(crc, p, len, crc32ctable_le,
+				     CRC32C_POLY_LE, crc32c_neon_k);
 	return crc32_le_generic(crc, p, len, crc32ctable_le, CRC32C_POLY_LE);
 }
 #endif
@@ -1099,10 +1162,97 @@ static int __init crc32_test(void)
 	return 0;
 }
 
+#ifdef CONFIG_CRC32_NEON
+static u64 __init crc32_neon_time(bool neon, const u32 (*tab)[256],
+				  u32 polynomial, const u64 *k, size_t len)
+{
+	struct timespec start, stop;
+	static u32 crc;
+	int i;
+
+	getnstimeofday(&start);
+	for (i = 0; i < 1000; i++) {
+		if (neon)
+			crc ^= crc32_le_neon(crc, test_buf, len, tab,
+					     polynomial, k);
+		else
+			crc ^= crc32_le_generic(crc, test_buf, len, tab,
+						polynomial);
+	}
+	getnstimeofday(&stop);
+
+	return stop.tv_nsec - start.tv_nsec +
+		1000000000ULL * (stop.tv_sec - start.tv_sec) + 1;
+}
+
+static int __init crc32_neon_test(void)
+{
+	static const size_t lens[] = { 256, 1000, 4088 };
+	u64 nsec[4];
+	int i, off, errors = 0;
+
+	if (!cpu_has_neon()) {
+		pr_info("crc32 neon: no NEON, skipping\n");
+		return 0;
+	}
+
+	/* every offset, so the unaligned loads in the fold loop get used */
+	for (i = 0; i < ARRAY_SIZE(lens); i++) {
+		for (off = 0; off < 8; off++) {
+			if (crc32_le_neon(test[i].crc, test_buf + off, lens[i],
+					  crc32table_le, CRCPOLY_LE,
+					  crc32_neon_k) !=
+			    crc32_le_generic(test[i].crc, test_buf + off,
+					     lens[i], crc32table_le,
+					     CRCPOLY_LE))
+				errors++;
+			if (crc32_le_neon(test[i].crc, test_buf + off, lens[i],
+					  crc32ctable_le, CRC32C_POLY_LE,
+					  crc32c_neon_k) !=
+			    crc32_le_generic(test[i].crc, test_buf + off,
+					     lens[i], crc32ctable_le,
+					     CRC32C_POLY_LE))
+				errors++;
+		}
+	}
+	if (errors) {
+		pr_warn("crc32 neon: %d self tests failed\n", errors);
+		return 0;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(lens); i++) {
+		nsec[0] = crc32_neon_time(false, crc32table_le, CRCPOLY_LE,
+					  NULL, lens[i]);
+		nsec[1] = crc32_neon_time(true, crc32table_le, CRCPOLY_LE,
+					  crc32_neon_k, lens[i]);
+		nsec[2] = crc32_neon_time(false, crc32ctable_le,
+					  CRC32C_POLY_LE, NULL, lens[i]);
+		nsec[3] = crc32_neon_time(true, crc32ctable_le,
+					  CRC32C_POLY_LE, crc32c_neon_k,
+					  lens[i]);
+		pr_info("crc32 neon: %4zu bytes: crc32 %llu/%llu, crc32c %llu/%llu MB/s (table/neon)\n",
+			lens[i],
+			div64_u64(1000ULL * lens[i] * 1000, nsec[0]),
+			div64_u64(1000ULL * lens[i] * 1000, nsec[1]),
+			div64_u64(1000ULL * lens[i] * 1000, nsec[2]),
+			div64_u64(1000ULL * lens[i] * 1000, nsec[3]));
+	}
+	pr_info("crc32 neon: self tests passed\n");
+
+	return 0;
+}
+#else
+static inline int crc32_neon_test(void)
+{
+	return 0;
+}
+#endif /* CONFIG_CRC32_NEON */
+
 static int __init crc32test_init(void)
 {
 	crc32_test();
 	crc32c_test();
+	crc32_neon_test();
 	return 0;
 }
 
@@ -0,0 +1,26 @@
+/*
+ * LZ4 Decompressor for Linux kernel, NEON copy kernels
+ *
+ * Copyright (C) 2013, LG Electronics, Kyungsik Lee <kyungsik.lee@lge.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This unit is built with -mfpu=neon and pulls in the generic decoder with
+ * LZ4_NEON set, which swaps the wild copy used for literal runs and matches
+ * for a 16 byte NEON one. Callers must bracket it with kernel_neon_begin()
+ * and kernel_neon_end(), see lz4_decompress() in lz4_uncompress.c. Both
+ * units are linked into the lz4_decompress module.
+ */
+
+#ifndef __ARM_NEON__
+#error You should compile this file with '-mfloat-abi=softfp -mfpu=neon'
+#endif
+
+#define LZ4_NEON
+#define lz4_uncompress lz4_uncompress_neon_inner
+#define lz4_uncompress_unknownoutputsize \
+	lz4_uncompress_unknownoutputsize_neon_inner
+
+#include "lz4_uncompress.c"
@@ -47,7 +47,34 @@
 
 #include "lz4defs.h"
 
-static int lz4_uncompress(const char *source, char *dest, int osize)
+#if defined(CONFIG_LZ4_DECOMPRESS_NEON) && !defined(STATIC) && \
+	!defined(LZ4_NEON)
+#define LZ4_NEON_DISPATCH
+#include <linux/hardirq.h>
+#include <asm/neon.h>
+
+int lz4_uncompress_neon_inner(const char *source, char *dest, int osize);
+int lz4_uncompress_unknownoutputsize_neon_inner(const char *source,
+				char *dest, int isize, size_t maxoutputsize);
+
+/*
+ * The NEON copy kernels live in their own compilation unit, see
+ * lz4_decompress_neon.c. Like the NEON xor templates they cannot be used
+ * from interrupt context, where we fall back to the C loops.
+ */
+static inline bool lz4_use_neon(void)
+{
+	return cpu_has_neon() && !in_interrupt();
+}
+#endif
+
+#ifdef LZ4_NEON
+#define LZ4_DECOMPRESS_LINKAGE
+#else
+#define LZ4_DECOMPRESS_LINKAGE static
+#endif
+
+LZ4_DECOMPRESS_LINKAGE int lz4_uncompress(const char *source, char *dest, int osize)
 {
 	const BYTE *ip = (const BYTE *) source;
 	const BYTE *ref;
@@ -162,7 +189,7 @@ _output_error:
 	return -1;
 }
 
-static int lz4_uncompress_unknownoutputsize(const char *source, char *dest,
+LZ4_DECOMPRESS_LINKAGE int lz4_uncompress_unknownoutputsize(const char *source, char *dest,
 				int isize, size_t maxoutputsize)
 {
 	const BYTE *ip = (const BYTE *) source;
@@ -291,13 +318,22 @@ _output_error:
 	return -1;
 }
 
+#ifndef LZ4_NEON
 int lz4_decompress(const unsigned char *src, size_t *src_len,
 		unsigned char *dest, size_t actual_dest_len)
 {
 	int ret = -1;
 	int input_len = 0;
 
-	input_len = lz4_uncompress(src, dest, actual_dest_len);
+#ifdef LZ4_NEON_DISPATCH
+	if (lz4_use_neon()) {
+		kernel_neon_begin();
+		input_len = lz4_uncompress_neon_inner(src, dest,
+						actual_dest_len);
+		kernel_neon_end();
+	} else
+#endif
+		input_len = lz4_uncompress(src, dest, actual_dest_len);
 	if (input_len < 0)
 		goto exit_0;
 	*src_len = input_len;
@@ -310,13 +346,41 @@ exit_0:
 EXPORT_SYMBOL(lz4_decompress);
 #endif
 
+#ifdef LZ4_NEON_DISPATCH
+/*
+ * lz4_decompress() without the NEON copy kernels, so the self-test can
+ * compare the two implementations against each other.
+ */
+int lz4_decompress_generic(const unsigned char *src, size_t *src_len,
+		unsigned char *dest, size_t actual_dest_len)
+{
+	int input_len;
+
+	input_len = lz4_uncompress(src, dest, actual_dest_len);
+	if (input_len < 0)
+		return -1;
+	*src_len = input_len;
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(lz4_decompress_generic);
+#endif
+
 int lz4_decompress_unknownoutputsize(const unsigned char *src, size_t src_len,
 		unsigned char *dest, size_t *dest_len)
 {
 	int ret = -1;
 	int out_len = 0;
 
-	out_len = lz4_uncompress_unknownoutputsize(src, dest, src_len,
+#ifdef LZ4_NEON_DISPATCH
+	if (lz4_use_neon()) {
+		kernel_neon_begin();
+		out_len = lz4_uncompress_unknownoutputsize_neon_inner(src,
+					dest, src_len, *dest_len);
+		kernel_neon_end();
+	} else
+#endif
+		out_len = lz4_uncompress_unknownoutputsize(src, dest, src_len,
 					*dest_len);
 	if (out_len < 0)
 		goto exit_0;
@@ -332,3 +396,4 @@ EXPORT_SYMBOL(lz4_decompress_unknownoutputsize);
 MODULE_LICENSE("Dual BSD/GPL");
 MODULE_DESCRIPTION("LZ4 Decompressor");
 #endif
+#endif /* !LZ4_NEON */
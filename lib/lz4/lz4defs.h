@@ -155,3 +155,34 @@ typedef struct _U64_S { u64 v; } U64_S;
 		LZ4_WILDCOPY(s, d, e);	\
 		d = e;	\
 	} while (0)
+
+#ifdef LZ4_NEON
+/*
+ * NEON wild copy, only built into lz4_decompress_neon.c and only run between
+ * kernel_neon_begin()/kernel_neon_end(). It moves 16 bytes per step while a
+ * full step fits before 'e' and the source does not trail the destination by
+ * less than 16 bytes, then finishes with the regular packets so the overrun
+ * past 'e' never exceeds that of the generic copy.
+ */
+static inline void lz4_neon_copy16(BYTE *d, const BYTE *s)
+{
+	asm volatile(
+	"	vld1.8	{d0-d1}, [%1]\n"
+	"	vst1.8	{d0-d1}, [%0]\n"
+	: : "r" (d), "r" (s) : "d0", "d1", "memory");
+}
+
+#undef LZ4_WILDCOPY
+#define LZ4_WILDCOPY(s, d, e)					\
+	do {							\
+		if ((const BYTE *)(s) >= (d) || (d) - (s) >= 16) {	\
+			while ((e) - (d) >= 16) {		\
+				lz4_neon_copy16(d, s);		\
+				d += 16;			\
+				s += 16;			\
+			}					\
+		}						\
+		while ((d) < (e))				\
+			LZ4_COPYPACKET(s, d);			\
+	} while (0)
+#endif
@@ -119,7 +119,8 @@ static inline size_t lz4hc_commonlength(const u8 *p1, const u8 *p2,
 }
 
 static inline int lz4hc_insertandfindbestmatch(struct lz4hc_data *hc4,
-		const u8 *ip, const u8 *const matchlimit, const u8 **matchpos)
+		const u8 *ip, const u8 *const matchlimit, const u8 **matchpos,
+		int maxattempts)
 {
 	u16 *const chaintable = hc4->chaintable;
 	HTYPE *const hashtable = hc4->hashtable;
@@ -129,7 +130,7 @@ static inline int lz4hc_insertandfindbestmatch(struct lz4hc_data *hc4,
 #else
 	const int base = 0;
 #endif
-	int nbattempts = MAX_NB_ATTEMPTS;
+	int nbattempts = maxattempts;
 	size_t repl = 0, ml = 0;
 	u16 delta;
 
@@ -189,7 +190,7 @@ static inline int lz4hc_insertandfindbestmatch(struct lz4hc_data *hc4,
 
 static inline int lz4hc_insertandgetwidermatch(struct lz4hc_data *hc4,
 	const u8 *ip, const u8 *startlimit, const u8 *matchlimit, int longest,
-	const u8 **matchpos, const u8 **startpos)
+	const u8 **matchpos, const u8 **startpos, int maxattempts)
 {
 	u16 *const chaintable = hc4->chaintable;
 	HTYPE *const hashtable = hc4->hashtable;
@@ -199,7 +200,7 @@ static inline int lz4hc_insertandgetwidermatch(struct lz4hc_data *hc4,
 	const int base = 0;
 #endif
 	const u8 *ref;
-	int nbattempts = MAX_NB_ATTEMPTS;
+	int nbattempts = maxattempts;
 	int delta = (int)(ip - startlimit);
 
 	/* First Match */
@@ -317,7 +318,8 @@ static inline int lz4_encodesequence(const u8 **ip, u8 **op, const u8 **anchor,
 static int lz4_compresshcctx(struct lz4hc_data *ctx,
 		const char *source,
 		char *dest,
-		int isize)
+		int isize,
+		int maxattempts)
 {
 	const u8 *ip = (const u8 *)source;
 	const u8 *anchor = ip;
@@ -341,7 +343,8 @@ static int lz4_compresshcctx(struct lz4hc_data *ctx,
 
 	/* Main Loop */
 	while (ip < mflimit) {
-		ml = lz4hc_insertandfindbestmatch(ctx, ip, matchlimit, (&ref));
+		ml = lz4hc_insertandfindbestmatch(ctx, ip, matchlimit, (&ref),
+				maxattempts);
 		if (!ml) {
 			ip++;
 			continue;
@@ -354,7 +357,8 @@ static int lz4_compresshcctx(struct lz4hc_data *ctx,
 _search2:
 		if (ip+ml < mflimit)
 			ml2 = lz4hc_insertandgetwidermatch(ctx, ip + ml - 2,
-				ip + 1, matchlimit, ml, &ref2, &start2);
+				ip + 1, matchlimit, ml, &ref2, &start2,
+				maxattempts);
 		else
 			ml2 = ml;
 		/* No better match */
@@ -409,7 +413,7 @@ _search3:
 		if (start2 + ml2 < mflimit)
 			ml3 = lz4hc_insertandgetwidermatch(ctx,
 				start2 + ml2 - 3, start2, matchlimit,
-				ml2, &ref3, &start3);
+				ml2, &ref3, &start3, maxattempts);
 		else
 			ml3 = ml2;
 
@@ -513,16 +517,24 @@ _search3:
 	return (int) (((char *)op) - dest);
 }
 
-int lz4hc_compress(const unsigned char *src, size_t src_len,
-			unsigned char *dst, size_t *dst_len, void *wrkmem)
+int lz4hc_compress_level(const unsigned char *src, size_t src_len,
+			unsigned char *dst, size_t *dst_len, void *wrkmem,
+			int level)
 {
 	int ret = -1;
 	int out_len = 0;
-
 	struct lz4hc_data *hc4 = (struct lz4hc_data *)wrkmem;
+
+	if (level < LZ4HC_MIN_LEVEL)
+		level = LZ4HC_MIN_LEVEL;
+	else if (level > LZ4HC_MAX_LEVEL)
+		level = LZ4HC_MAX_LEVEL;
+
 	lz4hc_init(hc4, (const u8 *)src);
+	/* each level doubles the hash chain walk, up to MAX_NB_ATTEMPTS */
 	out_len = lz4_compresshcctx((struct lz4hc_data *)hc4, (const u8 *)src,
-		(char *)dst, (int)src_len);
+		(char *)dst, (int)src_len,
+		MAX_NB_ATTEMPTS >> (LZ4HC_MAX_LEVEL - level));
 
 	if (out_len < 0)
 		goto exit;
@@ -533,6 +545,14 @@ int lz4hc_compress(const unsigned char *src, size_t src_len,
 exit:
 	return ret;
 }
+EXPORT_SYMBOL(lz4hc_compress_level);
+
+int lz4hc_compress(const unsigned char *src, size_t src_len,
+			unsigned char *dst, size_t *dst_len, void *wrkmem)
+{
+	return lz4hc_compress_level(src, src_len, dst, dst_len, wrkmem,
+			LZ4HC_MAX_LEVEL);
+}
 EXPORT_SYMBOL(lz4hc_compress);
 
 MODULE_LICENSE("Dual BSD/GPL");
@@ -0,0 +1,18 @@
+/*
+ *  LZO1X Decompressor, NEON copy kernels
+ *
+ *  This unit is built with -mfpu=neon and pulls in the safe decompressor
+ *  with LZO_NEON set, so literal runs and matches at least 16 bytes apart
+ *  are moved 16 bytes at a time. It is only ever entered through
+ *  lzo1x_decompress_safe(), between kernel_neon_begin() and
+ *  kernel_neon_end().
+ */
+
+#ifndef __ARM_NEON__
+#error You should compile this file with '-mfloat-abi=softfp -mfpu=neon'
+#endif
+
+#define LZO_NEON
+#define lzo1x_decompress_safe lzo1x_decompress_safe_neon_inner
+
+#include "lzo1x_decompress_safe.c"
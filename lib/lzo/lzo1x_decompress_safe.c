@@ -19,6 +19,19 @@
 #include <linux/lzo.h>
 #include "lzodefs.h"
 
+#if defined(CONFIG_LZO_DECOMPRESS_NEON) && !defined(STATIC) && \
+	!defined(LZO_NEON)
+#define LZO_NEON_DISPATCH
+#include <linux/hardirq.h>
+#include <asm/neon.h>
+
+int lzo1x_decompress_safe_neon_inner(const unsigned char *in, size_t in_len,
+				     unsigned char *out, size_t *out_len);
+
+/* The C body below becomes the fallback, lzo1x_decompress_safe() dispatches */
+#define lzo1x_decompress_safe lzo1x_decompress_safe_generic
+#endif
+
 #define HAVE_IP(x)      ((size_t)(ip_end - ip) >= (size_t)(x))
 #define HAVE_OP(x)      ((size_t)(op_end - op) >= (size_t)(x))
 #define NEED_IP(x)      if (!HAVE_IP(x)) goto input_overrun
@@ -86,13 +99,19 @@ copy_literal_run:
 					const unsigned char *ie = ip + t;
 					unsigned char *oe = op + t;
 					do {
+#  if defined(LZO_NEON)
+						COPY16(op, ip);
+						op += 16;
+						ip += 16;
+#  else
 						COPY8(op, ip);
 						op += 8;
 						ip += 8;
-#  if !defined(__arm__)
+#   if !defined(__arm__)
 						COPY8(op, ip);
 						op += 8;
 						ip += 8;
+#   endif
 #  endif
 					} while (ip < ie);
 					ip = ie;
@@ -188,6 +207,15 @@ copy_literal_run:
 		if (op - m_pos >= 8) {
 			unsigned char *oe = op + t;
 			if (likely(HAVE_OP(t + 15))) {
+#  if defined(LZO_NEON)
+				if (op - m_pos >= 16) {
+					do {
+						COPY16(op, m_pos);
+						op += 16;
+						m_pos += 16;
+					} while (op < oe);
+				} else
+#  endif
 				do {
 					COPY8(op, m_pos);
 					op += 8;
@@ -263,7 +291,28 @@ lookbehind_overrun:
 	*out_len = op - out;
 	return LZO_E_LOOKBEHIND_OVERRUN;
 }
-#ifndef STATIC
+#ifdef LZO_NEON_DISPATCH
+#undef lzo1x_decompress_safe
+EXPORT_SYMBOL_GPL(lzo1x_decompress_safe_generic);
+
+int lzo1x_decompress_safe(const unsigned char *in, size_t in_len,
+			  unsigned char *out, size_t *out_len)
+{
+	int ret;
+
+	/* NEON cannot be used from interrupt context, like the xor code */
+	if (!cpu_has_neon() || in_interrupt())
+		return lzo1x_decompress_safe_generic(in, in_len, out, out_len);
+
+	kernel_neon_begin();
+	ret = lzo1x_decompress_safe_neon_inner(in, in_len, out, out_len);
+	kernel_neon_end();
+
+	return ret;
+}
+#endif
+
+#if !defined(STATIC) && !defined(LZO_NEON)
 EXPORT_SYMBOL_GPL(lzo1x_decompress_safe);
 
 MODULE_LICENSE("GPL");
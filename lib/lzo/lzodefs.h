@@ -28,6 +28,14 @@
 		COPY4(dst, src); COPY4((dst) + 4, (src) + 4)
 #endif
 
+#if defined(LZO_NEON)
+/* only used by lzo1x_decompress_neon.c, inside kernel_neon_begin/end */
+#define COPY16(dst, src)						\
+		asm volatile("vld1.8 {d0-d1}, [%1]\n\t"			\
+			     "vst1.8 {d0-d1}, [%0]"			\
+			     : : "r" (dst), "r" (src) : "d0", "d1", "memory")
+#endif
+
 #if defined(__BIG_ENDIAN) && defined(__LITTLE_ENDIAN)
 #error "conflicting endian definitions"
 #elif defined(__x86_64__)
@@ -0,0 +1,230 @@
+/*
+ * Self-test and throughput benchmark for the ARM NEON copy routines
+ *
+ * copy_page() and __copy_{from,to}_user() are checked against the standard
+ * ldm/stm routines at a few misalignments and across an unmapped page, then
+ * every size class from 64 bytes to 1MB is timed for memcpy(), the standard
+ * routines and the dispatching ones. Results are reported in MB/s.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/mm.h>
+#include <linux/mman.h>
+#include <linux/vmalloc.h>
+#include <linux/random.h>
+#include <linux/ktime.h>
+#include <linux/uaccess.h>
+
+#define BENCH_MAX_SIZE	(1024 * 1024)
+#define BENCH_BYTES	(64 * 1024 * 1024)
+
+static unsigned int bench_bytes = BENCH_BYTES;
+module_param(bench_bytes, uint, 0444);
+MODULE_PARM_DESC(bench_bytes, "bytes copied per size class and routine");
+
+enum {
+	COPY_MEMCPY,
+	COPY_FROM_USER_STD,
+	COPY_FROM_USER,
+	COPY_TO_USER_STD,
+	COPY_TO_USER,
+	NR_COPY_ROUTINES,
+};
+
+static const char * const routine_names[NR_COPY_ROUTINES] = {
+	[COPY_MEMCPY]		= "memcpy",
+	[COPY_FROM_USER_STD]	= "from_user std",
+	[COPY_FROM_USER]	= "from_user",
+	[COPY_TO_USER_STD]	= "to_user std",
+	[COPY_TO_USER]		= "to_user",
+};
+
+static unsigned long do_copy(int routine, void *dst, const void *src,
+			     void __user *ubuf, unsigned long n)
+{
+	switch (routine) {
+	case COPY_MEMCPY:
+		memcpy(dst, src, n);
+		return 0;
+	case COPY_FROM_USER_STD:
+		return __copy_from_user_std(dst, ubuf, n);
+	case COPY_FROM_USER:
+		return __copy_from_user(dst, ubuf, n);
+	case COPY_TO_USER_STD:
+		return __copy_to_user_std(ubuf, src, n);
+	default:
+		return __copy_to_user(ubuf, src, n);
+	}
+}
+
+static unsigned long rate(u64 bytes, ktime_t start)
+{
+	u64 ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	if (!ns)
+		ns = 1;
+	return div64_u64(bytes * NSEC_PER_SEC, ns) >> 20;
+}
+
+static int check_user_copies(u8 *src, u8 *dst, void __user *ubuf)
+{
+	static const unsigned long sizes[] = { 63, 64, 1000, 1024, 4095,
+					       4096, 16384 + 17 };
+	unsigned int i, off;
+	unsigned long left;
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		for (off = 0; off < 8; off += 3) {
+			memset(dst, 0, sizes[i] + off);
+			left = __copy_to_user(ubuf + off, src, sizes[i]);
+			left |= __copy_from_user(dst + off, ubuf + off,
+						 sizes[i]);
+			if (left || memcmp(src, dst + off, sizes[i])) {
+				pr_err("copy neon: user copy of %lu bytes at +%u failed\n",
+				       sizes[i], off);
+				return -EINVAL;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * The page after the user buffer is unmapped, copies running into it must
+ * report at least the unmapped part as not copied, and __copy_from_user()
+ * must zero whatever it could not read.
+ */
+static int check_user_fault(u8 *src, u8 *dst, void __user *ubuf,
+			    unsigned long mapped)
+{
+	unsigned long n = 3 * PAGE_SIZE, start = mapped - PAGE_SIZE - 100;
+	unsigned long left;
+
+	left = __copy_to_user(ubuf + start, src, n);
+	if (left < n - (mapped - start) || left == n) {
+		pr_err("copy neon: to_user across a hole left %lu\n", left);
+		return -EINVAL;
+	}
+
+	memset(dst, 0xa5, n);
+	left = __copy_from_user(dst, ubuf + start, n);
+	if (left < n - (mapped - start) || left == n ||
+	    memcmp(dst, src, n - left) || memchr_inv(dst + n - left, 0, left)) {
+		pr_err("copy neon: from_user across a hole left %lu\n", left);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int check_copy_page(u8 *src, u8 *dst)
+{
+	memset(dst, 0, PAGE_SIZE);
+	copy_page(dst, src);
+	if (memcmp(src, dst, PAGE_SIZE)) {
+		pr_err("copy neon: copy_page mismatch\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void bench_copy_page(u8 *src, u8 *dst)
+{
+	unsigned long i, pages = bench_bytes / PAGE_SIZE;
+	ktime_t start;
+	unsigned long std, cur;
+
+	start = ktime_get();
+	for (i = 0; i < pages; i++)
+		copy_page_std(dst, src);
+	std = rate((u64)pages * PAGE_SIZE, start);
+
+	start = ktime_get();
+	for (i = 0; i < pages; i++)
+		copy_page(dst, src);
+	cur = rate((u64)pages * PAGE_SIZE, start);
+
+	pr_info("copy neon: copy_page std %5lu MB/s, copy_page %5lu MB/s\n",
+		std, cur);
+}
+
+static void bench_user_copies(u8 *src, u8 *dst, void __user *ubuf)
+{
+	unsigned long size, i, iters;
+	unsigned long mbs[NR_COPY_ROUTINES];
+	ktime_t start;
+	int r;
+
+	for (size = 64; size <= BENCH_MAX_SIZE; size <<= 1) {
+		iters = max(bench_bytes / size, 1UL);
+		for (r = 0; r < NR_COPY_ROUTINES; r++) {
+			start = ktime_get();
+			for (i = 0; i < iters; i++)
+				do_copy(r, dst, src, ubuf, size);
+			mbs[r] = rate((u64)iters * size, start);
+		}
+		pr_info("copy neon: %7lu: %s %5lu, %s %5lu/%5lu, %s %5lu/%5lu MB/s\n",
+			size, routine_names[COPY_MEMCPY], mbs[COPY_MEMCPY],
+			routine_names[COPY_FROM_USER], mbs[COPY_FROM_USER_STD],
+			mbs[COPY_FROM_USER], routine_names[COPY_TO_USER],
+			mbs[COPY_TO_USER_STD], mbs[COPY_TO_USER]);
+	}
+}
+
+static int __init test_copy_neon_init(void)
+{
+	unsigned long len = BENCH_MAX_SIZE + PAGE_SIZE;
+	unsigned long uaddr;
+	u8 *src, *dst;
+	int ret = -ENOMEM;
+
+	src = vmalloc(BENCH_MAX_SIZE);
+	dst = vmalloc(BENCH_MAX_SIZE);
+	if (!src || !dst)
+		goto out;
+	get_random_bytes(src, BENCH_MAX_SIZE);
+
+	uaddr = vm_mmap(NULL, 0, len, PROT_READ | PROT_WRITE,
+			MAP_ANONYMOUS | MAP_PRIVATE, 0);
+	if (IS_ERR_VALUE(uaddr)) {
+		ret = uaddr;
+		goto out;
+	}
+	/* fault the user buffer in so the benchmark measures copying only */
+	if (__copy_to_user((void __user *)uaddr, src, BENCH_MAX_SIZE)) {
+		ret = -EFAULT;
+		goto unmap;
+	}
+	vm_munmap(uaddr + BENCH_MAX_SIZE, PAGE_SIZE);
+	len = BENCH_MAX_SIZE;
+
+	ret = check_copy_page(src, dst);
+	if (!ret)
+		ret = check_user_copies(src, dst, (void __user *)uaddr);
+	if (!ret)
+		ret = check_user_fault(src, dst, (void __user *)uaddr, len);
+	if (ret)
+		goto unmap;
+
+	bench_copy_page(src, dst);
+	bench_user_copies(src, dst, (void __user *)uaddr);
+	pr_info("copy neon: all tests passed\n");
+unmap:
+	vm_munmap(uaddr, len);
+out:
+	vfree(dst);
+	vfree(src);
+	/* nothing to keep resident, the results are in the log */
+	return ret ? ret : -EAGAIN;
+}
+module_init(test_copy_neon_init);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("ARM NEON copy_page/copy_*_user self-test and benchmark");
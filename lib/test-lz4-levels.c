@@ -0,0 +1,217 @@
+/*
+ * Ratio and throughput of the LZ4 acceleration factors and LZ4HC levels
+ *
+ * Samples up to 'pages' anonymous pages currently in use in the system,
+ * skipping zero filled ones as zram does, and runs every setting over that
+ * corpus page by page, the way zram compresses. LZO is included as the
+ * reference point. Results go to the kernel log.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/mm.h>
+#include <linux/mmzone.h>
+#include <linux/highmem.h>
+#include <linux/vmalloc.h>
+#include <linux/slab.h>
+#include <linux/ktime.h>
+#include <linux/lz4.h>
+#include <linux/lzo.h>
+
+static unsigned int pages = 1024;
+module_param(pages, uint, 0444);
+MODULE_PARM_DESC(pages, "maximum number of anonymous pages to sample");
+
+enum { ALGO_LZO, ALGO_LZ4, ALGO_LZ4HC };
+
+static const struct {
+	int algo;
+	int level;
+} settings[] = {
+	{ ALGO_LZO,	0 },
+	{ ALGO_LZ4,	1 },
+	{ ALGO_LZ4,	2 },
+	{ ALGO_LZ4,	4 },
+	{ ALGO_LZ4,	8 },
+	{ ALGO_LZ4,	16 },
+	{ ALGO_LZ4,	32 },
+	{ ALGO_LZ4HC,	1 },
+	{ ALGO_LZ4HC,	2 },
+	{ ALGO_LZ4HC,	LZ4HC_MID_LEVEL },
+	{ ALGO_LZ4HC,	6 },
+	{ ALGO_LZ4HC,	LZ4HC_MAX_LEVEL },
+};
+
+static const char * const algo_names[] = {
+	[ALGO_LZO]	= "lzo",
+	[ALGO_LZ4]	= "lz4",
+	[ALGO_LZ4HC]	= "lz4hc",
+};
+
+static bool page_zero_filled(const unsigned long *p)
+{
+	unsigned int i;
+
+	for (i = 0; i < PAGE_SIZE / sizeof(*p); i++)
+		if (p[i])
+			return false;
+	return true;
+}
+
+/* Copy out up to max in-use anonymous pages, returns how many were found */
+static unsigned int collect_anon_pages(unsigned char *corpus,
+				       unsigned int max)
+{
+	unsigned int n = 0;
+	int nid;
+
+	for_each_online_node(nid) {
+		unsigned long pfn = node_start_pfn(nid);
+		unsigned long end = pfn + node_spanned_pages(nid);
+
+		for (; pfn < end && n < max; pfn++) {
+			struct page *page;
+			void *src;
+
+			if (!pfn_valid(pfn))
+				continue;
+			page = pfn_to_page(pfn);
+			if (!PageAnon(page) || !get_page_unless_zero(page))
+				continue;
+			/* recheck now that it cannot be freed under us */
+			if (PageAnon(page)) {
+				src = kmap_atomic(page);
+				memcpy(corpus + n * PAGE_SIZE, src, PAGE_SIZE);
+				kunmap_atomic(src);
+				if (!page_zero_filled((unsigned long *)
+						(corpus + n * PAGE_SIZE)))
+					n++;
+			}
+			put_page(page);
+			cond_resched();
+		}
+	}
+
+	return n;
+}
+
+static int compress_page(int algo, int level, const unsigned char *src,
+			 unsigned char *dst, size_t *dst_len, void *wrkmem)
+{
+	switch (algo) {
+	case ALGO_LZ4:
+		return lz4_compress_fast(src, PAGE_SIZE, dst, dst_len, wrkmem,
+					 level);
+	case ALGO_LZ4HC:
+		return lz4hc_compress_level(src, PAGE_SIZE, dst, dst_len,
+					    wrkmem, level);
+	default:
+		return lzo1x_1_compress(src, PAGE_SIZE, dst, dst_len, wrkmem);
+	}
+}
+
+static int decompress_page(int algo, const unsigned char *src,
+			   size_t src_len, unsigned char *dst)
+{
+	size_t dst_len = PAGE_SIZE;
+
+	if (algo == ALGO_LZO)
+		return lzo1x_decompress_safe(src, src_len, dst, &dst_len);
+	return lz4_decompress(src, &src_len, dst, PAGE_SIZE);
+}
+
+static unsigned long mb_per_sec(u64 bytes, u64 ns)
+{
+	return div64_u64(bytes * NSEC_PER_SEC, ns ?: 1) >> 20;
+}
+
+static int run_setting(int s, const unsigned char *corpus, unsigned int n,
+		       unsigned char *comp, size_t *comp_len,
+		       unsigned char *out, void *wrkmem)
+{
+	int algo = settings[s].algo, level = settings[s].level;
+	u64 comp_ns, decomp_ns, total = 0;
+	ktime_t start;
+	unsigned int i;
+	size_t stride = lz4_compressbound(PAGE_SIZE);
+
+	start = ktime_get();
+	for (i = 0; i < n; i++) {
+		if (compress_page(algo, level, corpus + i * PAGE_SIZE,
+				  comp + i * stride, &comp_len[i], wrkmem))
+			return -EINVAL;
+		total += min_t(size_t, comp_len[i], PAGE_SIZE);
+	}
+	comp_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	start = ktime_get();
+	for (i = 0; i < n; i++)
+		if (decompress_page(algo, comp + i * stride, comp_len[i], out))
+			return -EINVAL;
+	decomp_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	/* spot check the last page, the loop above only checks errors */
+	if (memcmp(out, corpus + (n - 1) * PAGE_SIZE, PAGE_SIZE))
+		return -EINVAL;
+
+	pr_info("%-5s %5d: ratio %3llu%%, compress %5lu MB/s, decompress %5lu MB/s\n",
+		algo_names[algo], level,
+		div64_u64(total * 100, (u64)n * PAGE_SIZE),
+		mb_per_sec((u64)n * PAGE_SIZE, comp_ns),
+		mb_per_sec((u64)n * PAGE_SIZE, decomp_ns));
+
+	return 0;
+}
+
+static int __init test_lz4_levels_init(void)
+{
+	unsigned char *corpus, *comp, *out;
+	size_t *comp_len;
+	void *wrkmem;
+	unsigned int n;
+	int s, ret = -ENOMEM;
+
+	if (!pages)
+		return -EINVAL;
+
+	/* lzo1x_worst_compress(PAGE_SIZE) is below lz4_compressbound() */
+	corpus = vmalloc(pages * PAGE_SIZE);
+	comp = vmalloc(pages * lz4_compressbound(PAGE_SIZE));
+	comp_len = vmalloc(pages * sizeof(*comp_len));
+	out = kmalloc(PAGE_SIZE, GFP_KERNEL);
+	wrkmem = vmalloc(LZ4HC_MEM_COMPRESS);
+	if (!corpus || !comp || !comp_len || !out || !wrkmem)
+		goto out;
+
+	n = collect_anon_pages(corpus, pages);
+	pr_info("lz4 levels: %u anonymous pages sampled\n", n);
+	if (!n) {
+		ret = -ENODATA;
+		goto out;
+	}
+
+	for (s = 0; s < ARRAY_SIZE(settings); s++) {
+		ret = run_setting(s, corpus, n, comp, comp_len, out, wrkmem);
+		if (ret) {
+			pr_err("lz4 levels: %s level %d failed\n",
+			       algo_names[settings[s].algo], settings[s].level);
+			goto out;
+		}
+	}
+out:
+	vfree(wrkmem);
+	kfree(out);
+	vfree(comp_len);
+	vfree(comp);
+	vfree(corpus);
+	/* nothing to keep resident, the results are in the log */
+	return ret ? ret : -EAGAIN;
+}
+module_init(test_lz4_levels_init);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("LZ4 acceleration and LZ4HC level benchmark on anonymous memory");
@@ -14,9 +14,16 @@
  * Author: Mike Chan (mike@android.com)
  */
 
+#include <linux/hash.h>
 #include <linux/proc_fs.h>
+#include <linux/rculist.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
 #include <linux/suspend.h>
+#include <linux/u64_stats_sync.h>
+#include <net/activity_stats.h>
 #include <net/net_namespace.h>
+#include <net/sock.h>
 
 /*
  * Track transmission rates in buckets (power of 2).
@@ -84,6 +91,173 @@ static int activity_stats_read_proc(char *page, char **start, off_t off,
 	return p - page;
 }
 
+/*
+ * Per-uid traffic, charged from the socket layer as packets reach a
+ * socket (sock_queue_rcv_skb(), tcp_v4_rcv()) and as they leave it
+ * (dev_queue_xmit()). Bytes are counted from the network header on.
+ *
+ * Every cpu keeps its own hash of the uids it has charged, so the hot
+ * path takes no lock and writes no shared cache line. Entries are only
+ * ever added, by their own cpu, and are published with RCU; reading
+ * /proc/net/stat/activity_uid sums them over all cpus.
+ */
+#define UID_HASH_BITS 6
+
+enum {
+	UID_RX,
+	UID_TX,
+	UID_DIRS,
+};
+
+struct uid_activity {
+	struct hlist_node node;
+	uid_t uid;
+	struct u64_stats_sync syncp;
+	u64 bytes[UID_DIRS];
+	u64 packets[UID_DIRS];
+};
+
+static DEFINE_PER_CPU(struct hlist_head [1 << UID_HASH_BITS],
+		      uid_activity_hash);
+
+static struct uid_activity *uid_activity_find(int cpu, uid_t uid)
+{
+	struct hlist_head *head;
+	struct hlist_node *pos;
+	struct uid_activity *ua;
+
+	head = &per_cpu(uid_activity_hash, cpu)[hash_32(uid, UID_HASH_BITS)];
+	hlist_for_each_entry_rcu(ua, pos, head, node)
+		if (ua->uid == uid)
+			return ua;
+	return NULL;
+}
+
+static void activity_stats_uid_charge(const struct sock *sk,
+				      const struct sk_buff *skb, int dir)
+{
+	struct uid_activity *ua;
+	uid_t uid = sk->sk_uid;
+	int cpu;
+
+	/* only IP sets the network header the bytes are counted from */
+	if (sk->sk_family != PF_INET && sk->sk_family != PF_INET6)
+		return;
+
+	/* sock_queue_rcv_skb() may run from process context too */
+	local_bh_disable();
+	cpu = smp_processor_id();
+	ua = uid_activity_find(cpu, uid);
+	if (unlikely(!ua)) {
+		ua = kzalloc(sizeof(*ua), GFP_ATOMIC);
+		if (!ua)
+			goto out;
+		ua->uid = uid;
+		hlist_add_head_rcu(&ua->node, &per_cpu(uid_activity_hash, cpu)
+				   [hash_32(uid, UID_HASH_BITS)]);
+	}
+
+	u64_stats_update_begin(&ua->syncp);
+	ua->bytes[dir] += skb->len - skb_network_offset(skb);
+	ua->packets[dir]++;
+	u64_stats_update_end(&ua->syncp);
+out:
+	local_bh_enable();
+}
+
+void activity_stats_uid_rx(const struct sock *sk, const struct sk_buff *skb)
+{
+	activity_stats_uid_charge(sk, skb, UID_RX);
+}
+
+void activity_stats_uid_tx(const struct sock *sk, const struct sk_buff *skb)
+{
+	activity_stats_uid_charge(sk, skb, UID_TX);
+}
+
+/* Adds up what the cpus from first on have charged to uid. */
+static void uid_activity_sum(int first, uid_t uid, u64 *bytes, u64 *packets)
+{
+	struct uid_activity *ua;
+	unsigned int start;
+	int cpu, dir;
+
+	memset(bytes, 0, UID_DIRS * sizeof(*bytes));
+	memset(packets, 0, UID_DIRS * sizeof(*packets));
+	for_each_possible_cpu(cpu) {
+		if (cpu < first)
+			continue;
+		ua = uid_activity_find(cpu, uid);
+		if (!ua)
+			continue;
+		for (dir = 0; dir < UID_DIRS; dir++) {
+			u64 b, p;
+
+			do {
+				start = u64_stats_fetch_begin_bh(&ua->syncp);
+				b = ua->bytes[dir];
+				p = ua->packets[dir];
+			} while (u64_stats_fetch_retry_bh(&ua->syncp, start));
+			bytes[dir] += b;
+			packets[dir] += p;
+		}
+	}
+}
+
+static bool uid_activity_seen_before(int cpu, uid_t uid)
+{
+	int other;
+
+	for_each_possible_cpu(other) {
+		if (other >= cpu)
+			break;
+		if (uid_activity_find(other, uid))
+			return true;
+	}
+	return false;
+}
+
+static int activity_uid_show(struct seq_file *m, void *v)
+{
+	u64 bytes[UID_DIRS], packets[UID_DIRS];
+	struct uid_activity *ua;
+	struct hlist_node *pos;
+	int cpu, i;
+
+	seq_puts(m, "uid rx_bytes rx_packets tx_bytes tx_packets\n");
+
+	rcu_read_lock();
+	for_each_possible_cpu(cpu) {
+		for (i = 0; i < 1 << UID_HASH_BITS; i++) {
+			hlist_for_each_entry_rcu(ua, pos,
+					&per_cpu(uid_activity_hash, cpu)[i], node) {
+				/* print each uid once, at its first cpu */
+				if (uid_activity_seen_before(cpu, ua->uid))
+					continue;
+				uid_activity_sum(cpu, ua->uid, bytes, packets);
+				seq_printf(m, "%u %llu %llu %llu %llu\n", ua->uid,
+					   bytes[UID_RX], packets[UID_RX],
+					   bytes[UID_TX], packets[UID_TX]);
+			}
+		}
+	}
+	rcu_read_unlock();
+	return 0;
+}
+
+static int activity_uid_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, activity_uid_show, NULL);
+}
+
+static const struct file_operations activity_uid_fops = {
+	.owner		= THIS_MODULE,
+	.open		= activity_uid_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static int activity_stats_notifier(struct notifier_block *nb,
 					unsigned long event, void *dummy)
 {
@@ -108,6 +282,8 @@ static int  __init activity_stats_init(void)
 {
 	create_proc_read_entry("activity", S_IRUGO,
 			init_net.proc_net_stat, activity_stats_read_proc, NULL);
+	proc_create("activity_uid", S_IRUGO, init_net.proc_net_stat,
+		    &activity_uid_fops);
 	return register_pm_notifier(&activity_stats_notifier_block);
 }
 
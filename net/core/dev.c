@@ -135,6 +135,7 @@
 #include <linux/net_tstamp.h>
 #include <linux/static_key.h>
 #include <net/flow_keys.h>
+#include <net/activity_stats.h>
 
 #include "net-sysfs.h"
 
@@ -1603,12 +1604,10 @@ static inline bool is_skb_forwardable(struct net_device *dev,
  */
 int dev_forward_skb(struct net_device *dev, struct sk_buff *skb)
 {
-	if (skb_shinfo(skb)->tx_flags & SKBTX_DEV_ZEROCOPY) {
-		if (skb_copy_ubufs(skb, GFP_ATOMIC)) {
-			atomic_long_inc(&dev->rx_dropped);
-			kfree_skb(skb);
-			return NET_RX_DROP;
-		}
+	if (skb_orphan_frags_rx(skb, GFP_ATOMIC)) {
+		atomic_long_inc(&dev->rx_dropped);
+		kfree_skb(skb);
+		return NET_RX_DROP;
 	}
 
 	skb_orphan(skb);
@@ -1637,6 +1636,9 @@ static inline int deliver_skb(struct sk_buff *skb,
 			      struct packet_type *pt_prev,
 			      struct net_device *orig_dev)
 {
+	/* a receiver may hold on to the skb: no user pages past here */
+	if (unlikely(skb_orphan_frags_rx(skb, GFP_ATOMIC)))
+		return -ENOMEM;
 	atomic_inc(&skb->users);
 	return pt_prev->func(skb, skb->dev, pt_prev, orig_dev);
 }
@@ -1682,6 +1684,12 @@ static void dev_queue_xmit_nit(struct sk_buff *skb, struct net_device *dev)
 			if (!skb2)
 				break;
 
+			/* taps may queue the clone: give it its own pages */
+			if (skb_orphan_frags_rx(skb2, GFP_ATOMIC)) {
+				kfree_skb(skb2);
+				break;
+			}
+
 			net_timestamp_set(skb2);
 
 			/* skb->nh should be correctly
@@ -2529,6 +2537,13 @@ int dev_queue_xmit(struct sk_buff *skb)
 	txq = dev_pick_tx(dev, skb);
 	q = rcu_dereference_bh(txq->qdisc);
 
+	/*
+	 * Stacked devices (vlan, bonding, macvlan, tunnels) have no queue and
+	 * hand the skb to dev_queue_xmit() again: charge the bottom device.
+	 */
+	if (skb->sk && (q->enqueue || (dev->flags & IFF_LOOPBACK)))
+		activity_stats_uid_tx(skb->sk, skb);
+
 #ifdef CONFIG_NET_CLS_ACT
 	skb->tc_verd = SET_TC_AT(skb->tc_verd, AT_EGRESS);
 #endif
@@ -2656,6 +2671,82 @@ EXPORT_SYMBOL(rps_sock_flow_table);
 
 struct static_key rps_needed __read_mostly;
 
+/*
+ * Automatic steering, for rx queues that have neither an rps_map nor a
+ * flow table configured. A new flow is hashed over the online cpus other
+ * than the one it arrives on, taking the first cpu from there that is
+ * already awake rather than waking an idle one. The flow then sticks to
+ * its cpu for as long as that cpu is busy or still holds packets of the
+ * flow in its backlog, so delivery stays in order when a flow moves and
+ * when cpus are hotplugged.
+ */
+int netdev_rps_auto __read_mostly;
+
+#define RPS_AUTO_FLOWS	256
+
+static struct rps_dev_flow rps_auto_flows[RPS_AUTO_FLOWS];
+
+static u16 rps_auto_pick(u32 hash, int this_cpu, struct softnet_data *mysd)
+{
+	int n = num_online_cpus() - 1;
+	u16 home = RPS_NO_CPU, awake = RPS_NO_CPU;
+	int cpu, k = 0, dist, awake_dist = INT_MAX, start;
+
+	if (n <= 0)
+		return RPS_NO_CPU;
+	start = ((u64) hash * n) >> 32;
+
+	for_each_online_cpu(cpu) {
+		if (cpu == this_cpu)
+			continue;
+		dist = (k++ - start + n) % n;
+		if (dist == 0 && home == RPS_NO_CPU)
+			home = cpu;
+		if (dist < awake_dist && !idle_cpu(cpu)) {
+			awake = cpu;
+			awake_dist = dist;
+		}
+	}
+
+	if (awake != RPS_NO_CPU)
+		return awake;
+	if (home != RPS_NO_CPU)
+		mysd->rps_auto_wakes++;
+	return home;
+}
+
+static int rps_auto_cpu(struct sk_buff *skb, struct rps_dev_flow **rflowp)
+{
+	struct softnet_data *mysd = &__get_cpu_var(softnet_data);
+	int this_cpu = smp_processor_id();
+	struct rps_dev_flow *rflow;
+	u16 tcpu;
+
+	skb_reset_network_header(skb);
+	if (!skb_get_rxhash(skb))
+		return -1;
+
+	rflow = &rps_auto_flows[skb->rxhash & (RPS_AUTO_FLOWS - 1)];
+	tcpu = ACCESS_ONCE(rflow->cpu);
+	if (tcpu != RPS_NO_CPU && cpu_online(tcpu)) {
+		if ((int)(per_cpu(softnet_data, tcpu).input_queue_head -
+			  rflow->last_qtail) < 0)
+			goto out;	/* packets of the flow still queued */
+		if (tcpu != this_cpu && !idle_cpu(tcpu))
+			goto out;
+	}
+
+	tcpu = rps_auto_pick(skb->rxhash, this_cpu, mysd);
+	if (tcpu == RPS_NO_CPU)
+		return -1;
+	rflow->cpu = tcpu;
+	rflow->last_qtail = per_cpu(softnet_data, tcpu).input_queue_head;
+	mysd->rps_auto_picks++;
+out:
+	*rflowp = rflow;
+	return tcpu;
+}
+
 static struct rps_dev_flow *
 set_rps_cpu(struct net_device *dev, struct sk_buff *skb,
 	    struct rps_dev_flow *rflow, u16 next_cpu)
@@ -2739,6 +2830,8 @@ static int get_rps_cpu(struct net_device *dev, struct sk_buff *skb,
 			goto done;
 		}
 	} else if (!rcu_access_pointer(rxqueue->rps_flow_table)) {
+		if (netdev_rps_auto)
+			cpu = rps_auto_cpu(skb, rflowp);
 		goto done;
 	}
 
@@ -2794,6 +2887,8 @@ static int get_rps_cpu(struct net_device *dev, struct sk_buff *skb,
 	}
 
 done:
+	if (cpu >= 0 && cpu != smp_processor_id())
+		__get_cpu_var(softnet_data).rps_steered++;
 	return cpu;
 }
 
@@ -2889,6 +2984,9 @@ static int enqueue_to_backlog(struct sk_buff *skb, int cpu,
 enqueue:
 			__skb_queue_tail(&sd->input_pkt_queue, skb);
 			input_queue_tail_incr_save(sd, qtail);
+			if (skb_queue_len(&sd->input_pkt_queue) > sd->backlog_max)
+				sd->backlog_max =
+					skb_queue_len(&sd->input_pkt_queue);
 			rps_unlock(sd);
 			local_irq_restore(flags);
 			return NET_RX_SUCCESS;
@@ -3277,8 +3375,11 @@ ncls:
 	}
 
 	if (pt_prev) {
+		if (unlikely(skb_orphan_frags_rx(skb, GFP_ATOMIC)))
+			goto drop;
 		ret = pt_prev->func(skb, skb->dev, pt_prev, orig_dev);
 	} else {
+drop:
 		atomic_long_inc(&skb->dev->rx_dropped);
 		kfree_skb(skb);
 		/* Jamal, now you will not able to escape explaining
@@ -4185,10 +4286,14 @@ static int softnet_seq_show(struct seq_file *seq, void *v)
 {
 	struct softnet_data *sd = v;
 
-	seq_printf(seq, "%08x %08x %08x %08x %08x %08x %08x %08x %08x %08x\n",
+	seq_printf(seq, "%08x %08x %08x %08x %08x %08x %08x %08x %08x %08x "
+		   "%08x %08x %08x %08x %08x\n",
 		   sd->processed, sd->dropped, sd->time_squeeze, 0,
 		   0, 0, 0, 0, /* was fastroute */
-		   sd->cpu_collision, sd->received_rps);
+		   sd->cpu_collision, sd->received_rps,
+		   skb_queue_len(&sd->input_pkt_queue) +
+		   skb_queue_len(&sd->process_queue), sd->backlog_max,
+		   sd->rps_steered, sd->rps_auto_picks, sd->rps_auto_wakes);
 	return 0;
 }
 
@@ -6565,6 +6670,11 @@ static int __init net_dev_init(void)
 		sd->backlog.gro_count = 0;
 	}
 
+#ifdef CONFIG_RPS
+	for (i = 0; i < RPS_AUTO_FLOWS; i++)
+		rps_auto_flows[i].cpu = RPS_NO_CPU;
+#endif
+
 	dev_boot_phase = 0;
 
 	/* The loopback device is special if any other network devices
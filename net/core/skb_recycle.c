@@ -0,0 +1,270 @@
+/*
+ * Per-cpu receive buffer recycling.
+ *
+ * Drivers that take their receive skbs from __netdev_alloc_skb_recycle()
+ * get them marked rx_recycle. When the stack frees such an skb and it is
+ * still a plain linear buffer owned by nobody else, __kfree_skb() hands it
+ * back here instead of to the slab allocator, and the next allocation of
+ * the same size class on that cpu reuses it, sk_buff and data alike.
+ *
+ * Buffers come in two size classes matching the kmalloc caches that
+ * __alloc_skb() would use anyway, so that a recycled head is no different
+ * from a freshly allocated one of the same class.
+ *
+ *	This program is free software; you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License
+ *	as published by the Free Software Foundation; either version
+ *	2 of the License, or (at your option) any later version.
+ */
+
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/cpu.h>
+#include <linux/percpu.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/skbuff.h>
+#include <linux/netdevice.h>
+#include <linux/spinlock.h>
+#include <net/net_namespace.h>
+
+#define SKB_RECYCLE_CLASSES	2
+
+/* kmalloc size of the data buffer of each class */
+static const unsigned int skb_recycle_kmalloc[SKB_RECYCLE_CLASSES] = {
+	2048, 4096,
+};
+
+struct skb_recycle_pool {
+	struct sk_buff_head	list[SKB_RECYCLE_CLASSES];
+	unsigned long		hits;		/* allocations served */
+	unsigned long		misses;		/* pool empty, allocated */
+	unsigned long		oversize;	/* too big for any class */
+	unsigned long		recycled;	/* freed into the pool */
+	unsigned long		full;		/* freed, pool was full */
+};
+
+static DEFINE_PER_CPU(struct skb_recycle_pool, skb_recycle_pools);
+
+/* per cpu and class */
+int sysctl_skb_recycle_max __read_mostly = 64;
+
+/* smallest class whose buffer holds size bytes, or -1 */
+static int skb_recycle_class(unsigned int size)
+{
+	int c;
+
+	for (c = 0; c < SKB_RECYCLE_CLASSES; c++)
+		if (size <= SKB_WITH_OVERHEAD(skb_recycle_kmalloc[c]))
+			return c;
+	return -1;
+}
+
+/* class the data buffer of skb belongs to, or -1 */
+static int skb_recycle_class_of(const struct sk_buff *skb)
+{
+	int c;
+
+	for (c = 0; c < SKB_RECYCLE_CLASSES; c++)
+		if (skb_end_offset(skb) ==
+		    SKB_WITH_OVERHEAD(skb_recycle_kmalloc[c]))
+			return c;
+	return -1;
+}
+
+/**
+ *	__netdev_alloc_skb_recycle - allocate an rx skbuff from the recycle pool
+ *	@dev: network device to receive on
+ *	@length: length to allocate
+ *	@gfp_mask: get_free_pages mask, used when the pool is empty
+ *
+ *	Same contract as __netdev_alloc_skb(). The buffer is taken from this
+ *	cpu's pool when one of the right size is there, and is returned to
+ *	the pool when the stack frees it.
+ */
+struct sk_buff *__netdev_alloc_skb_recycle(struct net_device *dev,
+		unsigned int length, gfp_t gfp_mask)
+{
+	struct skb_recycle_pool *pool;
+	struct sk_buff *skb;
+	unsigned long flags;
+	int c;
+
+	c = skb_recycle_class(SKB_DATA_ALIGN(length + NET_SKB_PAD));
+
+	local_irq_save(flags);
+	pool = &__get_cpu_var(skb_recycle_pools);
+	if (c < 0) {
+		pool->oversize++;
+		local_irq_restore(flags);
+		return __netdev_alloc_skb(dev, length, gfp_mask);
+	}
+	skb = __skb_dequeue(&pool->list[c]);
+	if (skb)
+		pool->hits++;
+	else
+		pool->misses++;
+	local_irq_restore(flags);
+
+	if (skb) {
+		/* skb_recycle() left NET_SKB_PAD of headroom */
+		skb->dev = dev;
+	} else {
+		skb = __alloc_skb(SKB_WITH_OVERHEAD(skb_recycle_kmalloc[c]),
+				  gfp_mask, 0, NUMA_NO_NODE);
+		if (unlikely(!skb))
+			return NULL;
+		skb_reserve(skb, NET_SKB_PAD);
+		skb->dev = dev;
+	}
+	skb->rx_recycle = 1;
+	return skb;
+}
+EXPORT_SYMBOL(__netdev_alloc_skb_recycle);
+
+/*
+ * Called from __kfree_skb() for an skb marked rx_recycle. Returns true if
+ * the skb went into the pool, false if the caller must free it.
+ */
+bool skb_recycle_put(struct sk_buff *skb)
+{
+	struct skb_recycle_pool *pool;
+	unsigned long flags;
+	bool full;
+	int c;
+
+	if (!skb_is_recycleable(skb, 0))
+		return false;
+	c = skb_recycle_class_of(skb);
+	if (c < 0)
+		return false;
+
+	local_irq_save(flags);
+	pool = &__get_cpu_var(skb_recycle_pools);
+	full = skb_queue_len(&pool->list[c]) >= sysctl_skb_recycle_max;
+	if (full)
+		pool->full++;
+	local_irq_restore(flags);
+	if (full)
+		return false;
+
+	/* runs the destructor and drops dst and conntrack references */
+	skb_recycle(skb);
+	skb->truesize = SKB_TRUESIZE(skb_end_offset(skb));
+
+	local_irq_save(flags);
+	pool = &__get_cpu_var(skb_recycle_pools);
+	__skb_queue_head(&pool->list[c], skb);
+	pool->recycled++;
+	local_irq_restore(flags);
+
+	return true;
+}
+
+static void skb_recycle_purge(struct sk_buff_head *list)
+{
+	struct sk_buff *skb;
+
+	/* skb_recycle() cleared rx_recycle, so this really frees */
+	while ((skb = __skb_dequeue(list)) != NULL)
+		kfree_skb(skb);
+}
+
+static DEFINE_SPINLOCK(skb_recycle_drain_lock);
+
+static void skb_recycle_drain_cpu(void *arg)
+{
+	struct skb_recycle_pool *pool = &__get_cpu_var(skb_recycle_pools);
+	struct sk_buff_head *drained = arg;
+	int c;
+
+	spin_lock(&skb_recycle_drain_lock);
+	for (c = 0; c < SKB_RECYCLE_CLASSES; c++)
+		skb_queue_splice_init(&pool->list[c], drained);
+	spin_unlock(&skb_recycle_drain_lock);
+}
+
+/* Empty the pools of all cpus, after net.core.skb_recycle_max changed. */
+void skb_recycle_drain(void)
+{
+	struct sk_buff_head drained;
+
+	__skb_queue_head_init(&drained);
+	on_each_cpu(skb_recycle_drain_cpu, &drained, 1);
+	skb_recycle_purge(&drained);
+}
+
+static int skb_recycle_cpu_callback(struct notifier_block *nfb,
+				    unsigned long action, void *hcpu)
+{
+	struct skb_recycle_pool *pool;
+	int c;
+
+	if (action != CPU_DEAD && action != CPU_DEAD_FROZEN)
+		return NOTIFY_OK;
+
+	pool = &per_cpu(skb_recycle_pools, (unsigned long)hcpu);
+	for (c = 0; c < SKB_RECYCLE_CLASSES; c++)
+		skb_recycle_purge(&pool->list[c]);
+
+	return NOTIFY_OK;
+}
+
+#ifdef CONFIG_PROC_FS
+static int skb_recycle_seq_show(struct seq_file *seq, void *v)
+{
+	int cpu, c;
+
+	seq_puts(seq, "cpu       hits     misses   oversize   recycled"
+		      "       full");
+	for (c = 0; c < SKB_RECYCLE_CLASSES; c++)
+		seq_printf(seq, "  pool_%uk", skb_recycle_kmalloc[c] / 1024);
+	seq_putc(seq, '\n');
+
+	for_each_online_cpu(cpu) {
+		struct skb_recycle_pool *pool = &per_cpu(skb_recycle_pools, cpu);
+
+		seq_printf(seq, "%-3d %10lu %10lu %10lu %10lu %10lu", cpu,
+			   pool->hits, pool->misses, pool->oversize,
+			   pool->recycled, pool->full);
+		for (c = 0; c < SKB_RECYCLE_CLASSES; c++)
+			seq_printf(seq, " %8u", skb_queue_len(&pool->list[c]));
+		seq_putc(seq, '\n');
+	}
+	return 0;
+}
+
+static int skb_recycle_seq_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, skb_recycle_seq_show, NULL);
+}
+
+static const struct file_operations skb_recycle_seq_fops = {
+	.owner	 = THIS_MODULE,
+	.open	 = skb_recycle_seq_open,
+	.read	 = seq_read,
+	.llseek	 = seq_lseek,
+	.release = single_release,
+};
+#endif
+
+static int __init skb_recycle_init(void)
+{
+	int cpu, c;
+
+	for_each_possible_cpu(cpu) {
+		struct skb_recycle_pool *pool = &per_cpu(skb_recycle_pools, cpu);
+
+		for (c = 0; c < SKB_RECYCLE_CLASSES; c++)
+			skb_queue_head_init(&pool->list[c]);
+	}
+	hotcpu_notifier(skb_recycle_cpu_callback, 0);
+
+#ifdef CONFIG_PROC_FS
+	if (!proc_net_fops_create(&init_net, "skb_recycle", S_IRUGO,
+				  &skb_recycle_seq_fops))
+		pr_warn("skb_recycle: cannot create /proc/net/skb_recycle\n");
+#endif
+	return 0;
+}
+subsys_initcall(skb_recycle_init);
@@ -399,7 +399,7 @@ static void skb_release_data(struct sk_buff *skb)
 
 			uarg = skb_shinfo(skb)->destructor_arg;
 			if (uarg->callback)
-				uarg->callback(uarg);
+				uarg->callback(uarg, true);
 		}
 
 		if (skb_has_frag_list(skb))
@@ -489,6 +489,10 @@ static void skb_release_all(struct sk_buff *skb)
 
 void __kfree_skb(struct sk_buff *skb)
 {
+#ifdef CONFIG_SKB_RECYCLE
+	if (skb->rx_recycle && skb_recycle_put(skb))
+		return;
+#endif
 	skb_release_all(skb);
 	kfree_skbmem(skb);
 }
@@ -556,6 +560,9 @@ void skb_recycle(struct sk_buff *skb)
 	memset(skb, 0, offsetof(struct sk_buff, tail));
 	skb->data = skb->head + NET_SKB_PAD;
 	skb_reset_tail_pointer(skb);
+#ifdef NET_SKBUFF_DATA_USES_OFFSET
+	skb->mac_header = ~0U;
+#endif
 }
 EXPORT_SYMBOL(skb_recycle);
 
@@ -594,6 +601,7 @@ static void __copy_skb_header(struct sk_buff *new, const struct sk_buff *old)
 	new->ooo_okay		= old->ooo_okay;
 	new->l4_rxhash		= old->l4_rxhash;
 	new->no_fcs		= old->no_fcs;
+	new->rx_recycle		= old->rx_recycle;
 #ifdef CONFIG_XFRM
 	new->sp			= secpath_get(old->sp);
 #endif
@@ -675,6 +683,263 @@ struct sk_buff *skb_morph(struct sk_buff *dst, struct sk_buff *src)
 }
 EXPORT_SYMBOL_GPL(skb_morph);
 
+/*
+ * MSG_ZEROCOPY completion state. It lives in the control block of the skb
+ * that ends up carrying the notification to the error queue, so that
+ * reporting a completion never has to allocate.
+ */
+struct sock_zerocopy {
+	struct ubuf_info	uarg;
+	atomic_t		refcnt;
+	bool			copied;		/* some skb copied the frags */
+	bool			aborted;	/* nothing sent, no notification */
+};
+
+static inline struct sock_zerocopy *sock_zerocopy(struct ubuf_info *uarg)
+{
+	return container_of(uarg, struct sock_zerocopy, uarg);
+}
+
+static inline void sock_zerocopy_get(struct ubuf_info *uarg)
+{
+	atomic_inc(&sock_zerocopy(uarg)->refcnt);
+}
+
+/**
+ *	sock_zerocopy_alloc - start a MSG_ZEROCOPY send
+ *	@sk: sending socket
+ *
+ *	Allocates the completion shared by all skbs of one send call and
+ *	gives it the socket's next notification id. The caller holds one
+ *	reference, which it drops with sock_zerocopy_put() once the call is
+ *	done, or with sock_zerocopy_put_abort() if no data went out with it.
+ *	Returns %NULL when the socket ran out of option memory, i.e. too
+ *	many notifications were left unread.
+ */
+struct ubuf_info *sock_zerocopy_alloc(struct sock *sk)
+{
+	struct sock_zerocopy *zc;
+	struct sk_buff *skb;
+
+	BUILD_BUG_ON(sizeof(*zc) > sizeof(skb->cb));
+	BUILD_BUG_ON(sizeof(struct sock_exterr_skb) > sizeof(skb->cb));
+
+	skb = sock_omalloc(sk, 0, sk->sk_allocation);
+	if (!skb)
+		return NULL;
+
+	zc = (struct sock_zerocopy *)skb->cb;
+	zc->uarg.callback = sock_zerocopy_put;
+	zc->uarg.ctx = sk;
+	zc->uarg.desc = (u32)(atomic_inc_return(&sk->sk_zckey) - 1);
+	atomic_set(&zc->refcnt, 1);
+	zc->copied = false;
+	zc->aborted = false;
+	sock_hold(sk);
+
+	return &zc->uarg;
+}
+EXPORT_SYMBOL_GPL(sock_zerocopy_alloc);
+
+/* Last reference gone: tell the sender its buffer may be reused. */
+static void sock_zerocopy_notify(struct sock_zerocopy *zc)
+{
+	struct sk_buff *skb = container_of((void *)zc, struct sk_buff, cb);
+	struct sock *sk = zc->uarg.ctx;
+	struct sk_buff_head *q = &sk->sk_error_queue;
+	struct sock_exterr_skb *serr;
+	struct sk_buff *tail;
+	u32 id = zc->uarg.desc;
+	u8 code = zc->copied ? SO_EE_CODE_ZEROCOPY_COPIED : 0;
+	unsigned long flags;
+
+	if (zc->aborted || sock_flag(sk, SOCK_DEAD)) {
+		consume_skb(skb);
+		goto out;
+	}
+
+	serr = SKB_EXT_ERR(skb);
+	memset(serr, 0, sizeof(*serr));
+	serr->ee.ee_errno = 0;
+	serr->ee.ee_origin = SO_EE_ORIGIN_ZEROCOPY;
+	serr->ee.ee_code = code;
+	serr->ee.ee_info = id;
+	serr->ee.ee_data = id;
+
+	/* Extend the pending notification if it ends with the previous id,
+	 * so that a sender polling the error queue late gets one range.
+	 */
+	spin_lock_irqsave(&q->lock, flags);
+	tail = skb_peek_tail(q);
+	if (tail && SKB_EXT_ERR(tail)->ee.ee_origin == SO_EE_ORIGIN_ZEROCOPY &&
+	    SKB_EXT_ERR(tail)->ee.ee_code == code &&
+	    SKB_EXT_ERR(tail)->ee.ee_data + 1 == id) {
+		SKB_EXT_ERR(tail)->ee.ee_data = id;
+	} else {
+		__skb_queue_tail(q, skb);
+		skb = NULL;
+	}
+	spin_unlock_irqrestore(&q->lock, flags);
+
+	sk->sk_error_report(sk);
+	consume_skb(skb);
+out:
+	sock_put(sk);
+}
+
+/**
+ *	sock_zerocopy_put - drop a reference on a MSG_ZEROCOPY completion
+ *	@uarg: completion from sock_zerocopy_alloc()
+ *	@zerocopy: false if the data had to be copied after all
+ *
+ *	This is also the ubuf_info callback run when an skb sharing the
+ *	frags is freed. The last reference queues a notification for the
+ *	send on the socket error queue.
+ */
+void sock_zerocopy_put(struct ubuf_info *uarg, bool zerocopy)
+{
+	struct sock_zerocopy *zc = sock_zerocopy(uarg);
+
+	if (!zerocopy)
+		zc->copied = true;
+	if (atomic_dec_and_test(&zc->refcnt))
+		sock_zerocopy_notify(zc);
+}
+EXPORT_SYMBOL_GPL(sock_zerocopy_put);
+
+/**
+ *	sock_zerocopy_put_abort - drop an unused MSG_ZEROCOPY completion
+ *	@uarg: completion no skb took a reference on
+ *
+ *	For a send call that failed before any data was queued: there is
+ *	no notification and the id is given to the next call.
+ */
+void sock_zerocopy_put_abort(struct ubuf_info *uarg)
+{
+	struct sock *sk = uarg->ctx;
+
+	atomic_dec(&sk->sk_zckey);
+	sock_zerocopy(uarg)->aborted = true;
+	sock_zerocopy_put(uarg, true);
+}
+EXPORT_SYMBOL_GPL(sock_zerocopy_put_abort);
+
+/* n now shares MSG_ZEROCOPY frags of skb: make it report to the same send */
+static void skb_zerocopy_clone(struct sk_buff *n, const struct sk_buff *skb)
+{
+	struct ubuf_info *uarg = skb_shinfo(skb)->destructor_arg;
+
+	sock_zerocopy_get(uarg);
+	skb_shinfo(n)->destructor_arg = uarg;
+	skb_shinfo(n)->tx_flags |= SKBTX_DEV_ZEROCOPY | SKBTX_SOCK_ZEROCOPY;
+}
+
+/**
+ *	skb_zerocopy_from_user - append user memory to an skb without copying
+ *	@skb: buffer to append to
+ *	@from: user address
+ *	@len: number of bytes
+ *	@uarg: MSG_ZEROCOPY completion of the send
+ *
+ *	Pins the pages behind @from and adds them to @skb as page frags,
+ *	attaching @uarg to @skb on first use. Stops early when @skb runs out
+ *	of frags. skb->len, data_len and truesize are updated; charging the
+ *	socket is up to the caller.
+ *
+ *	Returns the number of bytes added, -EEXIST if @skb already belongs
+ *	to another send, or -EFAULT.
+ */
+int skb_zerocopy_from_user(struct sk_buff *skb, const void __user *from,
+			   int len, struct ubuf_info *uarg)
+{
+	struct skb_shared_info *shinfo = skb_shinfo(skb);
+	struct page *pages[MAX_SKB_FRAGS];
+	unsigned long addr = (unsigned long)from;
+	int off = offset_in_page(addr);
+	int copied = 0;
+	int n, i;
+
+	if ((shinfo->tx_flags & SKBTX_DEV_ZEROCOPY) &&
+	    shinfo->destructor_arg != uarg)
+		return -EEXIST;
+
+	n = min_t(int, MAX_SKB_FRAGS - shinfo->nr_frags,
+		  DIV_ROUND_UP(off + len, PAGE_SIZE));
+	if (n <= 0 || len <= 0)
+		return 0;
+
+	n = get_user_pages_fast(addr & PAGE_MASK, n, 0, pages);
+	if (n <= 0)
+		return -EFAULT;
+
+	for (i = 0; i < n; i++) {
+		int size = min_t(int, len, PAGE_SIZE - off);
+		int f = shinfo->nr_frags;
+
+		if (skb_can_coalesce(skb, f, pages[i], off)) {
+			skb_frag_size_add(&shinfo->frags[f - 1], size);
+			put_page(pages[i]);
+		} else {
+			skb_fill_page_desc(skb, f, pages[i], off, size);
+		}
+		off = 0;
+		len -= size;
+		copied += size;
+	}
+
+	skb->len += copied;
+	skb->data_len += copied;
+	skb->truesize += copied;
+
+	if (!(shinfo->tx_flags & SKBTX_DEV_ZEROCOPY)) {
+		sock_zerocopy_get(uarg);
+		shinfo->destructor_arg = uarg;
+		shinfo->tx_flags |= SKBTX_DEV_ZEROCOPY | SKBTX_SOCK_ZEROCOPY;
+	}
+	return copied;
+}
+EXPORT_SYMBOL_GPL(skb_zerocopy_from_user);
+
+/**
+ *	skb_zerocopy_from_iovec - append user iovec data to an skb without copying
+ *	@skb: buffer to append to
+ *	@iov: user iovec
+ *	@offset: bytes of @iov to skip
+ *	@len: number of bytes
+ *	@uarg: MSG_ZEROCOPY completion of the send
+ *
+ *	skb_zerocopy_from_user() over an iovec. Returns the number of bytes
+ *	added, which is less than @len if @skb ran out of frags, or a
+ *	negative error if nothing could be added.
+ */
+int skb_zerocopy_from_iovec(struct sk_buff *skb, const struct iovec *iov,
+			    int offset, int len, struct ubuf_info *uarg)
+{
+	int copied = 0;
+
+	for (; len > 0; iov++) {
+		u8 __user *base = iov->iov_base;
+		int seglen = iov->iov_len;
+		int err;
+
+		if (offset >= seglen) {
+			offset -= seglen;
+			continue;
+		}
+		seglen = min_t(int, seglen - offset, len);
+		err = skb_zerocopy_from_user(skb, base + offset, seglen, uarg);
+		if (err < 0)
+			return copied ? copied : err;
+		copied += err;
+		len -= err;
+		if (err < seglen)
+			break;
+		offset = 0;
+	}
+	return copied;
+}
+EXPORT_SYMBOL_GPL(skb_zerocopy_from_iovec);
+
 /*	skb_copy_ubufs	-	copy userspace skb frags buffers to kernel
  *	@skb: the skb to modify
  *	@gfp_mask: allocation priority
@@ -692,9 +957,19 @@ EXPORT_SYMBOL_GPL(skb_morph);
 int skb_copy_ubufs(struct sk_buff *skb, gfp_t gfp_mask)
 {
 	int i;
-	int num_frags = skb_shinfo(skb)->nr_frags;
+	int num_frags;
 	struct page *page, *head = NULL;
-	struct ubuf_info *uarg = skb_shinfo(skb)->destructor_arg;
+	struct ubuf_info *uarg;
+
+	/* MSG_ZEROCOPY frags may be shared with clones: copy a private set */
+	if (skb_zerocopy_shared(skb)) {
+		if (skb_shared(skb))
+			return -EINVAL;
+		if (skb_cloned(skb) && pskb_expand_head(skb, 0, 0, gfp_mask))
+			return -ENOMEM;
+	}
+	num_frags = skb_shinfo(skb)->nr_frags;
+	uarg = skb_shinfo(skb)->destructor_arg;
 
 	for (i = 0; i < num_frags; i++) {
 		u8 *vaddr;
@@ -721,7 +996,7 @@ int skb_copy_ubufs(struct sk_buff *skb, gfp_t gfp_mask)
 	for (i = 0; i < skb_shinfo(skb)->nr_frags; i++)
 		skb_frag_unref(skb, i);
 
-	uarg->callback(uarg);
+	uarg->callback(uarg, false);
 
 	/* skb frags point to kernel buffers */
 	for (i = skb_shinfo(skb)->nr_frags; i > 0; i--) {
@@ -730,7 +1005,7 @@ int skb_copy_ubufs(struct sk_buff *skb, gfp_t gfp_mask)
 		head = (struct page *)head->private;
 	}
 
-	skb_shinfo(skb)->tx_flags &= ~SKBTX_DEV_ZEROCOPY;
+	skb_shinfo(skb)->tx_flags &= ~(SKBTX_DEV_ZEROCOPY | SKBTX_SOCK_ZEROCOPY);
 	return 0;
 }
 EXPORT_SYMBOL_GPL(skb_copy_ubufs);
@@ -753,10 +1028,8 @@ struct sk_buff *skb_clone(struct sk_buff *skb, gfp_t gfp_mask)
 {
 	struct sk_buff *n;
 
-	if (skb_shinfo(skb)->tx_flags & SKBTX_DEV_ZEROCOPY) {
-		if (skb_copy_ubufs(skb, gfp_mask))
-			return NULL;
-	}
+	if (skb_orphan_frags(skb, gfp_mask))
+		return NULL;
 
 	n = skb + 1;
 	if (skb->fclone == SKB_FCLONE_ORIG &&
@@ -876,18 +1149,18 @@ struct sk_buff *__pskb_copy(struct sk_buff *skb, int headroom, gfp_t gfp_mask)
 	if (skb_shinfo(skb)->nr_frags) {
 		int i;
 
-		if (skb_shinfo(skb)->tx_flags & SKBTX_DEV_ZEROCOPY) {
-			if (skb_copy_ubufs(skb, gfp_mask)) {
-				kfree_skb(n);
-				n = NULL;
-				goto out;
-			}
+		if (skb_orphan_frags(skb, gfp_mask)) {
+			kfree_skb(n);
+			n = NULL;
+			goto out;
 		}
 		for (i = 0; i < skb_shinfo(skb)->nr_frags; i++) {
 			skb_shinfo(n)->frags[i] = skb_shinfo(skb)->frags[i];
 			skb_frag_ref(skb, i);
 		}
 		skb_shinfo(n)->nr_frags = i;
+		if (skb_zerocopy_shared(skb))
+			skb_zerocopy_clone(n, skb);
 	}
 
 	if (skb_has_frag_list(skb)) {
@@ -973,10 +1246,11 @@ int pskb_expand_head(struct sk_buff *skb, int nhead, int ntail,
 		kfree(skb->head);
 	} else {
 		/* copy this zero copy skb frags */
-		if (skb_shinfo(skb)->tx_flags & SKBTX_DEV_ZEROCOPY) {
-			if (skb_copy_ubufs(skb, gfp_mask))
-				goto nofrags;
-		}
+		if (skb_orphan_frags(skb, gfp_mask))
+			goto nofrags;
+		/* the new shared info took the MSG_ZEROCOPY frags along */
+		if (skb_zerocopy_shared(skb))
+			sock_zerocopy_get(skb_shinfo(skb)->destructor_arg);
 		for (i = 0; i < skb_shinfo(skb)->nr_frags; i++)
 			skb_frag_ref(skb, i);
 
@@ -2265,6 +2539,9 @@ void skb_split(struct sk_buff *skb, struct sk_buff *skb1, const u32 len)
 		skb_split_inside_header(skb, skb1, len, pos);
 	else		/* Second chunk has no header, nothing to copy. */
 		skb_split_no_header(skb, skb1, len, pos);
+
+	if (skb_zerocopy_shared(skb) && skb_shinfo(skb1)->nr_frags)
+		skb_zerocopy_clone(skb1, skb);
 }
 EXPORT_SYMBOL(skb_split);
 
@@ -2303,6 +2580,11 @@ int skb_shift(struct sk_buff *tgt, struct sk_buff *skb, int shiftlen)
 	BUG_ON(shiftlen > skb->len);
 	BUG_ON(skb_headlen(skb));	/* Would corrupt stream */
 
+	/* frags must stay with the skb that reports their completion */
+	if ((skb_shinfo(tgt)->tx_flags | skb_shinfo(skb)->tx_flags) &
+	    SKBTX_DEV_ZEROCOPY)
+		return 0;
+
 	todo = shiftlen;
 	from = 0;
 	to = skb_shinfo(tgt)->nr_frags;
@@ -2776,6 +3058,9 @@ struct sk_buff *skb_segment(struct sk_buff *skb, netdev_features_t features)
 		skb_copy_from_linear_data_offset(skb, offset,
 						 skb_put(nskb, hsize), hsize);
 
+		if (skb_zerocopy_shared(skb))
+			skb_zerocopy_clone(nskb, skb);
+
 		while (pos < offset + len && i < nfrags) {
 			if (unlikely(skb_orphan_frags(skb, GFP_ATOMIC)))
 				goto err;
@@ -129,6 +129,7 @@
 #include <linux/ipsec.h>
 #include <net/cls_cgroup.h>
 #include <net/netprio_cgroup.h>
+#include <net/activity_stats.h>
 
 #include <linux/filter.h>
 
@@ -355,6 +356,7 @@ int sock_queue_rcv_skb(struct sock *sk, struct sk_buff *skb)
 		return -ENOBUFS;
 	}
 
+	activity_stats_uid_rx(sk, skb);
 	skb->dev = NULL;
 	skb_set_owner_r(skb, sk);
 
@@ -805,6 +807,20 @@ set_rcvbuf:
 		sock_valbool_flag(sk, SOCK_NOFCS, valbool);
 		break;
 
+	case SO_ZEROCOPY:
+		if (sk->sk_family != PF_INET && sk->sk_family != PF_INET6)
+			ret = -EOPNOTSUPP;
+		else if (!(sk->sk_type == SOCK_STREAM &&
+			   sk->sk_protocol == IPPROTO_TCP) &&
+			 !(sk->sk_type == SOCK_DGRAM &&
+			   sk->sk_protocol == IPPROTO_UDP))
+			ret = -EOPNOTSUPP;
+		else if (val < 0 || val > 1)
+			ret = -EINVAL;
+		else
+			sock_valbool_flag(sk, SOCK_ZEROCOPY, valbool);
+		break;
+
 	default:
 		ret = -ENOPROTOOPT;
 		break;
@@ -1045,6 +1061,9 @@ int sock_getsockopt(struct socket *sock, int level, int optname,
 	case SO_NOFCS:
 		v.val = !!sock_flag(sk, SOCK_NOFCS);
 		break;
+	case SO_ZEROCOPY:
+		v.val = !!sock_flag(sk, SOCK_ZEROCOPY);
+		break;
 	default:
 		return -ENOPROTOOPT;
 	}
@@ -1322,6 +1341,7 @@ struct sock *sk_clone_lock(const struct sock *sk, const gfp_t priority)
 		 */
 		atomic_set(&newsk->sk_wmem_alloc, 1);
 		atomic_set(&newsk->sk_omem_alloc, 0);
+		atomic_set(&newsk->sk_zckey, 0);
 		skb_queue_head_init(&newsk->sk_receive_queue);
 		skb_queue_head_init(&newsk->sk_write_queue);
 #ifdef CONFIG_NET_DMA
@@ -1526,6 +1546,34 @@ struct sk_buff *sock_rmalloc(struct sock *sk, unsigned long size, int force,
 	return NULL;
 }
 
+static void sock_ofree(struct sk_buff *skb)
+{
+	atomic_sub(skb->truesize, &skb->sk->sk_omem_alloc);
+}
+
+/*
+ * Allocate a skb from the socket's option memory buffer.
+ */
+struct sk_buff *sock_omalloc(struct sock *sk, unsigned long size,
+			     gfp_t priority)
+{
+	struct sk_buff *skb;
+
+	if (atomic_read(&sk->sk_omem_alloc) + SKB_TRUESIZE(size) >
+	    sysctl_optmem_max)
+		return NULL;
+
+	skb = alloc_skb(size, priority);
+	if (!skb)
+		return NULL;
+
+	atomic_add(skb->truesize, &sk->sk_omem_alloc);
+	skb->sk = sk;
+	skb->destructor = sock_ofree;
+	return skb;
+}
+EXPORT_SYMBOL(sock_omalloc);
+
 /*
  * Allocate a memory block from the socket's option memory buffer.
  */
@@ -2093,9 +2141,12 @@ void sock_init_data(struct socket *sock, struct sock *sk)
 	if (sock) {
 		sk->sk_type	=	sock->type;
 		sk->sk_wq	=	sock->wq;
+		sk->sk_uid	=	SOCK_INODE(sock)->i_uid;
 		sock->sk	=	sk;
-	} else
+	} else {
 		sk->sk_wq	=	NULL;
+		sk->sk_uid	=	0;
+	}
 
 	spin_lock_init(&sk->sk_dst_lock);
 	rwlock_init(&sk->sk_callback_lock);
@@ -2122,6 +2173,8 @@ void sock_init_data(struct socket *sock, struct sock *sk)
 
 	sk->sk_stamp = ktime_set(-1L, 0);
 
+	sk->sk_pacing_rate = ~0U;
+
 	/*
 	 * Before updating sk_refcnt, we must commit prior changes to memory
 	 * (Documentation/RCU/rculist_nulls.txt for details)
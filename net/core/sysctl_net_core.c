@@ -19,11 +19,14 @@
 #include <net/ip.h>
 #include <net/sock.h>
 #include <net/net_ratelimit.h>
+#include <net/pkt_sched.h>
 
 static int zero = 0;
 static int ushort_max = USHRT_MAX;
 
 #ifdef CONFIG_RPS
+static int one = 1;
+
 static int rps_sock_flow_sysctl(ctl_table *table, int write,
 				void __user *buffer, size_t *lenp, loff_t *ppos)
 {
@@ -86,8 +89,63 @@ static int rps_sock_flow_sysctl(ctl_table *table, int write,
 
 	return ret;
 }
+
+static int rps_auto_sysctl(ctl_table *table, int write,
+			   void __user *buffer, size_t *lenp, loff_t *ppos)
+{
+	static DEFINE_MUTEX(rps_auto_mutex);
+	int old, ret;
+
+	mutex_lock(&rps_auto_mutex);
+	old = netdev_rps_auto;
+	ret = proc_dointvec_minmax(table, write, buffer, lenp, ppos);
+	if (write && !ret && old != netdev_rps_auto) {
+		if (netdev_rps_auto)
+			static_key_slow_inc(&rps_needed);
+		else
+			static_key_slow_dec(&rps_needed);
+	}
+	mutex_unlock(&rps_auto_mutex);
+
+	return ret;
+}
 #endif /* CONFIG_RPS */
 
+#ifdef CONFIG_SKB_RECYCLE
+static int skb_recycle_max_sysctl(ctl_table *table, int write,
+				  void __user *buffer, size_t *lenp,
+				  loff_t *ppos)
+{
+	int ret;
+
+	ret = proc_dointvec_minmax(table, write, buffer, lenp, ppos);
+	/* let a smaller limit, or 0 to disable, take effect at once */
+	if (write && !ret)
+		skb_recycle_drain();
+	return ret;
+}
+#endif
+
+#ifdef CONFIG_NET_SCHED
+static int set_default_qdisc(ctl_table *table, int write,
+			     void __user *buffer, size_t *lenp, loff_t *ppos)
+{
+	char id[IFNAMSIZ];
+	ctl_table tbl = {
+		.data = id,
+		.maxlen = IFNAMSIZ,
+	};
+	int ret;
+
+	qdisc_get_default(id, IFNAMSIZ);
+
+	ret = proc_dostring(&tbl, write, buffer, lenp, ppos);
+	if (write && ret == 0)
+		ret = qdisc_set_default(id);
+	return ret;
+}
+#endif
+
 static struct ctl_table net_core_table[] = {
 #ifdef CONFIG_NET
 	{
@@ -176,6 +234,34 @@ static struct ctl_table net_core_table[] = {
 		.mode		= 0644,
 		.proc_handler	= rps_sock_flow_sysctl
 	},
+	{
+		.procname	= "rps_auto",
+		.data		= &netdev_rps_auto,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= rps_auto_sysctl,
+		.extra1		= &zero,
+		.extra2		= &one
+	},
+#endif
+#ifdef CONFIG_SKB_RECYCLE
+	{
+		.procname	= "skb_recycle_max",
+		.data		= &sysctl_skb_recycle_max,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= skb_recycle_max_sysctl,
+		.extra1		= &zero,
+		.extra2		= &ushort_max
+	},
+#endif
+#ifdef CONFIG_NET_SCHED
+	{
+		.procname	= "default_qdisc",
+		.mode		= 0644,
+		.maxlen		= IFNAMSIZ,
+		.proc_handler	= set_default_qdisc
+	},
 #endif
 #endif /* CONFIG_NET */
 	{
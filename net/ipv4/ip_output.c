@@ -817,6 +817,8 @@ static int __ip_append_data(struct sock *sk,
 	unsigned int maxfraglen, fragheaderlen;
 	int csummode = CHECKSUM_NONE;
 	struct rtable *rt = (struct rtable *)cork->dst;
+	struct ubuf_info *uarg = NULL;
+	bool zc = false;
 
 	skb = skb_peek_tail(queue);
 
@@ -844,6 +846,19 @@ static int __ip_append_data(struct sock *sk,
 	    !exthdrlen)
 		csummode = CHECKSUM_PARTIAL;
 
+	if ((flags & MSG_ZEROCOPY) && length && sock_flag(sk, SOCK_ZEROCOPY)) {
+		uarg = sock_zerocopy_alloc(sk);
+		if (!uarg)
+			return -ENOBUFS;
+		/* Only a datagram that leaves in one piece, checksummed by
+		 * the device, can take its payload straight from user pages.
+		 * The rest is copied and reported as such.
+		 */
+		zc = csummode == CHECKSUM_PARTIAL &&
+		     (rt->dst.dev->features & NETIF_F_SG) &&
+		     getfrag == ip_generic_getfrag;
+	}
+
 	cork->length += length;
 	if (((length > mtu) || (skb && skb_has_frags(skb))) &&
 	    (sk->sk_protocol == IPPROTO_UDP) &&
@@ -853,7 +868,7 @@ static int __ip_append_data(struct sock *sk,
 					 maxfraglen, flags);
 		if (err)
 			goto error;
-		return 0;
+		goto out;
 	}
 
 	/* So, what's going on in the loop below?
@@ -877,6 +892,7 @@ static int __ip_append_data(struct sock *sk,
 			unsigned int fraglen;
 			unsigned int fraggap;
 			unsigned int alloclen;
+			unsigned int pagedlen;
 			struct sk_buff *skb_prev;
 alloc_new_skb:
 			skb_prev = skb;
@@ -893,12 +909,14 @@ alloc_new_skb:
 			if (datalen > mtu - fragheaderlen)
 				datalen = maxfraglen - fragheaderlen;
 			fraglen = datalen + fragheaderlen;
+			/* zero-copy payload goes to frags, not the head */
+			pagedlen = zc ? datalen - transhdrlen - fraggap : 0;
 
 			if ((flags & MSG_MORE) &&
 			    !(rt->dst.dev->features&NETIF_F_SG))
 				alloclen = mtu;
 			else
-				alloclen = fraglen;
+				alloclen = fraglen - pagedlen;
 
 			alloclen += exthdrlen;
 
@@ -942,12 +960,37 @@ alloc_new_skb:
 			/*
 			 *	Find where to start putting bytes.
 			 */
-			data = skb_put(skb, fraglen + exthdrlen);
+			data = skb_put(skb, fraglen + exthdrlen - pagedlen);
 			skb_set_network_header(skb, exthdrlen);
 			skb->transport_header = (skb->network_header +
 						 fragheaderlen);
 			data += fragheaderlen + exthdrlen;
 
+			/*
+			 * Pin the zero-copy pages first: if they don't fit the
+			 * skb it is retried as a copy, which must find skb_prev
+			 * and the cork as they were.
+			 */
+			if (pagedlen) {
+				err = skb_zerocopy_from_iovec(skb, from, offset,
+							      pagedlen, uarg);
+				if (err < 0) {
+					kfree_skb(skb);
+					goto error;
+				}
+				if (err < pagedlen) {
+					/* more pages than frags: copy it */
+					cork->tx_flags = skb_shinfo(skb)->tx_flags &
+						~(SKBTX_DEV_ZEROCOPY |
+						  SKBTX_SOCK_ZEROCOPY);
+					kfree_skb(skb);
+					skb = skb_prev;
+					zc = false;
+					goto alloc_new_skb;
+				}
+				atomic_add(pagedlen, &sk->sk_wmem_alloc);
+			}
+
 			if (fraggap) {
 				skb->csum = skb_copy_and_csum_bits(
 					skb_prev, maxfraglen,
@@ -958,12 +1001,13 @@ alloc_new_skb:
 				pskb_trim_unique(skb_prev, maxfraglen);
 			}
 
-			copy = datalen - transhdrlen - fraggap;
+			copy = datalen - transhdrlen - fraggap - pagedlen;
 			if (copy > 0 && getfrag(from, data + transhdrlen, offset, copy, fraggap, skb) < 0) {
 				err = -EFAULT;
 				kfree_skb(skb);
 				goto error;
 			}
+			copy += pagedlen;
 
 			offset += copy;
 			length -= datalen - fraggap;
@@ -1043,11 +1087,16 @@ alloc_new_skb:
 		length -= copy;
 	}
 
+out:
+	if (uarg)
+		sock_zerocopy_put(uarg, zc);
 	return 0;
 
 error:
 	cork->length -= length;
 	IP_INC_STATS(sock_net(sk), IPSTATS_MIB_OUTDISCARDS);
+	if (uarg)
+		sock_zerocopy_put_abort(uarg);
 	return err;
 }
 
@@ -0,0 +1,249 @@
+/*
+ * TCP Fast Open (draft-ietf-tcpm-fastopen)
+ *
+ * Server side: a cookie is a keyed hash of the client and server addresses.
+ * It is handed out in the SYN-ACK on request and validated on later SYNs,
+ * whose data are then accepted before the three way handshake completes.
+ *
+ * Client side: cookies and the peer MSS are cached per destination so that
+ * the next connect() with MSG_FASTOPEN can carry data in its SYN.
+ *
+ *	This program is free software; you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License
+ *	as published by the Free Software Foundation; either version
+ *	2 of the License, or (at your option) any later version.
+ */
+
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/cryptohash.h>
+#include <linux/jhash.h>
+#include <linux/percpu.h>
+#include <linux/random.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/tcp.h>
+#include <net/inet_sock.h>
+#include <net/tcp.h>
+
+int sysctl_tcp_fastopen __read_mostly = TFO_CLIENT_ENABLE;
+
+/* Server cookie secret, settable through net.ipv4.tcp_fastopen_key */
+static u32 tcp_fastopen_key[TCP_FASTOPEN_KEY_LENGTH / sizeof(u32)];
+static DEFINE_SPINLOCK(tcp_fastopen_key_lock);
+
+static DEFINE_PER_CPU(__u32 [16 + SHA_DIGEST_WORDS + SHA_WORKSPACE_WORDS],
+		      tcp_fastopen_scratch);
+
+void tcp_fastopen_get_key(u32 *key)
+{
+	spin_lock_bh(&tcp_fastopen_key_lock);
+	memcpy(key, tcp_fastopen_key, TCP_FASTOPEN_KEY_LENGTH);
+	spin_unlock_bh(&tcp_fastopen_key_lock);
+}
+
+void tcp_fastopen_set_key(const u32 *key)
+{
+	spin_lock_bh(&tcp_fastopen_key_lock);
+	memcpy(tcp_fastopen_key, key, TCP_FASTOPEN_KEY_LENGTH);
+	spin_unlock_bh(&tcp_fastopen_key_lock);
+}
+
+/* Computes the cookie for a client; runs in softirq context. */
+void tcp_fastopen_cookie_gen(__be32 saddr, __be32 daddr,
+			     struct tcp_fastopen_cookie *foc)
+{
+	__u32 *tmp = __get_cpu_var(tcp_fastopen_scratch);
+
+	memset(tmp, 0, 16 * sizeof(__u32));
+	tmp[0] = (__force u32)saddr;
+	tmp[1] = (__force u32)daddr;
+	spin_lock(&tcp_fastopen_key_lock);
+	memcpy(tmp + 4, tcp_fastopen_key, TCP_FASTOPEN_KEY_LENGTH);
+	spin_unlock(&tcp_fastopen_key_lock);
+
+	sha_init(tmp + 16);
+	sha_transform(tmp + 16, (__u8 *)tmp, tmp + 16 + SHA_DIGEST_WORDS);
+
+	memcpy(foc->val, tmp + 16, TCP_FASTOPEN_COOKIE_SIZE);
+	foc->len = TCP_FASTOPEN_COOKIE_SIZE;
+}
+
+/* Decide whether the SYN in skb may open a Fast Open child socket on the
+ * listener sk. Returns true if so, with the data in the SYN to be acked.
+ * Otherwise valid_foc is set to the cookie the SYN-ACK should carry, if any.
+ */
+bool tcp_fastopen_check(struct sock *sk, struct sk_buff *skb,
+			struct request_sock *req,
+			struct tcp_fastopen_cookie *foc,
+			struct tcp_fastopen_cookie *valid_foc)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	__be32 saddr = ip_hdr(skb)->saddr;
+	__be32 daddr = ip_hdr(skb)->daddr;
+	bool skip_cookie = false;
+
+	if (likely(!fastopen_cookie_present(foc))) {
+		if ((sysctl_tcp_fastopen & TFO_SERVER_COOKIE_NOT_REQD) &&
+		    TCP_SKB_CB(skb)->end_seq != TCP_SKB_CB(skb)->seq + 1)
+			skip_cookie = true;	/* no cookie to validate */
+		else
+			return false;
+	}
+
+	/* Make sure the listener has enabled Fast Open and has room left
+	 * before spending cycles on the cookie.
+	 */
+	if (!(sysctl_tcp_fastopen & TFO_SERVER_ENABLE) ||
+	    tp->fastopen_max_qlen <= 0)
+		return false;
+
+	if (atomic_read(&tp->fastopen_qlen) >= tp->fastopen_max_qlen) {
+		NET_INC_STATS_BH(sock_net(sk),
+				 LINUX_MIB_TCPFASTOPENLISTENOVERFLOW);
+		return false;
+	}
+
+	if (skip_cookie)
+		goto accept;
+
+	if (foc->len == TCP_FASTOPEN_COOKIE_SIZE) {
+		tcp_fastopen_cookie_gen(saddr, daddr, valid_foc);
+		if (memcmp(foc->val, valid_foc->val,
+			   TCP_FASTOPEN_COOKIE_SIZE) != 0) {
+			/* Stale or forged: answer with a fresh cookie. */
+			NET_INC_STATS_BH(sock_net(sk),
+					 LINUX_MIB_TCPFASTOPENPASSIVEFAIL);
+			return false;
+		}
+		valid_foc->len = -1;	/* no need to resend it */
+		goto accept;
+	}
+
+	/* A cookie request, or a cookie of a size we never hand out: treat
+	 * both as a request and return a valid cookie in the SYN-ACK.
+	 */
+	tcp_fastopen_cookie_gen(saddr, daddr, valid_foc);
+	if (foc->len == 0)
+		NET_INC_STATS_BH(sock_net(sk), LINUX_MIB_TCPFASTOPENCOOKIEREQD);
+	return false;
+
+accept:
+	/* Acknowledge the data received from the peer. */
+	tcp_rsk(req)->rcv_nxt = TCP_SKB_CB(skb)->end_seq;
+	return true;
+}
+
+/* The passive open of sk has either completed or is being torn down:
+ * release the request_sock kept for SYN-ACK retransmissions and the
+ * listener's Fast Open queue slot.
+ */
+void tcp_fastopen_req_done(struct sock *sk)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct request_sock *req = tp->fastopen_rsk;
+	struct sock *lsk;
+
+	if (req == NULL)
+		return;
+
+	tp->fastopen_rsk = NULL;
+	lsk = tcp_rsk(req)->listener;
+	atomic_dec(&tcp_sk(lsk)->fastopen_qlen);
+	sock_put(lsk);
+	reqsk_free(req);
+}
+
+void tcp_free_fastopen_req(struct tcp_sock *tp)
+{
+	if (tp->fastopen_req != NULL) {
+		kfree(tp->fastopen_req);
+		tp->fastopen_req = NULL;
+	}
+}
+
+/*
+ * Client side cookie cache: a direct mapped table indexed by destination.
+ * A colliding destination simply evicts the previous entry, which then
+ * falls back to a regular handshake with a cookie request.
+ */
+#define TCP_FASTOPEN_CACHE_BITS	8
+#define TCP_FASTOPEN_CACHE_SIZE	(1 << TCP_FASTOPEN_CACHE_BITS)
+
+struct tcp_fastopen_cache_entry {
+	struct net			*net;	/* key only, never dereferenced */
+	__be32				daddr;
+	u16				mss;
+	u16				syn_loss;
+	unsigned long			last_syn_loss;
+	struct tcp_fastopen_cookie	cookie;
+};
+
+static struct tcp_fastopen_cache_entry tcp_fastopen_cache[TCP_FASTOPEN_CACHE_SIZE];
+static DEFINE_SPINLOCK(tcp_fastopen_cache_lock);
+static u32 tcp_fastopen_cache_rnd __read_mostly;
+
+static struct tcp_fastopen_cache_entry *tcp_fastopen_cache_slot(struct net *net,
+								 __be32 daddr)
+{
+	u32 hash = jhash_2words((__force u32)daddr,
+				(u32)(unsigned long)net,
+				tcp_fastopen_cache_rnd);
+
+	return &tcp_fastopen_cache[hash & (TCP_FASTOPEN_CACHE_SIZE - 1)];
+}
+
+void tcp_fastopen_cache_get(struct sock *sk, u16 *mss,
+			    struct tcp_fastopen_cookie *cookie,
+			    int *syn_loss, unsigned long *last_syn_loss)
+{
+	struct net *net = sock_net(sk);
+	__be32 daddr = inet_sk(sk)->inet_daddr;
+	struct tcp_fastopen_cache_entry *e;
+
+	e = tcp_fastopen_cache_slot(net, daddr);
+	spin_lock_bh(&tcp_fastopen_cache_lock);
+	if (e->net == net && e->daddr == daddr) {
+		if (e->mss)
+			*mss = e->mss;
+		*cookie = e->cookie;
+		*syn_loss = e->syn_loss;
+		*last_syn_loss = *syn_loss ? e->last_syn_loss : 0;
+	}
+	spin_unlock_bh(&tcp_fastopen_cache_lock);
+}
+
+void tcp_fastopen_cache_set(struct sock *sk, u16 mss,
+			    struct tcp_fastopen_cookie *cookie, bool syn_lost)
+{
+	struct net *net = sock_net(sk);
+	__be32 daddr = inet_sk(sk)->inet_daddr;
+	struct tcp_fastopen_cache_entry *e;
+
+	e = tcp_fastopen_cache_slot(net, daddr);
+	spin_lock_bh(&tcp_fastopen_cache_lock);
+	if (e->net != net || e->daddr != daddr) {
+		memset(e, 0, sizeof(*e));
+		e->net = net;
+		e->daddr = daddr;
+	}
+	e->mss = mss;
+	if (cookie->len > 0)
+		e->cookie = *cookie;
+	if (syn_lost) {
+		++e->syn_loss;
+		e->last_syn_loss = jiffies;
+	} else {
+		e->syn_loss = 0;
+	}
+	spin_unlock_bh(&tcp_fastopen_cache_lock);
+}
+
+static int __init tcp_fastopen_init(void)
+{
+	get_random_bytes(tcp_fastopen_key, sizeof(tcp_fastopen_key));
+	get_random_bytes(&tcp_fastopen_cache_rnd,
+			 sizeof(tcp_fastopen_cache_rnd));
+	return 0;
+}
+late_initcall(tcp_fastopen_init);
@@ -75,6 +75,7 @@
 #include <net/netdma.h>
 #include <net/secure_seq.h>
 #include <net/tcp_memcontrol.h>
+#include <net/activity_stats.h>
 
 #include <linux/inet.h>
 #include <linux/ipv6.h>
@@ -812,7 +813,8 @@ static void tcp_v4_reqsk_send_ack(struct sock *sk, struct sk_buff *skb,
  */
 static int tcp_v4_send_synack(struct sock *sk, struct dst_entry *dst,
 			      struct request_sock *req,
-			      struct request_values *rvp)
+			      struct request_values *rvp,
+			      struct tcp_fastopen_cookie *foc)
 {
 	const struct inet_request_sock *ireq = inet_rsk(req);
 	struct flowi4 fl4;
@@ -823,7 +825,7 @@ static int tcp_v4_send_synack(struct sock *sk, struct dst_entry *dst,
 	if (!dst && (dst = inet_csk_route_req(sk, &fl4, req)) == NULL)
 		return -1;
 
-	skb = tcp_make_synack(sk, dst, req, rvp);
+	skb = tcp_make_synack(sk, dst, req, rvp, foc);
 
 	if (skb) {
 		__tcp_v4_send_check(skb, ireq->loc_addr, ireq->rmt_addr);
@@ -842,7 +844,7 @@ static int tcp_v4_rtx_synack(struct sock *sk, struct request_sock *req,
 			      struct request_values *rvp)
 {
 	TCP_INC_STATS_BH(sock_net(sk), TCP_MIB_RETRANSSEGS);
-	return tcp_v4_send_synack(sk, NULL, req, rvp);
+	return tcp_v4_send_synack(sk, NULL, req, rvp, NULL);
 }
 
 /*
@@ -1257,6 +1259,120 @@ static const struct tcp_request_sock_ops tcp_request_sock_ipv4_ops = {
 };
 #endif
 
+/* Create the child socket of a Fast Open request right away, queue the
+ * data carried by the SYN on it and make it acceptable, then send the
+ * SYN-ACK. The child keeps req to retransmit the SYN-ACK until the
+ * handshake completes. Always consumes dst. Returns non-zero if the
+ * child could not be created, in which case nothing has been sent and
+ * the caller falls back to a regular SYN-ACK.
+ */
+static int tcp_v4_conn_req_fastopen(struct sock *sk, struct sk_buff *skb,
+				    struct request_sock *req,
+				    struct request_values *rvp,
+				    struct tcp_fastopen_cookie *valid_foc,
+				    struct dst_entry *dst)
+{
+	const struct inet_request_sock *ireq = inet_rsk(req);
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct request_sock *carrier;
+	struct sk_buff *skb_synack;
+	struct sock *child;
+	struct tcp_sock *ctp;
+	struct flowi4 fl4;
+	int err;
+
+	if (!dst && (dst = inet_csk_route_req(sk, &fl4, req)) == NULL)
+		return -EHOSTUNREACH;
+
+	/* Build the SYN-ACK first: it sets up the receive window of req
+	 * that the child inherits.
+	 */
+	skb_synack = tcp_make_synack(sk, dst, req, rvp,
+				     fastopen_cookie_present(valid_foc) ?
+				     valid_foc : NULL);
+	if (skb_synack == NULL) {
+		dst_release(dst);
+		return -ENOMEM;
+	}
+	__tcp_v4_send_check(skb_synack, ireq->loc_addr, ireq->rmt_addr);
+
+	/* The accept queue frees the request_sock it carries once the
+	 * child is accepted, while the child needs req until the end of
+	 * the handshake: give the queue a request_sock of its own.
+	 */
+	carrier = reqsk_alloc(req->rsk_ops);
+	if (carrier == NULL) {
+		kfree_skb(skb_synack);
+		dst_release(dst);
+		return -ENOMEM;
+	}
+
+	/* The SYN-ACK has not been sent yet, do not take an RTT sample */
+	tcp_rsk(req)->snt_synack = 0;
+	child = inet_csk(sk)->icsk_af_ops->syn_recv_sock(sk, skb, req, dst);
+	if (child == NULL) {
+		__reqsk_free(carrier);
+		kfree_skb(skb_synack);
+		return -ENOMEM;
+	}
+	ctp = tcp_sk(child);
+
+	/* syn_recv_sock() moved the IP options of req to the child */
+	err = ip_build_and_send_pkt(skb_synack, sk, ireq->loc_addr,
+				    ireq->rmt_addr,
+				    rcu_dereference(inet_sk(child)->inet_opt));
+	if (!net_xmit_eval(err))
+		tcp_rsk(req)->snt_synack = tcp_time_stamp;
+	/* On error the SYN-ACK timer of the child will send it again */
+
+	NET_INC_STATS_BH(sock_net(sk), LINUX_MIB_TCPFASTOPENPASSIVE);
+
+	/* Hold the listener for req->rsk_ops and the qlen slot. */
+	sock_hold(sk);
+	tcp_rsk(req)->listener = sk;
+	atomic_inc(&tp->fastopen_qlen);
+	ctp->fastopen_rsk = req;
+
+	/* RFC1323: The window in SYN & SYN/ACK segments is never scaled. */
+	ctp->snd_wnd = ntohs(tcp_hdr(skb)->window);
+
+	/* Activate the retrans timer so that SYNACK can be retransmitted.
+	 * The request socket is not added to the SYN table of the parent
+	 * because it's been added to the accept queue directly.
+	 */
+	inet_csk_reset_xmit_timer(child, ICSK_TIME_RETRANS,
+				  TCP_TIMEOUT_INIT, TCP_RTO_MAX);
+
+	/* Add the child socket directly into the accept queue */
+	inet_csk_reqsk_queue_add(sk, carrier, child);
+
+	/* Now finish processing the fastopen child socket. */
+	inet_csk(child)->icsk_af_ops->rebuild_header(child);
+	tcp_init_congestion_control(child);
+	tcp_mtup_init(child);
+	tcp_init_buffer_space(child);
+	tcp_init_metrics(child);
+
+	/* Queue the data carried in the SYN packet, if any. We need to
+	 * first bump skb's refcnt because the caller will free it.
+	 */
+	if (TCP_SKB_CB(skb)->end_seq != TCP_SKB_CB(skb)->seq + 1) {
+		skb = skb_get(skb);
+		skb_dst_drop(skb);
+		__skb_pull(skb, tcp_hdr(skb)->doff * 4);
+		skb_set_owner_r(skb, child);
+		__skb_queue_tail(&child->sk_receive_queue, skb);
+		ctp->rcv_nxt = tcp_rsk(req)->rcv_nxt;
+		ctp->rcv_wup = ctp->rcv_nxt;
+		ctp->syn_data_acked = 1;
+	}
+
+	sk->sk_data_ready(sk, 0);
+	bh_unlock_sock(child);
+	sock_put(child);
+	return 0;
+}
+
 int tcp_v4_conn_request(struct sock *sk, struct sk_buff *skb)
 {
 	struct tcp_extend_values tmp_ext;
@@ -1270,6 +1386,8 @@ int tcp_v4_conn_request(struct sock *sk, struct sk_buff *skb)
 	__be32 daddr = ip_hdr(skb)->daddr;
 	__u32 isn = TCP_SKB_CB(skb)->when;
 	int want_cookie = 0;
+	struct tcp_fastopen_cookie foc = { .len = -1 };
+	struct tcp_fastopen_cookie valid_foc = { .len = -1 };
 
 	/* Never answer to SYNs send to broadcast or multicast */
 	if (skb_rtable(skb)->rt_flags & (RTCF_BROADCAST | RTCF_MULTICAST))
@@ -1304,7 +1422,8 @@ int tcp_v4_conn_request(struct sock *sk, struct sk_buff *skb)
 	tcp_clear_options(&tmp_opt);
 	tmp_opt.mss_clamp = TCP_MSS_DEFAULT;
 	tmp_opt.user_mss  = tp->rx_opt.user_mss;
-	tcp_parse_options(skb, &tmp_opt, &hash_location, 0);
+	tcp_parse_options(skb, &tmp_opt, &hash_location, 0,
+			  want_cookie ? NULL : &foc);
 
 	if (tmp_opt.cookie_plus > 0 &&
 	    tmp_opt.saw_tstamp &&
@@ -1411,8 +1530,25 @@ int tcp_v4_conn_request(struct sock *sk, struct sk_buff *skb)
 	tcp_rsk(req)->snt_isn = isn;
 	tcp_rsk(req)->snt_synack = tcp_time_stamp;
 
+	if (!want_cookie &&
+	    tcp_fastopen_check(sk, skb, req, &foc, &valid_foc)) {
+		if (!tcp_v4_conn_req_fastopen(sk, skb, req,
+					      (struct request_values *)&tmp_ext,
+					      &valid_foc, dst))
+			return 0;
+		/* The child could not be created: fall back to a regular
+		 * SYN-ACK that only acknowledges the SYN.
+		 */
+		NET_INC_STATS_BH(sock_net(sk), LINUX_MIB_TCPFASTOPENPASSIVEFAIL);
+		tcp_rsk(req)->rcv_nxt = tcp_rsk(req)->rcv_isn + 1;
+		tcp_rsk(req)->snt_synack = tcp_time_stamp;
+		dst = NULL;
+	}
+
 	if (tcp_v4_send_synack(sk, dst, req,
-			       (struct request_values *)&tmp_ext) ||
+			       (struct request_values *)&tmp_ext,
+			       fastopen_cookie_present(&valid_foc) ?
+			       &valid_foc : NULL) ||
 	    want_cookie)
 		goto drop_and_free;
 
@@ -1722,6 +1858,8 @@ process:
 	if (sk_filter(sk, skb))
 		goto discard_and_relse;
 
+	/* only a backlog overflow stops it reaching the socket now */
+	activity_stats_uid_rx(sk, skb);
 	skb->dev = NULL;
 
 	bh_lock_sock_nested(sk);
@@ -1897,6 +2035,7 @@ static int tcp_v4_init_sock(struct sock *sk)
 	tp->snd_ssthresh = TCP_INFINITE_SSTHRESH;
 	tp->snd_cwnd_clamp = ~0;
 	tp->mss_cache = TCP_MSS_DEFAULT;
+	minmax_reset(&tp->rtt_min, tcp_time_stamp, ~0U);
 
 	tp->reordering = sysctl_tcp_reordering;
 	icsk->icsk_ca_ops = &tcp_init_congestion_ops;
@@ -1986,6 +2125,11 @@ void tcp_v4_destroy_sock(struct sock *sk)
 		tp->cookie_values = NULL;
 	}
 
+	/* If socket is aborted during connect operation */
+	tcp_free_fastopen_req(tp);
+	/* A Fast Open child torn down before its handshake completed */
+	tcp_fastopen_req_done(sk);
+
 	sk_sockets_allocated_dec(sk);
 	sock_release_memcg(sk);
 }
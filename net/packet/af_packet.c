@@ -175,6 +175,17 @@ static int packet_set_ring(struct sock *sk, union tpacket_req_u *req_u,
 #define BLK_PLUS_PRIV(sz_of_priv) \
 	(BLK_HDR_LEN + ALIGN((sz_of_priv), V3_ALIGNMENT))
 
+/* Transmit state of one TPACKET_V3 tx ring block */
+struct tpacket_kblk_tx {
+	struct tpacket_block_desc *pbd;
+	/* skbs in flight, plus one while the block is being sent */
+	atomic_t	pending;
+	unsigned int	status;		/* block_status once they are all done */
+	unsigned int	offset;		/* of the next packet, 0 if idle */
+	unsigned int	left;		/* packets still to send */
+	unsigned int	end;		/* blk_len */
+};
+
 /* kbdq - kernel block descriptor queue */
 struct tpacket_kbdq_core {
 	struct pgv	*pkbdq;
@@ -211,6 +222,9 @@ struct tpacket_kbdq_core {
 
 	/* timer to retire an outstanding block */
 	struct timer_list retire_blk_timer;
+
+	/* tx ring only */
+	struct tpacket_kblk_tx *tx_blk;
 };
 
 #define PGV_FROM_VMALLOC 1
@@ -620,6 +634,27 @@ static void init_prb_bdqc(struct packet_sock *po,
 	prb_open_block(p1, pbd);
 }
 
+/*
+ * The tx ring has no retire timer and leaves the block headers to user
+ * space. Called with the new pg_vec and tx_blk already in place.
+ */
+static void init_prb_tx_bdqc(struct packet_sock *po,
+			     struct packet_ring_buffer *rb,
+			     union tpacket_req_u *req_u)
+{
+	struct tpacket_kbdq_core *p1 = &rb->prb_bdqc;
+	unsigned int i;
+
+	p1->pkbdq = rb->pg_vec;
+	p1->kblk_size = req_u->req3.tp_block_size;
+	p1->knum_blocks = req_u->req3.tp_block_nr;
+	p1->kactive_blk_num = 0;
+	p1->hdrlen = po->tp_hdrlen;
+	p1->version = po->tp_version;
+	for (i = 0; i < p1->knum_blocks; i++)
+		p1->tx_blk[i].pbd = GET_PBLOCK_DESC(p1, i);
+}
+
 /*  Do NOT update the last_blk_num first.
  *  Assumes sk_buff_head lock is held.
  */
@@ -1939,6 +1974,98 @@ ring_is_full:
 	goto drop_n_restore;
 }
 
+/*
+ * TPACKET_V3 transmit works on whole blocks. User space lays packets out
+ * in a block as the kernel does on receive: a tpacket3_hdr per packet,
+ * the data right after it (at TPACKET3_HDRLEN - sizeof(struct sockaddr_ll))
+ * and tp_next_offset leading to the next one. It fills in num_pkts,
+ * offset_to_first_pkt and blk_len and hands the block over by setting
+ * block_status to TP_STATUS_SEND_REQUEST. send() then transmits the
+ * blocks in ring order, stamping ts_first_pkt when it starts on a block.
+ * When the last packet of a block has left, ts_last_pkt is stamped and
+ * the block is given back with TP_STATUS_AVAILABLE, or with
+ * TP_STATUS_WRONG_FORMAT if a malformed packet cut it short. With
+ * PACKET_LOSS set, the rest of such a block is dropped instead and the
+ * ring goes on with the next one.
+ */
+static int prb_tx_block_status(struct tpacket_block_desc *pbd)
+{
+	smp_rmb();
+	flush_dcache_page(pgv_to_page(&BLOCK_STATUS(pbd)));
+	return BLOCK_STATUS(pbd);
+}
+
+static void prb_tx_set_block_status(struct tpacket_block_desc *pbd,
+				    unsigned int status)
+{
+	BLOCK_STATUS(pbd) = status;
+	flush_dcache_page(pgv_to_page(&BLOCK_STATUS(pbd)));
+	smp_wmb();
+}
+
+/* The last skb of the block is gone: give it back to user space. */
+static void prb_tx_complete_block(struct tpacket_kblk_tx *kblk)
+{
+	struct tpacket_hdr_v1 *h1 = &kblk->pbd->hdr.bh1;
+	struct timespec ts;
+
+	getnstimeofday(&ts);
+	h1->ts_last_pkt.ts_sec = ts.tv_sec;
+	h1->ts_last_pkt.ts_nsec = ts.tv_nsec;
+	smp_wmb();
+	prb_tx_set_block_status(kblk->pbd, kblk->status);
+}
+
+static bool prb_tx_block_writable(struct packet_ring_buffer *rb)
+{
+	struct tpacket_kbdq_core *pkc = GET_PBDQC_FROM_RB(rb);
+	struct tpacket_kblk_tx *kblk = &pkc->tx_blk[pkc->kactive_blk_num];
+
+	return !atomic_read(&kblk->pending) &&
+	       prb_tx_block_status(kblk->pbd) == TP_STATUS_AVAILABLE;
+}
+
+static int prb_tx_open_block(struct tpacket_kbdq_core *pkc,
+			     struct tpacket_kblk_tx *kblk)
+{
+	struct tpacket_block_desc *pbd = kblk->pbd;
+	struct tpacket_hdr_v1 *h1 = &pbd->hdr.bh1;
+	unsigned int first, end;
+	struct timespec ts;
+
+	/* user space may still be writing: read everything once */
+	first = ACCESS_ONCE(h1->offset_to_first_pkt);
+	end = ACCESS_ONCE(h1->blk_len);
+	kblk->left = ACCESS_ONCE(h1->num_pkts);
+	if (unlikely(first < BLK_HDR_LEN || end > pkc->kblk_size ||
+		     first > end))
+		return -EINVAL;
+
+	kblk->offset = first;
+	kblk->end = end;
+	kblk->status = TP_STATUS_AVAILABLE;
+	atomic_set(&kblk->pending, 1);
+
+	getnstimeofday(&ts);
+	h1->ts_first_pkt.ts_sec = ts.tv_sec;
+	h1->ts_first_pkt.ts_nsec = ts.tv_nsec;
+	prb_tx_set_block_status(pbd, TP_STATUS_SENDING);
+	return 0;
+}
+
+/* Done with sending the block; it completes when its skbs are freed. */
+static void prb_tx_close_block(struct tpacket_kbdq_core *pkc,
+			       struct tpacket_kblk_tx *kblk,
+			       unsigned int status)
+{
+	kblk->status = status;
+	kblk->offset = 0;
+	kblk->left = 0;
+	pkc->kactive_blk_num = GET_NEXT_PRB_BLK_NUM(pkc);
+	if (atomic_dec_and_test(&kblk->pending))
+		prb_tx_complete_block(kblk);
+}
+
 static void tpacket_destruct_skb(struct sk_buff *skb)
 {
 	struct packet_sock *po = pkt_sk(skb->sk);
@@ -1948,7 +2075,14 @@ static void tpacket_destruct_skb(struct sk_buff *skb)
 		ph = skb_shinfo(skb)->destructor_arg;
 		BUG_ON(atomic_read(&po->tx_ring.pending) == 0);
 		atomic_dec(&po->tx_ring.pending);
-		__packet_set_status(po, ph, TP_STATUS_AVAILABLE);
+		if (po->tp_version == TPACKET_V3) {
+			struct tpacket_kblk_tx *kblk = ph;
+
+			if (atomic_dec_and_test(&kblk->pending))
+				prb_tx_complete_block(kblk);
+		} else {
+			__packet_set_status(po, ph, TP_STATUS_AVAILABLE);
+		}
 	}
 
 	sock_wfree(skb);
@@ -1961,6 +2095,7 @@ static int tpacket_fill_skb(struct packet_sock *po, struct sk_buff *skb,
 	union {
 		struct tpacket_hdr *h1;
 		struct tpacket2_hdr *h2;
+		struct tpacket3_hdr *h3;
 		void *raw;
 	} ph;
 	int to_write, offset, len, tp_len, nr_frags, len_max;
@@ -1981,6 +2116,9 @@ static int tpacket_fill_skb(struct packet_sock *po, struct sk_buff *skb,
 	case TPACKET_V2:
 		tp_len = ph.h2->tp_len;
 		break;
+	case TPACKET_V3:
+		tp_len = ph.h3->tp_len;
+		break;
 	default:
 		tp_len = ph.h1->tp_len;
 		break;
@@ -2065,6 +2203,107 @@ static struct net_device *packet_cached_dev_get(struct packet_sock *po)
 	return dev;
 }
 
+/*
+ * Sends the TPACKET_V3 blocks that are ready, picking up where the last
+ * call stopped if that was in the middle of a block. Each packet is
+ * bounded by the end of its block as well as by size_max.
+ */
+static int tpacket_snd_v3(struct packet_sock *po, struct msghdr *msg,
+			  struct net_device *dev, __be16 proto,
+			  unsigned char *addr, int size_max)
+{
+	struct tpacket_kbdq_core *pkc = GET_PBDQC_FROM_RB(&po->tx_ring);
+	unsigned int data_off = po->tp_hdrlen - sizeof(struct sockaddr_ll);
+	int noblock = msg->msg_flags & MSG_DONTWAIT;
+	struct tpacket_kblk_tx *kblk;
+	struct tpacket3_hdr *ph;
+	struct sk_buff *skb;
+	unsigned int off, next;
+	int hlen, tlen, tp_len;
+	int len_sum = 0;
+	int err;
+
+	hlen = LL_RESERVED_SPACE(dev);
+	tlen = dev->needed_tailroom;
+
+	for (;;) {
+		kblk = &pkc->tx_blk[pkc->kactive_blk_num];
+
+		if (!kblk->offset) {
+			if (atomic_read(&kblk->pending) ||
+			    prb_tx_block_status(kblk->pbd) !=
+			    TP_STATUS_SEND_REQUEST) {
+				/* like V1/V2, block until the ring drains */
+				if (noblock || !atomic_read(&po->tx_ring.pending))
+					break;
+				schedule();
+				continue;
+			}
+			err = prb_tx_open_block(pkc, kblk);
+			if (unlikely(err)) {
+				atomic_set(&kblk->pending, 1);
+				goto bad_block;
+			}
+		}
+
+		if (!kblk->left) {
+			prb_tx_close_block(pkc, kblk, TP_STATUS_AVAILABLE);
+			continue;
+		}
+
+		err = -EINVAL;
+		off = kblk->offset;
+		if (unlikely(off & (V3_ALIGNMENT - 1) ||
+			     data_off > kblk->end - off))
+			goto bad_block;
+		ph = (struct tpacket3_hdr *)((char *)kblk->pbd + off);
+
+		skb = sock_alloc_send_skb(&po->sk,
+				hlen + tlen + sizeof(struct sockaddr_ll),
+				noblock, &err);
+		if (unlikely(skb == NULL))
+			goto out;
+
+		tp_len = tpacket_fill_skb(po, skb, ph, dev,
+				min_t(int, size_max, kblk->end - off - data_off),
+				proto, addr, hlen);
+		if (unlikely(tp_len < 0)) {
+			kfree_skb(skb);
+			err = tp_len;
+			goto bad_block;
+		}
+
+		next = ACCESS_ONCE(ph->tp_next_offset);
+		if (--kblk->left) {
+			/* a bad offset stops the block at the next packet */
+			if (!next || next > kblk->end - off)
+				next = kblk->end - off;
+			kblk->offset += next;
+		}
+
+		skb->destructor = tpacket_destruct_skb;
+		skb_shinfo(skb)->destructor_arg = kblk;
+		atomic_inc(&kblk->pending);
+		atomic_inc(&po->tx_ring.pending);
+
+		/* a dropped packet is lost, the block goes on */
+		dev_queue_xmit(skb);
+		len_sum += tp_len;
+		continue;
+
+bad_block:
+		if (po->tp_loss) {
+			prb_tx_close_block(pkc, kblk, TP_STATUS_AVAILABLE);
+			continue;
+		}
+		prb_tx_close_block(pkc, kblk, TP_STATUS_WRONG_FORMAT);
+		goto out;
+	}
+	err = 0;
+out:
+	return len_sum ? len_sum : err;
+}
+
 static int tpacket_snd(struct packet_sock *po, struct msghdr *msg)
 {
 	struct sk_buff *skb;
@@ -2108,6 +2347,12 @@ static int tpacket_snd(struct packet_sock *po, struct msghdr *msg)
 
 	reserve = dev->hard_header_len;
 
+	if (po->tp_version == TPACKET_V3) {
+		err = tpacket_snd_v3(po, msg, dev, proto, addr,
+				     dev->mtu + reserve);
+		goto out_put;
+	}
+
 	size_max = po->tx_ring.frame_size
 		- (po->tp_hdrlen - sizeof(struct sockaddr_ll));
 
@@ -3476,7 +3721,9 @@ static unsigned int packet_poll(struct file *file, struct socket *sock,
 	spin_unlock_bh(&sk->sk_receive_queue.lock);
 	spin_lock_bh(&sk->sk_write_queue.lock);
 	if (po->tx_ring.pg_vec) {
-		if (packet_current_frame(po, &po->tx_ring, TP_STATUS_AVAILABLE))
+		if (po->tp_version == TPACKET_V3 ?
+		    prb_tx_block_writable(&po->tx_ring) :
+		    packet_current_frame(po, &po->tx_ring, TP_STATUS_AVAILABLE) != NULL)
 			mask |= POLLOUT | POLLWRNORM;
 	}
 	spin_unlock_bh(&sk->sk_write_queue.lock);
@@ -3593,6 +3840,7 @@ static int packet_set_ring(struct sock *sk, union tpacket_req_u *req_u,
 		int closing, int tx_ring)
 {
 	struct pgv *pg_vec = NULL;
+	struct tpacket_kblk_tx *tx_blk = NULL;
 	struct packet_sock *po = pkt_sk(sk);
 	int was_running, order = 0;
 	struct packet_ring_buffer *rb;
@@ -3602,12 +3850,6 @@ static int packet_set_ring(struct sock *sk, union tpacket_req_u *req_u,
 	/* Added to avoid minimal code churn */
 	struct tpacket_req *req = &req_u->req;
 
-	/* Opening a Tx-ring is NOT supported in TPACKET_V3 */
-	if (!closing && tx_ring && (po->tp_version > TPACKET_V2)) {
-		WARN(1, "Tx-ring is not supported.\n");
-		goto out;
-	}
-
 	rb = tx_ring ? &po->tx_ring : &po->rx_ring;
 	rb_queue = tx_ring ? &sk->sk_write_queue : &sk->sk_receive_queue;
 
@@ -3662,12 +3904,17 @@ static int packet_set_ring(struct sock *sk, union tpacket_req_u *req_u,
 			goto out;
 		switch (po->tp_version) {
 		case TPACKET_V3:
-		/* Transmit path is not supported. We checked
-		 * it above but just being paranoid
-		 */
-			if (!tx_ring)
+			if (!tx_ring) {
 				init_prb_bdqc(po, rb, pg_vec, req_u, tx_ring);
 				break;
+			}
+			tx_blk = kcalloc(req->tp_block_nr, sizeof(*tx_blk),
+					 GFP_KERNEL);
+			if (unlikely(!tx_blk)) {
+				free_pg_vec(pg_vec, order, req->tp_block_nr);
+				goto out;
+			}
+			break;
 		default:
 			break;
 		}
@@ -3702,6 +3949,11 @@ static int packet_set_ring(struct sock *sk, union tpacket_req_u *req_u,
 		rb->frame_max = (req->tp_frame_nr - 1);
 		rb->head = 0;
 		rb->frame_size = req->tp_frame_size;
+		if (tx_ring && po->tp_version == TPACKET_V3) {
+			swap(rb->prb_bdqc.tx_blk, tx_blk);
+			if (rb->pg_vec)
+				init_prb_tx_bdqc(po, rb, req_u);
+		}
 		spin_unlock_bh(&rb_queue->lock);
 
 		swap(rb->pg_vec_order, order);
@@ -3724,7 +3976,7 @@ static int packet_set_ring(struct sock *sk, union tpacket_req_u *req_u,
 	}
 	spin_unlock(&po->bind_lock);
 	if (closing && (po->tp_version > TPACKET_V2)) {
-		/* Because we don't support block-based V3 on tx-ring */
+		/* The tx ring has no retire timer */
 		if (!tx_ring)
 			prb_shutdown_retire_blk_timer(po, tx_ring, rb_queue);
 	}
@@ -3732,6 +3984,7 @@ static int packet_set_ring(struct sock *sk, union tpacket_req_u *req_u,
 
 	if (pg_vec)
 		free_pg_vec(pg_vec, order, req->tp_block_nr);
+	kfree(tx_blk);
 out:
 	return err;
 }
@@ -362,6 +362,7 @@ static void unix_sock_destructor(struct sock *sk)
 	struct unix_sock *u = unix_sk(sk);
 
 	skb_queue_purge(&sk->sk_receive_queue);
+	skb_queue_purge(&u->skb_cache);
 
 	WARN_ON(atomic_read(&sk->sk_wmem_alloc));
 	WARN_ON(!sk_unhashed(sk));
@@ -656,6 +657,7 @@ static struct sock *unix_create1(struct net *net, struct socket *sock)
 	INIT_LIST_HEAD(&u->link);
 	mutex_init(&u->readlock); /* single task reading lock */
 	init_waitqueue_head(&u->peer_wait);
+	skb_queue_head_init(&u->skb_cache);
 	unix_insert_socket(unix_sockets_unbound(sk), sk);
 out:
 	if (sk == NULL)
@@ -1444,6 +1446,148 @@ static void maybe_add_creds(struct sk_buff *skb, const struct socket *sock,
 	}
 }
 
+/*
+ * Datagram buffers are recycled through the skb_cache of the socket that
+ * sent them: once the receiver has copied a datagram out, the buffer goes
+ * back to its sender instead of to the allocator, up to net.unix.skb_cache
+ * buffers per socket. Only datagrams of one size class are cached, so that
+ * any cached buffer fits any datagram of that class; smaller ones keep
+ * their tightly sized heads.
+ */
+static struct sk_buff *unix_alloc_send_skb(struct sock *sk, size_t len,
+					   int noblock, int *err)
+{
+	struct sk_buff *skb;
+
+	if (len <= UNIX_SKB_CACHE_MIN || len > UNIX_SKB_CACHE_SIZE ||
+	    !sock_net(sk)->unx.sysctl_skb_cache)
+		return sock_alloc_send_skb(sk, len, noblock, err);
+
+	/* sock_alloc_send_skb() deals with errors and waiting for space */
+	if (!sk->sk_err && !(sk->sk_shutdown & SEND_SHUTDOWN) &&
+	    atomic_read(&sk->sk_wmem_alloc) < sk->sk_sndbuf) {
+		skb = skb_dequeue(&unix_sk(sk)->skb_cache);
+		if (skb) {
+			skb_set_owner_w(skb, sk);
+			return skb;
+		}
+	}
+	return sock_alloc_send_skb(sk, UNIX_SKB_CACHE_SIZE, noblock, err);
+}
+
+/* Returns true if skb went back to the skb_cache of its sender. */
+static bool unix_skb_cache_put(struct sk_buff *skb)
+{
+	struct sock *sender = skb->sk;
+	struct unix_sock *u;
+
+	if (!sender || skb->destructor != unix_destruct_scm ||
+	    skb_shared(skb) || skb_cloned(skb) || skb_is_nonlinear(skb) ||
+	    skb_end_offset(skb) != UNIX_SKB_CACHE_SIZE)
+		return false;
+
+	/*
+	 * The write space charge keeps the sender's memory around, not the
+	 * sender: once its last reference is gone it is on its way out, and
+	 * uncharging this skb may be what frees it.
+	 */
+	if (!atomic_inc_not_zero(&sender->sk_refcnt))
+		return false;
+
+	u = unix_sk(sender);
+	if (skb_queue_len(&u->skb_cache) >= sock_net(sender)->unx.sysctl_skb_cache ||
+	    sock_flag(sender, SOCK_DEAD)) {
+		sock_put(sender);
+		return false;
+	}
+
+	skb_recycle(skb);
+	skb->data = skb->head;
+	skb_reset_tail_pointer(skb);
+	skb->truesize = SKB_TRUESIZE(UNIX_SKB_CACHE_SIZE);
+	skb_queue_head(&u->skb_cache, skb);
+	sock_put(sender);
+	return true;
+}
+
+static void unix_free_datagram(struct sock *sk, struct sk_buff *skb)
+{
+	if (!unix_skb_cache_put(skb))
+		skb_free_datagram(sk, skb);
+}
+
+/*
+ * sendmmsg() batches: once a datagram has gone to a receiver the usual
+ * way, the following ones to the same receiver collect on the batch queue
+ * without its state lock being taken, and are queued to it in one go,
+ * with one wakeup, when the batch ends or has to be cut short. The checks
+ * made under the lock for the first datagram hold for the rest of the
+ * batch, as they do for a receiver address socket.c has seen before.
+ * Datagrams carrying descriptors are never held back, so the garbage
+ * collector finds every file in flight on some receive queue.
+ */
+static void unix_send_batch_flush(struct sock_batch *batch)
+{
+	struct sock *other = batch->sk;
+	struct sk_buff *skb;
+	unsigned long flags;
+
+	if (!other)
+		return;
+	batch->sk = NULL;
+
+	unix_state_lock(other);
+	if (sock_flag(other, SOCK_DEAD) ||
+	    (other->sk_shutdown & RCV_SHUTDOWN)) {
+		/* as if it had gone just after taking them */
+		unix_state_unlock(other);
+		__skb_queue_purge(&batch->queue);
+		goto out;
+	}
+	skb_queue_walk(&batch->queue, skb)
+		maybe_add_creds(skb, skb->sk->sk_socket, other);
+	spin_lock_irqsave(&other->sk_receive_queue.lock, flags);
+	skb_queue_splice_tail_init(&batch->queue, &other->sk_receive_queue);
+	spin_unlock_irqrestore(&other->sk_receive_queue.lock, flags);
+	unix_state_unlock(other);
+	other->sk_data_ready(other, batch->len);
+out:
+	batch->len = 0;
+	sock_put(other);
+}
+
+/* Takes over the reference to other held by the caller. */
+static void unix_send_batch_open(struct sock_batch *batch, struct sock *other,
+				 size_t len)
+{
+	batch->flush = unix_send_batch_flush;
+	batch->sk = other;
+	batch->len = len;
+}
+
+static bool unix_send_batch_add(struct sock_batch *batch, struct sock *sk,
+				struct sock *other, struct sk_buff *skb,
+				size_t len)
+{
+	unsigned int qlen;
+
+	if (batch->sk != other || UNIXCB(skb).fp)
+		return false;
+
+	/* the receive queue limit counts what the batch holds back */
+	qlen = skb_queue_len(&batch->queue);
+	if (unix_peer(other) != sk)
+		qlen += skb_queue_len(&other->sk_receive_queue);
+	if (qlen >= other->sk_max_ack_backlog)
+		return false;
+
+	if (sock_flag(other, SOCK_RCVTSTAMP))
+		__net_timestamp(skb);
+	__skb_queue_tail(&batch->queue, skb);
+	batch->len += len;
+	return true;
+}
+
 /*
  *	Send AF_UNIX data.
  */
@@ -1452,6 +1596,7 @@ static int unix_dgram_sendmsg(struct kiocb *kiocb, struct socket *sock,
 			      struct msghdr *msg, size_t len)
 {
 	struct sock_iocb *siocb = kiocb_to_siocb(kiocb);
+	struct sock_batch *batch = siocb->batch;
 	struct sock *sk = sock->sk;
 	struct net *net = sock_net(sk);
 	struct unix_sock *u = unix_sk(sk);
@@ -1497,7 +1642,12 @@ static int unix_dgram_sendmsg(struct kiocb *kiocb, struct socket *sock,
 	if (len > sk->sk_sndbuf - 32)
 		goto out;
 
-	skb = sock_alloc_send_skb(sk, len, msg->msg_flags&MSG_DONTWAIT, &err);
+	/* the allocation might wait for what the batch holds back */
+	if (batch && batch->sk &&
+	    atomic_read(&sk->sk_wmem_alloc) >= sk->sk_sndbuf)
+		unix_send_batch_flush(batch);
+
+	skb = unix_alloc_send_skb(sk, len, msg->msg_flags&MSG_DONTWAIT, &err);
 	if (skb == NULL)
 		goto out;
 
@@ -1532,6 +1682,15 @@ restart:
 		goto out_free;
 	}
 
+	if (batch && batch->sk) {
+		if (unix_send_batch_add(batch, sk, other, skb, len)) {
+			sock_put(other);
+			scm_destroy(siocb->scm);
+			return len;
+		}
+		unix_send_batch_flush(batch);
+	}
+
 	unix_state_lock(other);
 	err = -EPERM;
 	if (!unix_may_send(sk, other))
@@ -1596,8 +1755,13 @@ restart:
 	if (max_level > unix_sk(other)->recursion_level)
 		unix_sk(other)->recursion_level = max_level;
 	unix_state_unlock(other);
-	other->sk_data_ready(other, len);
-	sock_put(other);
+	if (batch && batch->remaining > 1) {
+		/* the wakeup waits for the end of the batch */
+		unix_send_batch_open(batch, other, len);
+	} else {
+		other->sk_data_ready(other, len);
+		sock_put(other);
+	}
 	scm_destroy(siocb->scm);
 	return len;
 
@@ -1774,11 +1938,77 @@ static void unix_copy_addr(struct msghdr *msg, struct sock *sk)
 	}
 }
 
+/*
+ * recvmmsg() batches: the reader holds u->readlock from the first message
+ * to the last, moves as many datagrams as the batch has messages left off
+ * the receive queue under one lock, and wakes blocked writers once rather
+ * than per datagram. Whatever the batch took but did not return goes back
+ * to the head of the queue at the end. Datagrams carrying descriptors
+ * are left on the queue for the garbage collector to see.
+ */
+static void unix_recv_batch_wake(struct sock_batch *batch)
+{
+	if (batch->len) {
+		batch->len = 0;
+		wake_up_interruptible_sync_poll(&unix_sk(batch->sk)->peer_wait,
+						POLLOUT | POLLWRNORM | POLLWRBAND);
+	}
+}
+
+static void unix_recv_batch_flush(struct sock_batch *batch)
+{
+	struct sock *sk = batch->sk;
+	struct sk_buff_head *queue = &sk->sk_receive_queue;
+	unsigned long flags;
+
+	if (!skb_queue_empty(&batch->queue)) {
+		spin_lock_irqsave(&queue->lock, flags);
+		skb_queue_splice(&batch->queue, queue);
+		spin_unlock_irqrestore(&queue->lock, flags);
+		sk->sk_data_ready(sk, 0);
+	}
+	unix_recv_batch_wake(batch);
+	mutex_unlock(&unix_sk(sk)->readlock);
+}
+
+/* The caller holds u->readlock, which the batch keeps until its end. */
+static void unix_recv_batch_open(struct sock_batch *batch, struct sock *sk)
+{
+	batch->flush = unix_recv_batch_flush;
+	batch->sk = sk;
+}
+
+static struct sk_buff *unix_recv_batch_skb(struct sock_batch *batch,
+					   struct sock *sk)
+{
+	struct sk_buff_head *queue = &sk->sk_receive_queue;
+	struct sk_buff *skb;
+	unsigned long flags;
+	unsigned int n;
+
+	skb = __skb_dequeue(&batch->queue);
+	if (skb || sk->sk_err)
+		return skb;
+
+	spin_lock_irqsave(&queue->lock, flags);
+	for (n = batch->remaining; n; n--) {
+		skb = skb_peek(queue);
+		if (!skb || UNIXCB(skb).fp)
+			break;
+		__skb_unlink(skb, queue);
+		__skb_queue_tail(&batch->queue, skb);
+	}
+	spin_unlock_irqrestore(&queue->lock, flags);
+
+	return __skb_dequeue(&batch->queue);
+}
+
 static int unix_dgram_recvmsg(struct kiocb *iocb, struct socket *sock,
 			      struct msghdr *msg, size_t size,
 			      int flags)
 {
 	struct sock_iocb *siocb = kiocb_to_siocb(iocb);
+	struct sock_batch *batch = siocb->batch;
 	struct scm_cookie tmp_scm;
 	struct sock *sk = sock->sk;
 	struct unix_sock *u = unix_sk(sk);
@@ -1791,18 +2021,34 @@ static int unix_dgram_recvmsg(struct kiocb *iocb, struct socket *sock,
 	if (flags&MSG_OOB)
 		goto out;
 
-	err = mutex_lock_interruptible(&u->readlock);
-	if (unlikely(err)) {
-		/* recvmsg() in non blocking mode is supposed to return -EAGAIN
-		 * sk_rcvtimeo is not honored by mutex_lock_interruptible()
-		 */
-		err = noblock ? -EAGAIN : -ERESTARTSYS;
-		goto out;
+	/* peeking leaves the datagrams where they are */
+	if (flags & MSG_PEEK)
+		batch = NULL;
+
+	if (!batch || batch->sk != sk) {
+		err = mutex_lock_interruptible(&u->readlock);
+		if (unlikely(err)) {
+			/* recvmsg() in non blocking mode is supposed to return -EAGAIN
+			 * sk_rcvtimeo is not honored by mutex_lock_interruptible()
+			 */
+			err = noblock ? -EAGAIN : -ERESTARTSYS;
+			goto out;
+		}
+		if (batch)
+			unix_recv_batch_open(batch, sk);
 	}
 
 	skip = sk_peek_offset(sk, flags);
 
-	skb = __skb_recv_datagram(sk, flags, &peeked, &skip, &err);
+	skb = NULL;
+	if (batch) {
+		skb = unix_recv_batch_skb(batch, sk);
+		/* writers must not wait on us while we wait for them */
+		if (!skb)
+			unix_recv_batch_wake(batch);
+	}
+	if (!skb)
+		skb = __skb_recv_datagram(sk, flags, &peeked, &skip, &err);
 	if (!skb) {
 		unix_state_lock(sk);
 		/* Signal EOF on disconnected non-blocking SEQPACKET socket. */
@@ -1813,8 +2059,11 @@ static int unix_dgram_recvmsg(struct kiocb *iocb, struct socket *sock,
 		goto out_unlock;
 	}
 
-	wake_up_interruptible_sync_poll(&u->peer_wait,
-					POLLOUT | POLLWRNORM | POLLWRBAND);
+	if (batch)
+		batch->len++;
+	else
+		wake_up_interruptible_sync_poll(&u->peer_wait,
+						POLLOUT | POLLWRNORM | POLLWRBAND);
 
 	if (msg->msg_name)
 		unix_copy_addr(msg, skb->sk);
@@ -1867,9 +2116,10 @@ static int unix_dgram_recvmsg(struct kiocb *iocb, struct socket *sock,
 	scm_recv(sock, msg, siocb->scm, flags);
 
 out_free:
-	skb_free_datagram(sk, skb);
+	unix_free_datagram(sk, skb);
 out_unlock:
-	mutex_unlock(&u->readlock);
+	if (!batch)
+		mutex_unlock(&u->readlock);
 out:
 	return err;
 }
@@ -2413,6 +2663,7 @@ static int __net_init unix_net_init(struct net *net)
 	int error = -ENOMEM;
 
 	net->unx.sysctl_max_dgram_qlen = 300;
+	net->unx.sysctl_skb_cache = 8;
 	if (unix_sysctl_register(net))
 		goto out;
 
@@ -0,0 +1,89 @@
+#!/bin/sh
+#
+# Regression checks for the devfreq governors, run against synthetic traces
+# of 10ms samples recorded at the top level: a light and a heavy steady
+# load, and a load switching between the two every second. The adreno
+# governors have to settle at the bottom level for the light load and at
+# the top for the heavy one without missing frames, and to spend less
+# energy than the performance governor on the switching load while missing
+# no more than MAX_MISSED percent of their frames.
+
+SIM=${SIM:-./adreno_devfreq_sim}
+LEVELS=${LEVELS:-450000000:2000,320000000:1200,200000000:700,100000000:350}
+IDLE_MW=${IDLE_MW:-100}
+MAX_MISSED=${MAX_MISSED:-10}
+
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+ret=0
+
+# trace <file> <samples> <busy_us> [<busy_us> every other second]
+trace() {
+	awk -v n="$2" -v a="$3" -v b="${4:-$3}" 'BEGIN {
+		for (i = 0; i < n; i++)
+			printf "kworker/u:1-60 [000] ...1 %d.%06d: " \
+			       "kgsl_devfreq_status: d_name=kgsl-3d0 " \
+			       "freq=450000000 total_time=10000 " \
+			       "busy_time=%d ram_time=0 ram_wait=0 bus_mod=0\n",
+			       i / 100, (i % 100) * 10000,
+			       int(i / 100) % 2 ? b : a
+	}' > "$TMP/$1"
+}
+
+# sim <governor> <trace> [options]: prints "top bottom energy missed_pct"
+sim() {
+	gov=$1
+	file=$2
+	shift 2
+	$SIM -l "$LEVELS" -i "$IDLE_MW" -g "$gov" "$@" "$TMP/$file" |
+	awk '$1 == "level" { n = 0; next }
+	     $1 ~ /^[0-9]+$/ { pct[n++] = $3 }
+	     $1 == "energy_mJ" { e = $2 }
+	     $5 == "missed_pct" { m = $6 }
+	     END { printf "%s %s %s %s\n", pct[0], pct[n - 1], e, m }'
+}
+
+check() {
+	if awk "BEGIN { exit !($2) }"; then
+		echo "[PASS] $1"
+	else
+		echo "[FAIL] $1"
+		ret=1
+	fi
+}
+
+trace light 1000 500
+trace heavy 1000 9000
+trace switch 1000 500 8000
+
+set -- $(sim msm-adreno-tz light)
+check "msm-adreno-tz light load: $2% at bottom, $4% missed" "$2 >= 90 && $4 == 0"
+
+set -- $(sim msm-adreno-tz heavy)
+check "msm-adreno-tz heavy load: $1% at top, $4% missed" "$1 >= 90 && $4 == 0"
+
+set -- $(sim performance switch)
+perf=$3
+set -- $(sim msm-adreno-tz switch)
+check "msm-adreno-tz switching load: $3 mJ (performance $perf), $4% missed" \
+	"$3 < $perf && $4 <= $MAX_MISSED"
+
+set -- $(sim msm-adreno-tz switch -p simple_gpu_activate=1)
+check "simple_gpu_algorithm switching load: $3 mJ (performance $perf), $4% missed" \
+	"$3 < $perf && $4 <= $MAX_MISSED"
+
+set -- $(sim adreno-deadline light)
+check "adreno-deadline light load: $2% at bottom, $4% missed" "$2 >= 90 && $4 == 0"
+
+set -- $(sim adreno-deadline heavy)
+check "adreno-deadline heavy load: $1% at top, $4% missed" "$1 >= 90 && $4 == 0"
+
+set -- $(sim adreno-deadline switch)
+check "adreno-deadline switching load: $3 mJ (performance $perf), $4% missed" \
+	"$3 < $perf && $4 <= $MAX_MISSED"
+
+set -- $(sim powersave heavy)
+check "powersave heavy load: $2% at bottom" "$2 == 100"
+
+exit $ret
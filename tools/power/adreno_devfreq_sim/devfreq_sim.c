@@ -0,0 +1,428 @@
+/*
+ * adreno_devfreq_sim: replays a GPU load trace through the devfreq governors
+ *
+ *   adreno_devfreq_sim -l freq[:mW],... [-g governor] [-i idle_mW]
+ *                      [-v vsync_us] [-p name=value]... [-s] [-d] [trace]
+ *
+ * The trace is the text output of the kgsl_devfreq_status trace event, one
+ * line per sample the kgsl device handed to its governor, read from the
+ * trace file or standard input. Each sample says for how long the GPU was
+ * busy at the frequency it ran at; the simulator turns that into GPU cycles
+ * and runs them again at the frequencies the governor picks, calling the
+ * governor once per sample the way kgsl does, and at the end of every frame
+ * for the governors that follow frames. The governors are the kernel
+ * sources from drivers/devfreq, built unchanged.
+ *
+ * -l gives the gpu_freq of the power levels, fastest first, each with the
+ * power drawn while busy at that level in mW. The sleep level kgsl keeps at
+ * the end of the table is added. -i is the power while clocked but idle.
+ *
+ * The work of the trace is cut into vsync periods (-v, 16667us by default).
+ * The work of a period is submitted at its start and is due at its end; the
+ * GPU runs it in order, so a late frame delays the next ones. GPU cycles are
+ * taken to be the same at every frequency, which is pessimistic for work
+ * that waits on memory, and a GPU that was saturated in the trace may have
+ * had more work than the trace shows.
+ *
+ * -p sets a module parameter of the governors (for instance
+ * simple_gpu_activate=1, or tz_model_up and tz_model_down for the stand-in
+ * of the TrustZone algorithm) or, as "group/file=value", a sysfs file of the
+ * running governor such as msm-adreno-tz/target. -s prints every sample,
+ * -d the debugfs files of the governor when the trace ends.
+ *
+ * Prints the time spent and the share of it busy at each level, the energy
+ * and the frames that missed their vsync.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+
+#include <linux/kernel.h>
+#include <linux/devfreq.h>
+#include <linux/msm_adreno_devfreq.h>
+#include <unistd.h>
+#include "governor.h"
+#include "sim.h"
+
+/* kgsl ends the power level table with the 27MHz sleep level */
+#define SLEEP_FREQ	27000000
+#define MAX_PARAMS	16
+
+struct sample {
+	unsigned long freq;
+	unsigned long total_time;
+	unsigned long busy_time;
+};
+
+static struct sample *samples;
+static unsigned int nr_samples;
+
+static unsigned int freq_table[MSM_ADRENO_MAX_PWRLEVELS];
+static unsigned int power_mw[MSM_ADRENO_MAX_PWRLEVELS];
+static unsigned int num_levels, idle_mw;
+
+static unsigned int active_level;
+static unsigned long transitions;
+
+/* usecs since the start of the trace */
+static double sim_now;
+
+/* the time the GPU spent at each level, and busy at each level */
+static double time_in[MSM_ADRENO_MAX_PWRLEVELS];
+static double busy_in[MSM_ADRENO_MAX_PWRLEVELS];
+static double level_since;
+
+/* what get_dev_status() reports: the time since it was last called */
+static double status_since, status_busy;
+
+static struct device gpu_dev;
+static struct devfreq_msm_adreno_tz_data tz_data;
+static struct msm_adreno_extended_profile ext_profile = {
+	.private_data = &tz_data,
+};
+static struct devfreq devfreq;
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s -l freq[:mW],... [-g governor] "
+			"[-i idle_mW] [-v vsync_us] [-p name=value]... [-s] [-d] "
+			"[trace]\ngovernors:", prog);
+	sim_list_governors(stderr);
+	exit(1);
+}
+
+/* Picks the level for *freq the way kgsl_devfreq_target() does */
+static int sim_target(struct device *dev, unsigned long *freq, u32 flags)
+{
+	unsigned int level = active_level;
+	int i;
+
+	if (flags & DEVFREQ_FLAG_WAKEUP_MAXFREQ)
+		return 0;
+
+	if (*freq != freq_table[active_level]) {
+		level = 0;
+		for (i = num_levels - 1; i >= 0; i--)
+			if (*freq <= freq_table[i]) {
+				level = i;
+				break;
+			}
+	}
+
+	if (level != active_level) {
+		time_in[active_level] += sim_now - level_since;
+		level_since = sim_now;
+		transitions++;
+	}
+	active_level = level;
+	*freq = freq_table[level];
+	return 0;
+}
+
+static int sim_get_dev_status(struct device *dev,
+			      struct devfreq_dev_status *stat)
+{
+	stat->current_frequency = freq_table[active_level];
+	stat->total_time = sim_now - status_since + 0.5;
+	stat->busy_time = min_t(unsigned long, status_busy + 0.5,
+				stat->total_time);
+	if (stat->private_data)
+		memset(stat->private_data, 0, sizeof(struct xstats));
+
+	status_since = sim_now;
+	status_busy = 0;
+	return 0;
+}
+
+static int sim_get_cur_freq(struct device *dev, unsigned long *freq)
+{
+	*freq = freq_table[active_level];
+	return 0;
+}
+
+/* As kgsl_pwrscale_frame() and do_devfreq_notify() report a frame */
+static void notify_frame(double start, double busy)
+{
+	struct adreno_frame_stats frame = {
+		.devfreq = &devfreq,
+		.start = start,
+		.end = sim_now,
+		.busy = busy + 0.5,
+		.freq = freq_table[active_level],
+	};
+
+	sim_notify(ADRENO_DEVFREQ_NOTIFY_FRAME, &frame);
+}
+
+static void parse_levels(const char *arg, const char *prog)
+{
+	char *end;
+
+	while (*arg) {
+		if (num_levels == MSM_ADRENO_MAX_PWRLEVELS - 2)
+			usage(prog);
+		freq_table[num_levels] = strtoul(arg, &end, 0);
+		if (*end == ':')
+			power_mw[num_levels] = strtoul(end + 1, &end, 0);
+		if (!freq_table[num_levels] || (*end && *end != ',') ||
+		    (num_levels &&
+		     freq_table[num_levels] >= freq_table[num_levels - 1]))
+			usage(prog);
+		num_levels++;
+		arg = *end ? end + 1 : end;
+	}
+	if (!num_levels)
+		usage(prog);
+	freq_table[num_levels] = SLEEP_FREQ;
+}
+
+static unsigned long field(const char *line, const char *name)
+{
+	const char *p = strstr(line, name);
+
+	return p ? strtoul(p + strlen(name), NULL, 0) : 0;
+}
+
+static void read_trace(FILE *f)
+{
+	unsigned int size = 0;
+	struct sample *s;
+	char *line = NULL;
+	size_t len = 0;
+	const char *p;
+
+	while (getline(&line, &len, f) > 0) {
+		p = strstr(line, "kgsl_devfreq_status:");
+		if (p == NULL)
+			continue;
+		if (nr_samples == size) {
+			size = size ? size * 2 : 1024;
+			samples = realloc(samples, size * sizeof(*samples));
+			if (samples == NULL) {
+				perror("realloc");
+				exit(1);
+			}
+		}
+		s = &samples[nr_samples++];
+		s->freq = field(p, " freq=");
+		s->total_time = field(p, " total_time=");
+		s->busy_time = min(field(p, " busy_time="), s->total_time);
+	}
+	free(line);
+}
+
+int main(int argc, char **argv)
+{
+	const char *prog = argv[0], *gov_name = "msm-adreno-tz";
+	struct devfreq_dev_profile *profile = &ext_profile.profile;
+	unsigned long long t, end, total = 0, vsync = 16667;
+	double *frame_work, left, run, busy, cps, energy = 0;
+	struct {
+		double start;
+		double busy;
+	} frame;
+	unsigned long nr_frames, due, head, next, k, missed = 0;
+	char *params[MAX_PARAMS], *value;
+	int i, c, nr_params = 0, dump = 0, dump_debugfs = 0;
+	bool started = false;
+	struct sample *s;
+	FILE *f = stdin;
+
+	while ((c = getopt(argc, argv, "l:g:i:v:p:sd")) != -1) {
+		switch (c) {
+		case 'l':
+			parse_levels(optarg, prog);
+			break;
+		case 'g':
+			gov_name = optarg;
+			break;
+		case 'i':
+			idle_mw = strtoul(optarg, NULL, 0);
+			break;
+		case 'v':
+			vsync = strtoull(optarg, NULL, 0);
+			if (!vsync)
+				usage(prog);
+			break;
+		case 'p':
+			if (nr_params == MAX_PARAMS || !strchr(optarg, '='))
+				usage(prog);
+			params[nr_params++] = optarg;
+			break;
+		case 's':
+			dump = 1;
+			break;
+		case 'd':
+			dump_debugfs = 1;
+			break;
+		default:
+			usage(prog);
+		}
+	}
+	if (!num_levels || argc - optind > 1)
+		usage(prog);
+	if (argc - optind == 1) {
+		f = fopen(argv[optind], "r");
+		if (f == NULL) {
+			perror(argv[optind]);
+			return 1;
+		}
+	}
+
+	read_trace(f);
+	if (!nr_samples) {
+		fprintf(stderr, "no kgsl_devfreq_status samples\n");
+		return 1;
+	}
+
+	/* the work of each vsync period, in cycles */
+	for (i = 0; i < nr_samples; i++)
+		total += samples[i].total_time;
+	nr_frames = (total + vsync - 1) / vsync;
+	frame_work = calloc(nr_frames + 1, sizeof(*frame_work));
+	if (frame_work == NULL) {
+		perror("calloc");
+		return 1;
+	}
+	for (i = 0, t = 0; i < nr_samples; i++) {
+		s = &samples[i];
+		if (!s->total_time)
+			continue;
+		cps = (double)s->busy_time * s->freq / 1e6 / s->total_time;
+		for (end = t + s->total_time; t < end; t = min(end, due)) {
+			k = t / vsync;
+			due = (k + 1) * vsync;
+			frame_work[k] += cps * (min(end, due) - t);
+		}
+	}
+
+	/* start at the level of the trace, as kgsl starts at its default */
+	for (i = 0; i < num_levels; i++)
+		if (freq_table[i] == samples[0].freq)
+			active_level = i;
+
+	profile->initial_freq = freq_table[active_level];
+	profile->polling_ms = 10;
+	profile->target = sim_target;
+	profile->get_dev_status = sim_get_dev_status;
+	profile->get_cur_freq = sim_get_cur_freq;
+	profile->freq_table = freq_table;
+	profile->max_state = num_levels;
+
+	devfreq.dev.parent = &gpu_dev;
+	devfreq.profile = profile;
+	devfreq.data = ext_profile.private_data;
+	devfreq.previous_freq = profile->initial_freq;
+	devfreq.governor = sim_find_governor(gov_name);
+	if (devfreq.governor == NULL)
+		usage(prog);
+	strncpy(devfreq.governor_name, gov_name, DEVFREQ_NAME_LEN - 1);
+
+	/* module parameters before the governor starts, sysfs files after */
+	for (c = 0; c < 2; c++) {
+		for (i = 0; i < nr_params; i++) {
+			value = strchr(params[i], '=');
+			if (!strchr(params[i], '/') != !c)
+				continue;
+			*value = '\0';
+			if (sim_set_param(params[i], value + 1)) {
+				fprintf(stderr, "cannot set %s\n", params[i]);
+				return 1;
+			}
+			*value = '=';
+		}
+		if (!c && devfreq.governor->event_handler(&devfreq,
+						DEVFREQ_GOV_START, NULL)) {
+			fprintf(stderr, "%s failed to start\n", gov_name);
+			return 1;
+		}
+	}
+
+	head = next = 0;
+	left = frame_work[0];
+	for (i = 0, t = 0; i < nr_samples; i++) {
+		s = &samples[i];
+		busy = 0;
+
+		for (end = t + s->total_time; t < end; t = due) {
+			/* frames are submitted at their vsync */
+			while (next < nr_frames && next * vsync <= t)
+				next++;
+			due = next * vsync;
+			if (next == nr_frames || due > end)
+				due = end;
+
+			sim_now = t;
+			while (head < next && (sim_now < due || !left)) {
+				if (!started) {
+					frame.start = sim_now;
+					frame.busy = 0;
+					started = true;
+				}
+
+				cps = freq_table[active_level] / 1e6;
+				run = min(left / cps, due - sim_now);
+				left = run < left / cps ? left - run * cps : 0;
+				sim_now += run;
+				busy += run;
+				frame.busy += run;
+				status_busy += run;
+				busy_in[active_level] += run;
+				if (left > 0)
+					break;
+
+				if (sim_now > (head + 1) * vsync + 1e-6)
+					missed++;
+				left = frame_work[++head];
+				started = false;
+
+				/* kgsl reports the frames the GPU worked on */
+				if (frame.busy > 0)
+					notify_frame(frame.start, frame.busy);
+			}
+		}
+		sim_now = end;
+
+		if (dump)
+			printf("sample %.3f %u %.0f\n", t / 1e3,
+			       freq_table[active_level], busy);
+
+		/* kgsl notifies the governors that asked, devfreq polls */
+		if (sim_notify(ADRENO_DEVFREQ_NOTIFY_RETIRE, &devfreq) ==
+		    -ENOENT) {
+			mutex_lock(&devfreq.lock);
+			update_devfreq(&devfreq);
+			mutex_unlock(&devfreq.lock);
+		}
+	}
+	time_in[active_level] += sim_now - level_since;
+
+	/* frames still queued when their vsync came are late too */
+	for (k = head; k < next; k++)
+		if ((k + 1) * vsync <= total)
+			missed++;
+
+	printf("governor %s\n", gov_name);
+	printf("time_ms %.1f samples %u transitions %lu\n", total / 1e3,
+	       nr_samples, transitions);
+	printf("level freq time_pct busy_pct\n");
+	for (i = 0; i < num_levels; i++) {
+		energy += busy_in[i] * power_mw[i] +
+			  (time_in[i] - busy_in[i]) * idle_mw;
+		printf("%d %u %.1f %.1f\n", i, freq_table[i],
+		       100 * time_in[i] / total,
+		       time_in[i] ? 100 * busy_in[i] / time_in[i] : 0.0);
+	}
+	printf("energy_mJ %.1f avg_mW %.1f\n", energy / 1e6, energy / total);
+	printf("frames %llu missed %lu missed_pct %.1f\n", total / vsync,
+	       missed, total / vsync ? 100.0 * missed / (total / vsync) : 0.0);
+
+	if (dump_debugfs)
+		sim_dump_debugfs(stdout);
+
+	devfreq.governor->event_handler(&devfreq, DEVFREQ_GOV_STOP, NULL);
+	free(frame_work);
+	free(samples);
+	return 0;
+}
@@ -0,0 +1,13 @@
+/*
+ * The real <linux/devfreq.h>, so that the governors and the simulator
+ * agree with the kernel on struct devfreq and the profile callbacks.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+#include <linux/kernel.h>
+#include <linux/device.h>
+#include <linux/notifier.h>
+#include <linux/opp.h>
+#include_next <linux/devfreq.h>
@@ -0,0 +1,53 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+#ifndef _SIM_LINUX_DEVICE_H
+#define _SIM_LINUX_DEVICE_H
+
+#include <linux/kernel.h>
+#include <linux/mutex.h>
+
+struct device {
+	struct device *parent;
+	void *driver_data;
+};
+
+struct work_struct {
+	void (*func)(struct work_struct *work);
+};
+
+struct delayed_work {
+	struct work_struct work;
+};
+
+struct kobject;
+
+struct attribute {
+	const char *name;
+	unsigned short mode;
+};
+
+struct attribute_group {
+	const char *name;
+	struct attribute **attrs;
+};
+
+struct kobj_attribute {
+	struct attribute attr;
+	ssize_t (*show)(struct kobject *kobj, struct kobj_attribute *attr,
+			char *buf);
+	ssize_t (*store)(struct kobject *kobj, struct kobj_attribute *attr,
+			 const char *buf, size_t count);
+};
+
+#define __ATTR(_name, _mode, _show, _store) {				\
+	.attr = { .name = #_name, .mode = _mode },			\
+	.show = _show,							\
+	.store = _store,						\
+}
+
+#define dev_err(dev, fmt, ...)	fprintf(stderr, fmt, ##__VA_ARGS__)
+
+#endif /* _SIM_LINUX_DEVICE_H */
@@ -0,0 +1,29 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+#ifndef _SIM_LINUX_FS_H
+#define _SIM_LINUX_FS_H
+
+#include <linux/kernel.h>
+
+struct inode {
+	void *i_private;
+};
+
+struct file {
+	void *private_data;
+};
+
+struct file_operations {
+	int (*open)(struct inode *inode, struct file *file);
+	ssize_t (*read)(struct file *file, char __user *buf, size_t count,
+			loff_t *ppos);
+	ssize_t (*write)(struct file *file, const char __user *buf,
+			 size_t count, loff_t *ppos);
+	loff_t (*llseek)(struct file *file, loff_t offset, int whence);
+	int (*release)(struct inode *inode, struct file *file);
+};
+
+#endif /* _SIM_LINUX_FS_H */
@@ -0,0 +1,8 @@
+/*
+ * Nothing from <linux/ftrace.h> is used by the governors.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+#include <linux/kernel.h>
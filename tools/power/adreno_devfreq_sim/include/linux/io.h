@@ -0,0 +1,13 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+#ifndef _SIM_LINUX_IO_H
+#define _SIM_LINUX_IO_H
+
+#include <linux/kernel.h>
+
+#define __iowmb()	do { } while (0)
+
+#endif /* _SIM_LINUX_IO_H */
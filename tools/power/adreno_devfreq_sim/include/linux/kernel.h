@@ -0,0 +1,75 @@
+/*
+ * The part of the kernel API the devfreq governors use, for building them
+ * in user space. Everything here is single threaded: locks only record
+ * that they are held.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+#ifndef _SIM_LINUX_KERNEL_H
+#define _SIM_LINUX_KERNEL_H
+
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+typedef uint8_t u8;
+typedef int32_t s32;
+typedef uint32_t u32;
+typedef int64_t s64;
+typedef uint64_t u64;
+
+struct list_head {
+	struct list_head *next, *prev;
+};
+
+#define __init
+#define __exit
+#define __iomem
+#define __user
+
+#define USEC_PER_SEC	1000000L
+
+#define likely(x)	__builtin_expect(!!(x), 1)
+#define unlikely(x)	__builtin_expect(!!(x), 0)
+
+#define ARRAY_SIZE(a)	(sizeof(a) / sizeof((a)[0]))
+
+#define container_of(ptr, type, member) \
+	((type *)((char *)(ptr) - offsetof(type, member)))
+
+#define min(a, b)	((a) < (b) ? (a) : (b))
+#define max(a, b)	((a) > (b) ? (a) : (b))
+#define min_t(type, a, b) min((type)(a), (type)(b))
+#define max_t(type, a, b) max((type)(a), (type)(b))
+#define clamp(val, lo, hi) min(max(val, lo), hi)
+
+#define IS_ERR(ptr)	((unsigned long)(ptr) >= (unsigned long)-4095)
+
+#define BUG_ON(cond)							\
+	do {								\
+		if (cond) {						\
+			fprintf(stderr, "BUG at %s:%d\n",		\
+				__FILE__, __LINE__);			\
+			abort();					\
+		}							\
+	} while (0)
+
+#define WARN(cond, fmt, ...) \
+	({ int __c = !!(cond); if (__c) fprintf(stderr, fmt, ##__VA_ARGS__); __c; })
+
+#define pr_err(fmt, ...)	fprintf(stderr, fmt, ##__VA_ARGS__)
+#define pr_info(fmt, ...)	fprintf(stderr, fmt, ##__VA_ARGS__)
+#define pr_debug(fmt, ...)	do { } while (0)
+
+#define EXPORT_SYMBOL(sym)
+#define EXPORT_SYMBOL_GPL(sym)
+
+#endif /* _SIM_LINUX_KERNEL_H */
@@ -0,0 +1,36 @@
+/*
+ * Initcalls run as constructors, before main(). Module parameters are
+ * registered by name so they can be set from the command line.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+#ifndef _SIM_LINUX_MODULE_H
+#define _SIM_LINUX_MODULE_H
+
+#include <linux/kernel.h>
+
+void sim_register_param(const char *name, int *value);
+
+#define subsys_initcall(fn)						\
+	static void __attribute__((constructor)) __sim_init_##fn(void)	\
+	{								\
+		fn();							\
+	}
+
+#define module_exit(fn) \
+	static void (*__sim_exit_##fn)(void) __attribute__((unused)) = fn
+
+/* Only int parameters are used by the governors */
+#define module_param_named(name, value, type, perm)			\
+	static void __attribute__((constructor)) __sim_param_##name(void) \
+	{								\
+		sim_register_param(#name, &(value));			\
+	}
+
+#define MODULE_LICENSE(x)
+#define MODULE_AUTHOR(x)
+#define MODULE_DESCRIPTION(x)
+
+#endif /* _SIM_LINUX_MODULE_H */
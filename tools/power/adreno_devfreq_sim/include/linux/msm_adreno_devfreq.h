@@ -0,0 +1,7 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+#include <linux/devfreq.h>
+#include_next <linux/msm_adreno_devfreq.h>
@@ -0,0 +1,19 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+#ifndef _SIM_LINUX_MUTEX_H
+#define _SIM_LINUX_MUTEX_H
+
+#include <linux/kernel.h>
+
+struct mutex {
+	int locked;
+};
+
+#define mutex_lock(m)		((m)->locked = 1)
+#define mutex_unlock(m)		((m)->locked = 0)
+#define mutex_is_locked(m)	((m)->locked)
+
+#endif /* _SIM_LINUX_MUTEX_H */
@@ -0,0 +1,11 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+#ifndef _SIM_LINUX_OPP_H
+#define _SIM_LINUX_OPP_H
+
+struct opp;
+
+#endif /* _SIM_LINUX_OPP_H */
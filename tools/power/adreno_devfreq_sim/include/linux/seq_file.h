@@ -0,0 +1,31 @@
+/*
+ * seq_file output goes straight to the FILE the simulator dumps the
+ * debugfs files to.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+#ifndef _SIM_LINUX_SEQ_FILE_H
+#define _SIM_LINUX_SEQ_FILE_H
+
+#include <linux/fs.h>
+
+struct seq_file {
+	FILE *out;
+	int (*show)(struct seq_file *s, void *v);
+	void *private;
+};
+
+#define seq_printf(s, fmt, ...)	fprintf((s)->out, fmt, ##__VA_ARGS__)
+#define seq_puts(s, str)	fputs(str, (s)->out)
+#define seq_putc(s, c)		fputc(c, (s)->out)
+
+int single_open(struct file *file, int (*show)(struct seq_file *, void *),
+		void *data);
+int single_release(struct inode *inode, struct file *file);
+ssize_t seq_read(struct file *file, char __user *buf, size_t count,
+		 loff_t *ppos);
+loff_t seq_lseek(struct file *file, loff_t offset, int whence);
+
+#endif /* _SIM_LINUX_SEQ_FILE_H */
@@ -0,0 +1,16 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+#ifndef _SIM_LINUX_SLAB_H
+#define _SIM_LINUX_SLAB_H
+
+#include <linux/kernel.h>
+
+#define GFP_KERNEL	0
+
+#define kzalloc(size, gfp)	calloc(1, size)
+#define kfree(p)		free(p)
+
+#endif /* _SIM_LINUX_SLAB_H */
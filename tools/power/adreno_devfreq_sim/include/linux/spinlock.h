@@ -0,0 +1,19 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+#ifndef _SIM_LINUX_SPINLOCK_H
+#define _SIM_LINUX_SPINLOCK_H
+
+#include <linux/kernel.h>
+
+typedef struct {
+	int locked;
+} spinlock_t;
+
+#define DEFINE_SPINLOCK(x)	spinlock_t x = { 0 }
+#define spin_lock(l)		((l)->locked = 1)
+#define spin_unlock(l)		((l)->locked = 0)
+
+#endif /* _SIM_LINUX_SPINLOCK_H */
@@ -0,0 +1,22 @@
+/*
+ * Secure monitor calls land in the stand-in for the TrustZone DCVS
+ * algorithm in sim_kernel.c.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+#ifndef _SIM_MACH_SCM_H
+#define _SIM_MACH_SCM_H
+
+#include <linux/kernel.h>
+
+#define SCM_SVC_IO			0x5
+#define SCM_SVC_DCVS			0xD
+
+int scm_call(u32 svc_id, u32 cmd_id, const void *cmd_buf, size_t cmd_len,
+	     void *resp_buf, size_t resp_len);
+s32 scm_call_atomic2(u32 svc, u32 cmd, u32 arg1, u32 arg2);
+s32 scm_call_atomic3(u32 svc, u32 cmd, u32 arg1, u32 arg2, u32 arg3);
+
+#endif /* _SIM_MACH_SCM_H */
@@ -0,0 +1,21 @@
+/*
+ * Interface between the simulator and its stand-in for the devfreq core
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+#ifndef _SIM_H
+#define _SIM_H
+
+#include <linux/devfreq.h>
+
+struct devfreq_governor *sim_find_governor(const char *name);
+void sim_list_governors(FILE *f);
+
+int sim_set_param(const char *name, const char *value);
+
+int sim_notify(unsigned long type, void *data);
+void sim_dump_debugfs(FILE *f);
+
+#endif /* _SIM_H */
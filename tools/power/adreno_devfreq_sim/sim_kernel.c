@@ -0,0 +1,440 @@
+/*
+ * The kernel services the devfreq governors call, for running them against
+ * a trace in user space: the devfreq core entry points, the kgsl notifier
+ * chain, module parameters, the sysfs and debugfs files of the governors
+ * and a stand-in for the DCVS algorithm in TrustZone.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/devfreq.h>
+#include <linux/msm_adreno_devfreq.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <mach/scm.h>
+#include "governor.h"
+#include "sim.h"
+
+#define MAX_GOVERNORS	8
+#define MAX_PARAMS	16
+#define MAX_GROUPS	8
+#define MAX_DENTRIES	16
+
+static struct devfreq_governor *governors[MAX_GOVERNORS];
+static int num_governors;
+
+static struct {
+	const char *name;
+	int *value;
+} params[MAX_PARAMS];
+static int num_params;
+
+static struct attribute_group groups[MAX_GROUPS];
+static int num_groups;
+
+struct dentry {
+	const char *name;
+	struct dentry *parent;
+	const struct file_operations *fops;
+	void *data;
+	bool used;
+};
+
+static struct dentry dentries[MAX_DENTRIES];
+
+/* the kgsl device has a single srcu notifier chain */
+static struct notifier_block *kgsl_nh;
+
+/*
+ * The TrustZone DCVS algorithm is not available outside the secure world.
+ * Its stand-in moves one level up when the bin was busier than tz_model_up
+ * percent and one level down when it was less busy than tz_model_down.
+ */
+static int tz_model_up = 80;
+module_param_named(tz_model_up, tz_model_up, int, 0664);
+static int tz_model_down = 50;
+module_param_named(tz_model_down, tz_model_down, int, 0664);
+
+static unsigned int tz_model_levels;
+
+#define TZ_RESET_ID		0x3
+#define TZ_UPDATE_ID		0x4
+#define TZ_INIT_ID		0x6
+
+int scm_call(u32 svc_id, u32 cmd_id, const void *cmd_buf, size_t cmd_len,
+	     void *resp_buf, size_t resp_len)
+{
+	const unsigned int *pwrlevels = cmd_buf;
+
+	if (svc_id != SCM_SVC_DCVS || cmd_id != TZ_INIT_ID)
+		return -EINVAL;
+
+	tz_model_levels = pwrlevels[0];
+	return 0;
+}
+
+s32 scm_call_atomic2(u32 svc, u32 cmd, u32 arg1, u32 arg2)
+{
+	return (svc == SCM_SVC_IO && cmd == TZ_RESET_ID) ? 0 : -EINVAL;
+}
+
+s32 scm_call_atomic3(u32 svc, u32 cmd, u32 level, u32 total_time,
+		     u32 busy_time)
+{
+	unsigned int load;
+
+	if (svc != SCM_SVC_IO || cmd != TZ_UPDATE_ID || !total_time)
+		return 0;
+
+	load = (u64)busy_time * 100 / total_time;
+	if (load > tz_model_up && level > 0)
+		return -1;
+	if (load < tz_model_down && level + 1 < tz_model_levels)
+		return 1;
+	return 0;
+}
+
+void sim_register_param(const char *name, int *value)
+{
+	BUG_ON(num_params == MAX_PARAMS);
+	params[num_params].name = name;
+	params[num_params].value = value;
+	num_params++;
+}
+
+/*
+ * Sets a module parameter, or a sysfs file of the running governor when
+ * name is "group/file".
+ */
+int sim_set_param(const char *name, const char *value)
+{
+	const char *slash = strchr(name, '/');
+	struct kobj_attribute *kattr;
+	struct attribute **attr;
+	int i;
+
+	if (slash == NULL) {
+		for (i = 0; i < num_params; i++)
+			if (!strcmp(params[i].name, name)) {
+				*params[i].value = strtol(value, NULL, 0);
+				return 0;
+			}
+		return -ENOENT;
+	}
+
+	for (i = 0; i < num_groups; i++) {
+		if (strncmp(groups[i].name, name, slash - name) ||
+		    groups[i].name[slash - name])
+			continue;
+		for (attr = groups[i].attrs; *attr; attr++) {
+			if (strcmp((*attr)->name, slash + 1))
+				continue;
+			kattr = container_of(*attr, struct kobj_attribute,
+					     attr);
+			if (kattr->store == NULL)
+				return -EPERM;
+			if (kattr->store(NULL, kattr, value, strlen(value)) < 0)
+				return -EINVAL;
+			return 0;
+		}
+	}
+	return -ENOENT;
+}
+
+struct devfreq_governor *sim_find_governor(const char *name)
+{
+	int i;
+
+	for (i = 0; i < num_governors; i++)
+		if (!strcmp(governors[i]->name, name))
+			return governors[i];
+	return NULL;
+}
+
+void sim_list_governors(FILE *f)
+{
+	int i;
+
+	for (i = 0; i < num_governors; i++)
+		fprintf(f, " %s", governors[i]->name);
+	fprintf(f, "\n");
+}
+
+/*
+ * Runs the notifier chain as do_devfreq_notify() does, or returns -ENOENT
+ * if the governor did not register on it.
+ */
+int sim_notify(unsigned long type, void *data)
+{
+	struct notifier_block *nb;
+	int ret = 0;
+
+	if (kgsl_nh == NULL)
+		return -ENOENT;
+
+	for (nb = kgsl_nh; nb; nb = nb->next) {
+		ret = nb->notifier_call(nb, type, data);
+		if (ret & NOTIFY_STOP_MASK)
+			break;
+	}
+	return notifier_to_errno(ret);
+}
+
+int kgsl_devfreq_add_notifier(struct device *dev, struct notifier_block *nb)
+{
+	if (nb == NULL)
+		return -EINVAL;
+
+	nb->next = kgsl_nh;
+	kgsl_nh = nb;
+	return 0;
+}
+
+int kgsl_devfreq_del_notifier(struct device *dev, struct notifier_block *nb)
+{
+	struct notifier_block **p;
+
+	for (p = &kgsl_nh; *p; p = &(*p)->next)
+		if (*p == nb) {
+			*p = nb->next;
+			return 0;
+		}
+	return -ENOENT;
+}
+
+int devfreq_add_governor(struct devfreq_governor *governor)
+{
+	if (num_governors == MAX_GOVERNORS)
+		return -ENOMEM;
+
+	governors[num_governors++] = governor;
+	return 0;
+}
+
+int devfreq_remove_governor(struct devfreq_governor *governor)
+{
+	return 0;
+}
+
+/* As in devfreq.c */
+int devfreq_get_freq_level(struct devfreq *devfreq, unsigned long freq)
+{
+	int lev;
+	unsigned int *freq_table = devfreq->profile->freq_table;
+
+	if (devfreq->state == KGSL_STATE_SLUMBER)
+		return sizeof(freq_table);
+
+	for (lev = 0; lev < devfreq->profile->max_state; lev++)
+		if (freq == freq_table[lev])
+			return lev;
+
+	return -EINVAL;
+}
+
+/* As in devfreq.c, without the transition statistics */
+int update_devfreq(struct devfreq *devfreq)
+{
+	unsigned long freq;
+	int err = 0;
+	u32 flags = 0;
+
+	if (!mutex_is_locked(&devfreq->lock)) {
+		WARN(true, "devfreq->lock must be locked by the caller.\n");
+		return -EINVAL;
+	}
+
+	if (!devfreq->governor)
+		return -EINVAL;
+
+	err = devfreq->governor->get_target_freq(devfreq, &freq, &flags);
+	if (err)
+		return err;
+
+	if (devfreq->min_freq && freq < devfreq->min_freq) {
+		freq = devfreq->min_freq;
+		flags &= ~DEVFREQ_FLAG_LEAST_UPPER_BOUND;
+	}
+	if (devfreq->max_freq && freq > devfreq->max_freq) {
+		freq = devfreq->max_freq;
+		flags |= DEVFREQ_FLAG_LEAST_UPPER_BOUND;
+	}
+
+	err = devfreq->profile->target(devfreq->dev.parent, &freq, flags);
+	if (err)
+		return err;
+
+	devfreq->previous_freq = freq;
+	return 0;
+}
+
+/* The simulator polls every governor once per sample */
+void devfreq_monitor_start(struct devfreq *devfreq)
+{
+}
+
+void devfreq_monitor_stop(struct devfreq *devfreq)
+{
+}
+
+void devfreq_monitor_suspend(struct devfreq *devfreq)
+{
+}
+
+void devfreq_monitor_resume(struct devfreq *devfreq)
+{
+}
+
+void devfreq_interval_update(struct devfreq *devfreq, unsigned int *delay)
+{
+}
+
+int devfreq_policy_add_files(struct devfreq *devfreq,
+			     struct attribute_group attr_group)
+{
+	if (num_groups == MAX_GROUPS)
+		return -ENOMEM;
+
+	groups[num_groups++] = attr_group;
+	return 0;
+}
+
+void devfreq_policy_remove_files(struct devfreq *devfreq,
+				 struct attribute_group attr_group)
+{
+	int i;
+
+	for (i = 0; i < num_groups; i++)
+		if (groups[i].attrs == attr_group.attrs) {
+			groups[i] = groups[--num_groups];
+			return;
+		}
+}
+
+static struct dentry *debugfs_create(const char *name, struct dentry *parent,
+				     void *data,
+				     const struct file_operations *fops)
+{
+	int i;
+
+	for (i = 0; i < MAX_DENTRIES; i++)
+		if (!dentries[i].used) {
+			dentries[i].name = name;
+			dentries[i].parent = parent;
+			dentries[i].fops = fops;
+			dentries[i].data = data;
+			dentries[i].used = true;
+			return &dentries[i];
+		}
+	return NULL;
+}
+
+struct dentry *debugfs_create_dir(const char *name, struct dentry *parent)
+{
+	return debugfs_create(name, parent, NULL, NULL);
+}
+
+struct dentry *debugfs_create_file(const char *name, unsigned short mode,
+				   struct dentry *parent, void *data,
+				   const struct file_operations *fops)
+{
+	return debugfs_create(name, parent, data, fops);
+}
+
+void debugfs_remove(struct dentry *dentry)
+{
+	if (dentry)
+		dentry->used = false;
+}
+
+void debugfs_remove_recursive(struct dentry *dentry)
+{
+	int i;
+
+	if (dentry == NULL)
+		return;
+
+	for (i = 0; i < MAX_DENTRIES; i++)
+		if (dentries[i].used && dentries[i].parent == dentry)
+			debugfs_remove_recursive(&dentries[i]);
+	debugfs_remove(dentry);
+}
+
+static void debugfs_path(FILE *f, struct dentry *dentry)
+{
+	if (dentry->parent) {
+		debugfs_path(f, dentry->parent);
+		fputc('/', f);
+	}
+	fputs(dentry->name, f);
+}
+
+/*
+ * Prints every debugfs file with a seq_file show method, as reading it
+ * from user space would.
+ */
+void sim_dump_debugfs(FILE *f)
+{
+	struct inode inode;
+	struct file file;
+	struct seq_file *s;
+	int i;
+
+	for (i = 0; i < MAX_DENTRIES; i++) {
+		if (!dentries[i].used || dentries[i].fops == NULL ||
+		    dentries[i].fops->open == NULL)
+			continue;
+
+		inode.i_private = dentries[i].data;
+		file.private_data = NULL;
+		if (dentries[i].fops->open(&inode, &file))
+			continue;
+
+		s = file.private_data;
+		fprintf(f, "debugfs ");
+		debugfs_path(f, &dentries[i]);
+		fputc('\n', f);
+		s->out = f;
+		s->show(s, NULL);
+
+		if (dentries[i].fops->release)
+			dentries[i].fops->release(&inode, &file);
+	}
+}
+
+int single_open(struct file *file, int (*show)(struct seq_file *, void *),
+		void *data)
+{
+	struct seq_file *s = calloc(1, sizeof(*s));
+
+	if (s == NULL)
+		return -ENOMEM;
+
+	s->out = stdout;
+	s->show = show;
+	s->private = data;
+	file->private_data = s;
+	return 0;
+}
+
+int single_release(struct inode *inode, struct file *file)
+{
+	free(file->private_data);
+	return 0;
+}
+
+/* The simulator calls the show method directly */
+ssize_t seq_read(struct file *file, char __user *buf, size_t count,
+		 loff_t *ppos)
+{
+	return -EINVAL;
+}
+
+loff_t seq_lseek(struct file *file, loff_t offset, int whence)
+{
+	return -EINVAL;
+}
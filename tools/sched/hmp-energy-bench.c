@@ -0,0 +1,335 @@
+/*
+ * hmp-energy-bench: synthetic workload for HMP task placement policies
+ *
+ * Runs a mix of small periodic tasks (run for a few hundred microseconds
+ * every frame) and heavy cpu-bound tasks, and reports the work done per
+ * second and per unit of an energy proxy. The proxy charges every cpu for
+ * its busy time, weighted by (freq / max_freq)^alpha averaged over the
+ * cpufreq time_in_state residency, which is rough but monotonic in the
+ * things placement can influence: how many cpus are woken up and how high
+ * their frequency has to go.
+ *
+ * With -m both the run is repeated with /proc/sys/kernel/sched_energy_aware
+ * set to 0 and to 1, and the setting found on entry is restored.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+#define MAX_CPUS	32
+#define MAX_FREQS	64
+#define ENERGY_SYSCTL	"/proc/sys/kernel/sched_energy_aware"
+
+static int nr_small = 4;
+static int nr_big = 1;
+static unsigned int period_us = 16667;
+static unsigned int small_work = 20000;
+static unsigned int duration = 10;
+static double alpha = 3.0;
+static const char *mode = "cur";
+
+static volatile int stop;
+
+struct worker {
+	pthread_t thread;
+	int big;
+	unsigned long long work;
+	unsigned long missed;
+};
+
+struct cpu_snapshot {
+	unsigned long long busy, total;
+	unsigned int nr_freqs;
+	unsigned int freq[MAX_FREQS];
+	unsigned long long time[MAX_FREQS];
+};
+
+static struct cpu_snapshot before[MAX_CPUS], after[MAX_CPUS];
+static int nr_cpus;
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-s small] [-b big] [-p period_us] [-w work]\n"
+		"          [-t seconds] [-a alpha] [-m cur|both]\n"
+		"  -s  number of small periodic tasks (default %d)\n"
+		"  -b  number of cpu-bound tasks (default %d)\n"
+		"  -p  small task period in us (default %u)\n"
+		"  -w  loop iterations per small task period (default %u)\n"
+		"  -t  run time per mode in seconds (default %u)\n"
+		"  -a  exponent of the frequency in the power proxy (default %.1f)\n"
+		"  -m  'cur' runs once, 'both' compares sched_energy_aware 0 and 1\n",
+		prog, nr_small, nr_big, period_us, small_work, duration, alpha);
+	exit(1);
+}
+
+static inline unsigned long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static unsigned long long spin(unsigned int iterations)
+{
+	volatile unsigned long long acc = 0;
+	unsigned int i;
+
+	for (i = 0; i < iterations; i++)
+		acc += i ^ (acc >> 3);
+	return iterations;
+}
+
+static void *worker_fn(void *arg)
+{
+	struct worker *w = arg;
+	unsigned long long next = now_ns();
+	struct timespec ts;
+
+	while (!stop) {
+		if (w->big) {
+			w->work += spin(10000);
+			continue;
+		}
+
+		w->work += spin(small_work);
+		next += period_us * 1000ULL;
+		if (now_ns() > next) {
+			w->missed++;
+			next = now_ns();
+			continue;
+		}
+		ts.tv_sec = next / 1000000000ULL;
+		ts.tv_nsec = next % 1000000000ULL;
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+	}
+
+	return NULL;
+}
+
+static void read_stat(struct cpu_snapshot *snap)
+{
+	unsigned long long v[8];
+	char line[256];
+	FILE *f;
+	int cpu, i;
+
+	f = fopen("/proc/stat", "r");
+	if (!f) {
+		perror("/proc/stat");
+		exit(1);
+	}
+
+	while (fgets(line, sizeof(line), f)) {
+		if (strncmp(line, "cpu", 3) || line[3] == ' ')
+			continue;
+		if (sscanf(line, "cpu%d %llu %llu %llu %llu %llu %llu %llu %llu",
+			   &cpu, &v[0], &v[1], &v[2], &v[3], &v[4], &v[5],
+			   &v[6], &v[7]) != 9 || cpu >= MAX_CPUS)
+			continue;
+		snap[cpu].total = 0;
+		for (i = 0; i < 8; i++)
+			snap[cpu].total += v[i];
+		/* idle and iowait */
+		snap[cpu].busy = snap[cpu].total - v[3] - v[4];
+		if (cpu >= nr_cpus)
+			nr_cpus = cpu + 1;
+	}
+	fclose(f);
+}
+
+static void read_time_in_state(struct cpu_snapshot *snap, int cpu)
+{
+	char path[128];
+	FILE *f;
+
+	snap->nr_freqs = 0;
+	snprintf(path, sizeof(path),
+		 "/sys/devices/system/cpu/cpu%d/cpufreq/stats/time_in_state",
+		 cpu);
+	f = fopen(path, "r");
+	if (!f)
+		return;
+	while (snap->nr_freqs < MAX_FREQS &&
+	       fscanf(f, "%u %llu", &snap->freq[snap->nr_freqs],
+		      &snap->time[snap->nr_freqs]) == 2)
+		snap->nr_freqs++;
+	fclose(f);
+}
+
+static void snapshot(struct cpu_snapshot *snap)
+{
+	int cpu;
+
+	read_stat(snap);
+	for (cpu = 0; cpu < nr_cpus; cpu++)
+		read_time_in_state(&snap[cpu], cpu);
+}
+
+/* mean of (f / fmax)^alpha over the residency between the snapshots */
+static double freq_weight(const struct cpu_snapshot *a,
+			  const struct cpu_snapshot *b)
+{
+	unsigned long long t, sum_t = 0;
+	unsigned int i, fmax = 0;
+	double sum = 0;
+
+	if (!a->nr_freqs || a->nr_freqs != b->nr_freqs)
+		return 1.0;
+
+	for (i = 0; i < b->nr_freqs; i++)
+		if (b->freq[i] > fmax)
+			fmax = b->freq[i];
+
+	for (i = 0; i < b->nr_freqs; i++) {
+		t = b->time[i] - a->time[i];
+		sum += t * pow((double)b->freq[i] / fmax, alpha);
+		sum_t += t;
+	}
+
+	return sum_t ? sum / sum_t : 1.0;
+}
+
+static int read_sysctl(void)
+{
+	FILE *f = fopen(ENERGY_SYSCTL, "r");
+	int val = -1;
+
+	if (f) {
+		if (fscanf(f, "%d", &val) != 1)
+			val = -1;
+		fclose(f);
+	}
+	return val;
+}
+
+static int write_sysctl(int val)
+{
+	FILE *f = fopen(ENERGY_SYSCTL, "w");
+
+	if (!f)
+		return -errno;
+	fprintf(f, "%d\n", val);
+	return fclose(f) ? -errno : 0;
+}
+
+static void run(const char *label)
+{
+	struct worker *workers;
+	unsigned long long work_small = 0, work_big = 0;
+	unsigned long missed = 0;
+	double proxy = 0, busy_s, tick = sysconf(_SC_CLK_TCK);
+	int i, n = nr_small + nr_big, cpu;
+
+	workers = calloc(n, sizeof(*workers));
+	if (!workers) {
+		perror("calloc");
+		exit(1);
+	}
+
+	stop = 0;
+	snapshot(before);
+	for (i = 0; i < n; i++) {
+		workers[i].big = i >= nr_small;
+		if (pthread_create(&workers[i].thread, NULL, worker_fn,
+				   &workers[i])) {
+			perror("pthread_create");
+			exit(1);
+		}
+	}
+
+	sleep(duration);
+	stop = 1;
+	for (i = 0; i < n; i++)
+		pthread_join(workers[i].thread, NULL);
+	snapshot(after);
+
+	for (i = 0; i < n; i++) {
+		if (workers[i].big)
+			work_big += workers[i].work;
+		else
+			work_small += workers[i].work;
+		missed += workers[i].missed;
+	}
+
+	for (cpu = 0; cpu < nr_cpus; cpu++) {
+		busy_s = (after[cpu].busy - before[cpu].busy) / tick;
+		proxy += busy_s * freq_weight(&before[cpu], &after[cpu]);
+	}
+
+	printf("%-8s small %8.1f Mit/s (%lu missed), big %8.1f Mit/s, "
+	       "energy proxy %7.2f, work/proxy %8.1f Mit\n",
+	       label, work_small / 1e6 / duration, missed,
+	       work_big / 1e6 / duration, proxy,
+	       proxy > 0 ? (work_small + work_big) / 1e6 / proxy : 0.0);
+	free(workers);
+}
+
+int main(int argc, char **argv)
+{
+	int opt, saved;
+
+	while ((opt = getopt(argc, argv, "s:b:p:w:t:a:m:h")) != -1) {
+		switch (opt) {
+		case 's':
+			nr_small = atoi(optarg);
+			break;
+		case 'b':
+			nr_big = atoi(optarg);
+			break;
+		case 'p':
+			period_us = strtoul(optarg, NULL, 0);
+			break;
+		case 'w':
+			small_work = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			duration = strtoul(optarg, NULL, 0);
+			break;
+		case 'a':
+			alpha = atof(optarg);
+			break;
+		case 'm':
+			mode = optarg;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	if (nr_small < 0 || nr_big < 0 || nr_small + nr_big == 0 ||
+	    !period_us || !duration)
+		usage(argv[0]);
+
+	if (strcmp(mode, "both")) {
+		run("current");
+		return 0;
+	}
+
+	saved = read_sysctl();
+	if (saved < 0) {
+		fprintf(stderr, "%s not available\n", ENERGY_SYSCTL);
+		return 1;
+	}
+	if (write_sysctl(0)) {
+		perror(ENERGY_SYSCTL);
+		return 1;
+	}
+	run("default");
+	write_sysctl(1);
+	run("energy");
+	write_sysctl(saved);
+
+	return 0;
+}
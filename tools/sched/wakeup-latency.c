@@ -0,0 +1,303 @@
+/*
+ * wakeup-latency: cyclictest-like wakeup latency benchmark
+ *
+ * A number of measurement threads sleep until an absolute deadline every
+ * interval and record how late they actually got to run, while background
+ * threads keep every cpu busy with cfs load. The measurement and background
+ * threads can be given different latency nice values through
+ * sched_setattr(SCHED_FLAG_LATENCY_NICE), so the effect of the hint on both
+ * the wakeup latency of the former and the throughput of the latter can be
+ * compared across runs.
+ *
+ * Unlike cyclictest the measurement threads are plain SCHED_OTHER tasks by
+ * default, as the point is what cfs does with them.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+#ifndef __NR_sched_setattr
+#if defined(__arm__)
+#define __NR_sched_setattr	380
+#elif defined(__aarch64__)
+#define __NR_sched_setattr	274
+#elif defined(__x86_64__)
+#define __NR_sched_setattr	314
+#elif defined(__i386__)
+#define __NR_sched_setattr	351
+#else
+#error "__NR_sched_setattr unknown for this architecture"
+#endif
+#endif
+
+#define SCHED_FLAG_LATENCY_NICE	0x04
+#define NO_LATENCY_NICE		100
+
+#define HIST_US			10000	/* 1us buckets, then one overflow */
+
+struct sched_attr {
+	uint32_t size;
+	uint32_t sched_policy;
+	uint64_t sched_flags;
+	int32_t sched_nice;
+	uint32_t sched_priority;
+	uint64_t sched_runtime;
+	uint64_t sched_deadline;
+	uint64_t sched_period;
+	int32_t sched_latency_nice;
+};
+
+static int nr_threads = 1;
+static int nr_hogs = -1;
+static unsigned int interval_us = 1000;
+static unsigned int duration = 10;
+static int latency_nice = NO_LATENCY_NICE;
+static int hog_latency_nice = NO_LATENCY_NICE;
+static int print_hist;
+
+static volatile int stop;
+
+struct sampler {
+	pthread_t thread;
+	unsigned long long min, max, sum, nr;
+	unsigned long hist[HIST_US + 1];
+};
+
+struct hog {
+	pthread_t thread;
+	unsigned long long loops;
+};
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-t threads] [-i interval_us] [-D seconds]\n"
+		"          [-n latency_nice] [-b hogs] [-B latency_nice] [-h]\n"
+		"  -t  number of measurement threads (default %d)\n"
+		"  -i  wakeup interval in us (default %u)\n"
+		"  -D  run time in seconds (default %u)\n"
+		"  -n  latency nice of the measurement threads (default: unset)\n"
+		"  -b  number of cpu-bound background threads (default: ncpus)\n"
+		"  -B  latency nice of the background threads (default: unset)\n"
+		"  -h  print the latency histogram\n",
+		prog, nr_threads, interval_us, duration);
+	exit(1);
+}
+
+static int set_latency_nice(int value)
+{
+	struct sched_attr attr;
+
+	if (value == NO_LATENCY_NICE)
+		return 0;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.sched_policy = 0;	/* SCHED_OTHER */
+	attr.sched_flags = SCHED_FLAG_LATENCY_NICE;
+	attr.sched_latency_nice = value;
+
+	if (syscall(__NR_sched_setattr, 0, &attr, 0)) {
+		fprintf(stderr, "sched_setattr(latency_nice=%d): %s\n",
+			value, strerror(errno));
+		return -1;
+	}
+	return 0;
+}
+
+static inline unsigned long long ts_ns(const struct timespec *ts)
+{
+	return ts->tv_sec * 1000000000ULL + ts->tv_nsec;
+}
+
+static void *sampler_fn(void *arg)
+{
+	struct sampler *s = arg;
+	struct timespec next, now;
+	unsigned long long lat;
+
+	if (set_latency_nice(latency_nice))
+		exit(1);
+
+	s->min = ~0ULL;
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	while (!stop) {
+		next.tv_nsec += interval_us * 1000;
+		while (next.tv_nsec >= 1000000000) {
+			next.tv_nsec -= 1000000000;
+			next.tv_sec++;
+		}
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+		clock_gettime(CLOCK_MONOTONIC, &now);
+
+		lat = ts_ns(&now) - ts_ns(&next);
+		if (lat < s->min)
+			s->min = lat;
+		if (lat > s->max)
+			s->max = lat;
+		s->sum += lat;
+		s->nr++;
+		lat /= 1000;
+		s->hist[lat < HIST_US ? lat : HIST_US]++;
+	}
+	return NULL;
+}
+
+static void *hog_fn(void *arg)
+{
+	struct hog *h = arg;
+	volatile unsigned int x = 0;
+	unsigned int i;
+
+	if (set_latency_nice(hog_latency_nice))
+		exit(1);
+
+	while (!stop) {
+		for (i = 0; i < 10000; i++)
+			x += i;
+		h->loops++;
+	}
+	return NULL;
+}
+
+static unsigned long long percentile(const unsigned long *hist,
+				     unsigned long long nr, double pct)
+{
+	unsigned long long want = nr * pct / 100.0, seen = 0;
+	int i;
+
+	for (i = 0; i <= HIST_US; i++) {
+		seen += hist[i];
+		if (seen > want)
+			return i;
+	}
+	return HIST_US;
+}
+
+int main(int argc, char **argv)
+{
+	static unsigned long hist[HIST_US + 1];
+	struct sampler *samplers;
+	struct hog *hogs;
+	unsigned long long nr = 0, sum = 0, max = 0, min = ~0ULL;
+	unsigned long long loops = 0;
+	int opt, i;
+
+	while ((opt = getopt(argc, argv, "t:i:D:n:b:B:h")) != -1) {
+		switch (opt) {
+		case 't':
+			nr_threads = atoi(optarg);
+			break;
+		case 'i':
+			interval_us = strtoul(optarg, NULL, 0);
+			break;
+		case 'D':
+			duration = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			latency_nice = atoi(optarg);
+			break;
+		case 'b':
+			nr_hogs = atoi(optarg);
+			break;
+		case 'B':
+			hog_latency_nice = atoi(optarg);
+			break;
+		case 'h':
+			print_hist = 1;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (nr_threads < 1 || !interval_us || !duration)
+		usage(argv[0]);
+	if (nr_hogs < 0)
+		nr_hogs = sysconf(_SC_NPROCESSORS_ONLN);
+
+	samplers = calloc(nr_threads, sizeof(*samplers));
+	hogs = calloc(nr_hogs ? nr_hogs : 1, sizeof(*hogs));
+	if (!samplers || !hogs) {
+		perror("calloc");
+		return 1;
+	}
+
+	for (i = 0; i < nr_hogs; i++)
+		if (pthread_create(&hogs[i].thread, NULL, hog_fn, &hogs[i])) {
+			perror("pthread_create");
+			return 1;
+		}
+	for (i = 0; i < nr_threads; i++)
+		if (pthread_create(&samplers[i].thread, NULL, sampler_fn,
+				   &samplers[i])) {
+			perror("pthread_create");
+			return 1;
+		}
+
+	sleep(duration);
+	stop = 1;
+
+	for (i = 0; i < nr_hogs; i++) {
+		pthread_join(hogs[i].thread, NULL);
+		loops += hogs[i].loops;
+	}
+
+	for (i = 0; i < nr_threads; i++) {
+		struct sampler *s = &samplers[i];
+		int b;
+
+		pthread_join(s->thread, NULL);
+		if (!s->nr)
+			continue;
+		printf("T:%2d samples %8llu  min %7llu  avg %7llu  max %7llu us\n",
+		       i, s->nr, s->min / 1000, s->sum / s->nr / 1000,
+		       s->max / 1000);
+
+		nr += s->nr;
+		sum += s->sum;
+		if (s->min < min)
+			min = s->min;
+		if (s->max > max)
+			max = s->max;
+		for (b = 0; b <= HIST_US; b++)
+			hist[b] += s->hist[b];
+	}
+
+	if (!nr) {
+		fprintf(stderr, "no samples\n");
+		return 1;
+	}
+
+	printf("all  samples %8llu  min %7llu  avg %7llu  max %7llu us\n",
+	       nr, min / 1000, sum / nr / 1000, max / 1000);
+	printf("     p50 %llu  p90 %llu  p99 %llu  p99.9 %llu us%s\n",
+	       percentile(hist, nr, 50), percentile(hist, nr, 90),
+	       percentile(hist, nr, 99), percentile(hist, nr, 99.9),
+	       hist[HIST_US] ? "  (some samples overflowed)" : "");
+	if (nr_hogs)
+		printf("background throughput: %.1f Mloops/s\n",
+		       loops / (double)duration / 1e6);
+
+	if (print_hist) {
+		for (i = 0; i < HIST_US; i++)
+			if (hist[i])
+				printf("%06d %lu\n", i, hist[i]);
+		if (hist[HIST_US])
+			printf(">%05d %lu\n", HIST_US, hist[HIST_US]);
+	}
+
+	free(samplers);
+	free(hogs);
+	return 0;
+}
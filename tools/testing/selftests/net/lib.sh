@@ -0,0 +1,63 @@
+# Common setup of the net selftests, sourced after setting TEST to the name
+# of the test:
+#
+#   skip <reason>		print why the test cannot run and exit 0
+#   require_root		skip unless run as root
+#   require_tools <tool>...	skip unless every tool is in PATH
+#   netns_add <ns>...		(re)create network namespaces
+#   veth_add <ns> <dev> <addr> <peer ns> <peer dev> <peer addr>
+#				join two namespaces with a veth pair and bring
+#				it up; an empty address is left unset
+#
+# On exit the background $SINK is killed, the namespaces made by netns_add
+# are deleted and then test_cleanup is run, if the test defines one.
+
+NETNS_LIST=
+
+skip()
+{
+	echo "$TEST: $*, skipping"
+	exit 0
+}
+
+require_root()
+{
+	[ "$(id -u)" = "0" ] || skip "must be run as root"
+}
+
+require_tools()
+{
+	for tool in "$@"; do
+		command -v $tool >/dev/null 2>&1 || skip "$tool not found"
+	done
+}
+
+netns_add()
+{
+	for ns in "$@"; do
+		ip netns del $ns 2>/dev/null
+		ip netns add $ns || exit 1
+		NETNS_LIST="$NETNS_LIST $ns"
+	done
+}
+
+veth_add()
+{
+	ip link add $2 netns $1 type veth peer name $5 netns $4 || exit 1
+	[ -z "$3" ] || ip -n $1 addr add $3 dev $2
+	[ -z "$6" ] || ip -n $4 addr add $6 dev $5
+	ip -n $1 link set $2 up
+	ip -n $4 link set $5 up
+}
+
+lib_cleanup()
+{
+	[ -n "$SINK" ] && kill $SINK 2>/dev/null
+	for ns in $NETNS_LIST; do
+		ip netns del $ns 2>/dev/null
+	done
+	if type test_cleanup >/dev/null 2>&1; then
+		test_cleanup
+	fi
+}
+trap lib_cleanup EXIT
@@ -0,0 +1,257 @@
+/*
+ * msg_zerocopy: bulk TCP/UDP sender with optional MSG_ZEROCOPY
+ *
+ *   msg_zerocopy [-u] -l port       sink: accept (TCP) or bind (UDP) and
+ *                                   discard data
+ *   msg_zerocopy [-u] [-z] [-s size] -c addr port seconds
+ *                                   send size byte messages as fast as
+ *                                   possible for seconds, with -z using
+ *                                   MSG_ZEROCOPY and reaping completions
+ *                                   from the error queue, then print
+ *                                   "bytes sends completions copied"
+ *
+ * completions counts the send calls reported done on the error queue,
+ * copied those of them whose data had to be copied after all.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY	60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY	0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY		5
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED	1
+#endif
+
+static char buf[64 * 1024];
+
+static int udp;
+static unsigned long long completions, copied;
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-u] -l port\n"
+			"       %s [-u] [-z] [-s size] -c addr port seconds\n",
+		prog, prog);
+	exit(1);
+}
+
+static int sink(int port)
+{
+	struct sockaddr_in addr;
+	int fd, one = 1;
+
+	fd = socket(AF_INET, udp ? SOCK_DGRAM : SOCK_STREAM, 0);
+	if (fd < 0) {
+		perror("socket");
+		return 1;
+	}
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) ||
+	    (!udp && listen(fd, 16))) {
+		perror("bind/listen");
+		return 1;
+	}
+
+	if (udp) {
+		while (recv(fd, buf, sizeof(buf), 0) >= 0 || errno == EINTR)
+			;
+		perror("recv");
+		return 1;
+	}
+
+	signal(SIGCHLD, SIG_IGN);
+	for (;;) {
+		int c = accept(fd, NULL, NULL);
+
+		if (c < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("accept");
+			return 1;
+		}
+		if (!fork()) {
+			while (read(c, buf, sizeof(buf)) > 0)
+				;
+			_exit(0);
+		}
+		close(c);
+	}
+}
+
+/*
+ * Reads zero-copy notifications off the error queue until it is empty,
+ * first waiting up to a second for one to arrive if block is set.
+ * Returns the number of notifications read.
+ */
+static int reap(int fd, int block)
+{
+	struct sock_extended_err *serr;
+	struct msghdr msg;
+	struct cmsghdr *cm;
+	char control[128];
+	int n = 0;
+
+	if (block) {
+		struct pollfd pfd = { .fd = fd, .events = 0 };
+
+		if (poll(&pfd, 1, 1000) < 0) {
+			perror("poll");
+			exit(1);
+		}
+	}
+
+	for (;;) {
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+
+		if (recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+			if (errno == EAGAIN)
+				return n;
+			perror("recvmsg MSG_ERRQUEUE");
+			exit(1);
+		}
+		cm = CMSG_FIRSTHDR(&msg);
+		if (!cm || cm->cmsg_level != SOL_IP ||
+		    cm->cmsg_type != IP_RECVERR) {
+			fprintf(stderr, "unexpected error queue message\n");
+			exit(1);
+		}
+		serr = (struct sock_extended_err *)CMSG_DATA(cm);
+		if (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY || serr->ee_errno) {
+			fprintf(stderr, "error queue: origin %u errno %u\n",
+				serr->ee_origin, serr->ee_errno);
+			exit(1);
+		}
+		/* ids ee_info..ee_data, inclusive */
+		completions += serr->ee_data - serr->ee_info + 1;
+		if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+			copied += serr->ee_data - serr->ee_info + 1;
+		n++;
+	}
+}
+
+static int source(const char *host, int port, int seconds, int size,
+		  int zerocopy)
+{
+	struct sockaddr_in addr;
+	unsigned long long sent = 0, sends = 0;
+	int flags = zerocopy ? MSG_ZEROCOPY : 0;
+	int fd, one = 1;
+	time_t end;
+	ssize_t n;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	if (inet_pton(AF_INET, host, &addr.sin_addr) != 1)
+		usage("msg_zerocopy");
+
+	fd = socket(AF_INET, udp ? SOCK_DGRAM : SOCK_STREAM, 0);
+	if (fd < 0) {
+		perror("socket");
+		return 1;
+	}
+	if (zerocopy &&
+	    setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one))) {
+		perror("SO_ZEROCOPY");
+		return 1;
+	}
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+		perror("connect");
+		return 1;
+	}
+
+	end = time(NULL) + seconds;
+	while (time(NULL) < end) {
+		n = send(fd, buf, size, flags);
+		if (n < 0) {
+			/* too many notifications pending */
+			if (errno == ENOBUFS && zerocopy) {
+				reap(fd, 1);
+				continue;
+			}
+			/* no UDP listener yet, or a drop on the way */
+			if (udp && (errno == ECONNREFUSED || errno == ENOBUFS))
+				continue;
+			perror("send");
+			return 1;
+		}
+		sent += n;
+		sends++;
+		if (zerocopy && !(sends & 63))
+			reap(fd, 0);
+	}
+
+	/* every successful MSG_ZEROCOPY send gets exactly one completion */
+	while (zerocopy && completions < sends)
+		if (!reap(fd, 1))
+			break;
+
+	close(fd);
+	printf("%llu %llu %llu %llu\n", sent, sends, completions, copied);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	int size = sizeof(buf), zerocopy = 0;
+	const char *prog = argv[0];
+	int c;
+
+	while ((c = getopt(argc, argv, "uzs:lc")) != -1) {
+		switch (c) {
+		case 'u':
+			udp = 1;
+			break;
+		case 'z':
+			zerocopy = 1;
+			break;
+		case 's':
+			size = atoi(optarg);
+			if (size <= 0 || size > (int)sizeof(buf))
+				usage(prog);
+			break;
+		case 'l':
+			if (argc - optind != 1)
+				usage(prog);
+			return sink(atoi(argv[optind]));
+		case 'c':
+			if (argc - optind != 3)
+				usage(prog);
+			return source(argv[optind], atoi(argv[optind + 1]),
+				      atoi(argv[optind + 2]), size, zerocopy);
+		default:
+			usage(prog);
+		}
+	}
+	usage(prog);
+	return 1;
+}
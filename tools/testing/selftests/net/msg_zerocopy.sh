@@ -0,0 +1,106 @@
+#!/bin/sh
+#
+# CPU cost per GB of bulk TCP and UDP sends, with and without MSG_ZEROCOPY.
+#
+# Every combination of path (loopback inside a namespace, a veth pair
+# between two namespaces), protocol and send mode runs for DURATION
+# seconds. The busy time of all cpus over the run is divided by the bytes
+# sent, so the receive side is counted too.
+#
+# Both paths deliver to a local socket, which may keep the data for as long
+# as it likes, so the kernel copies zero-copy frags at delivery and the
+# notifications say so ("copied"). The figures show what pinning pages and
+# reaping completions costs against that; the saving shows on devices that
+# transmit from the user pages directly. The test fails if a zero-copy run
+# does not get exactly one completion per send.
+
+DURATION=${DURATION:-5}
+UDP_SIZE=${UDP_SIZE:-1400}
+PORT=5206
+
+NS_LO=zc_lo
+NS_TX=zc_tx
+NS_RX=zc_rx
+
+TEST=msg_zerocopy
+. "$(dirname "$0")/lib.sh"
+
+require_root
+require_tools ip
+
+netns_add $NS_LO $NS_TX $NS_RX
+ip -n $NS_LO link set lo up
+veth_add $NS_TX veth_tx 10.198.6.1/24 $NS_RX veth_rx 10.198.6.2/24
+
+probe=$(ip netns exec $NS_LO ./msg_zerocopy -z -c 127.0.0.1 9 0 2>&1)
+case "$probe" in
+*SO_ZEROCOPY*)
+	skip "kernel without SO_ZEROCOPY"
+	;;
+esac
+
+# busy: prints the jiffies all cpus spent outside idle and iowait
+busy()
+{
+	awk '/^cpu / { print $2 + $3 + $4 + $7 + $8 + $9 }' /proc/stat
+}
+
+hz=$(getconf CLK_TCK)
+ret=0
+
+# run <path> <tx ns> <rx ns> <addr> <tcp|udp> <copy|zerocopy>
+run()
+{
+	udp_opts=
+	[ $5 = udp ] && udp_opts="-u -s $UDP_SIZE"
+	zc_opt=
+	[ $6 = zerocopy ] && zc_opt=-z
+
+	ip netns exec $3 ./msg_zerocopy $udp_opts -l $PORT &
+	SINK=$!
+	sleep 1
+
+	cpu=$(busy)
+	set -- $1 $5 $6 $(ip netns exec $2 ./msg_zerocopy $udp_opts $zc_opt \
+		-c $4 $PORT $DURATION)
+	cpu=$(( $(busy) - cpu ))
+
+	kill $SINK
+	wait $SINK 2>/dev/null
+	SINK=
+
+	if [ -z "$4" ]; then
+		echo "[FAIL] $1 $2 $3: sender failed"
+		ret=1
+		return
+	fi
+	awk -v b=$4 -v c=$cpu -v t=$DURATION -v hz=$hz \
+	    -v what="$1 $2 $3" 'BEGIN {
+		gb = b / 1000000000
+		printf "%-22s %8.1f MB/s", what, b / t / 1000000
+		if (gb > 0)
+			printf " %9.1f cpu-ms/GB", c * 1000 / hz / gb
+		printf "\n"
+	}'
+	if [ $3 = zerocopy ]; then
+		echo "    $5 sends, $6 completions, $7 copied"
+		if [ "$5" -gt 0 ] && [ "$5" = "$6" ]; then
+			echo "[PASS] $1 $2: one completion per send"
+		else
+			echo "[FAIL] $1 $2: $6 completions for $5 sends"
+			ret=1
+		fi
+	fi
+}
+
+for proto in tcp udp; do
+	for mode in copy zerocopy; do
+		run lo $NS_LO $NS_LO 127.0.0.1 $proto $mode
+	done
+done
+for proto in tcp udp; do
+	for mode in copy zerocopy; do
+		run veth $NS_TX $NS_RX 10.198.6.2 $proto $mode
+	done
+done
+exit $ret
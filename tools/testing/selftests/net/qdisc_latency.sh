@@ -0,0 +1,95 @@
+#!/bin/sh
+#
+# Latency under load through a bottleneck on a veth pair.
+#
+# Two network namespaces are joined by a veth pair. The egress of the
+# sender side is shaped by tbf to a few Mbit/s, with the qdisc under test
+# as its child so that the standing queue builds in it, and netem adds a
+# fixed delay on the return path. Several bulk TCP flows then fill the
+# link while ping measures the round trip time of a sparse flow.
+#
+# With a plain fifo the ping RTT grows by the queueing delay of the whole
+# bottleneck buffer; fq_codel and fq should keep it close to the base RTT.
+# The test fails if either of them does not at least halve the fifo RTT.
+
+RATE=${RATE:-4mbit}
+DELAY=${DELAY:-20ms}
+FLOWS=${FLOWS:-4}
+SECONDS_LOAD=${SECONDS_LOAD:-10}
+PORT=5201
+
+NS_TX=qdisc_lat_tx
+NS_RX=qdisc_lat_rx
+
+TEST=qdisc_latency
+. "$(dirname "$0")/lib.sh"
+
+require_root
+require_tools ip tc ping
+
+setup()
+{
+	netns_add $NS_TX $NS_RX
+	veth_add $NS_TX veth_tx 10.199.0.1/24 $NS_RX veth_rx 10.199.0.2/24
+	ip netns exec $NS_RX tc qdisc add dev veth_rx root netem delay $DELAY
+	ip netns exec $NS_RX ./tcp_bulk -l $PORT &
+	SINK=$!
+	sleep 1
+}
+
+# run_one <qdisc> [args...]: prints the average ping RTT in ms
+run_one()
+{
+	ip netns exec $NS_TX tc qdisc del dev veth_tx root 2>/dev/null
+	ip netns exec $NS_TX tc qdisc add dev veth_tx root handle 1: \
+		tbf rate $RATE burst 16k latency 2s || return 1
+	ip netns exec $NS_TX tc qdisc add dev veth_tx parent 1:1 handle 10: \
+		"$@" || return 1
+
+	i=0
+	while [ $i -lt $FLOWS ]; do
+		ip netns exec $NS_TX ./tcp_bulk -c 10.199.0.2 $PORT \
+			$SECONDS_LOAD >/dev/null &
+		i=$((i + 1))
+	done
+	sleep 2
+
+	ip netns exec $NS_TX ping -q -i 0.2 -c $(( (SECONDS_LOAD - 3) * 5 )) \
+		10.199.0.2 | sed -n 's|.*= [0-9.]*/\([0-9.]*\)/.*|\1|p'
+	wait_flows
+}
+
+wait_flows()
+{
+	for pid in $(jobs -p); do
+		[ "$pid" = "$SINK" ] || wait $pid
+	done
+}
+
+setup
+
+fifo=$(run_one pfifo limit 1000)
+fq_codel=$(run_one fq_codel)
+fq=$(run_one fq)
+
+kill $SINK 2>/dev/null
+SINK=
+
+echo "avg rtt under load: pfifo ${fifo}ms fq_codel ${fq_codel}ms fq ${fq}ms"
+
+if [ -z "$fifo" ] || [ -z "$fq_codel" ] || [ -z "$fq" ]; then
+	echo "[FAIL] missing measurement (qdisc not available?)"
+	exit 1
+fi
+
+ret=0
+for res in "fq_codel $fq_codel" "fq $fq"; do
+	set -- $res
+	if awk -v a="$2" -v b="$fifo" 'BEGIN { exit !(a * 2 < b) }'; then
+		echo "[PASS] $1"
+	else
+		echo "[FAIL] $1 does not cut the fifo queueing delay"
+		ret=1
+	fi
+done
+exit $ret
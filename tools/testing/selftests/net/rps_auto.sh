@@ -0,0 +1,103 @@
+#!/bin/sh
+#
+# Automatic receive packet steering (net.core.rps_auto).
+#
+# Two network namespaces are joined by a veth pair, whose receive side has
+# no rps_cpus map. A few parallel bulk TCP flows run once with rps_auto off
+# and once with it on, and the per-cpu columns that /proc/net/softnet_stat
+# gained for steering are compared:
+#
+#   column 13  packets this cpu handed to another cpu's backlog
+#   column 14  flows this cpu assigned a target cpu
+#   column 15  ... of which the target cpu had to be woken
+#
+# The test fails if rps_auto on does not steer packets and assign flows,
+# or if flows get assigned with rps_auto off.
+
+FLOWS=${FLOWS:-4}
+DURATION=${DURATION:-5}
+PORT=5205
+
+NS_TX=rps_auto_tx
+NS_RX=rps_auto_rx
+
+TEST=rps_auto
+. "$(dirname "$0")/lib.sh"
+
+require_root
+require_tools ip sysctl
+[ -e /proc/sys/net/core/rps_auto ] ||
+	skip "kernel without automatic steering"
+[ $(getconf _NPROCESSORS_ONLN) -ge 2 ] || skip "needs two cpus online"
+
+orig=$(cat /proc/sys/net/core/rps_auto)
+
+test_cleanup()
+{
+	sysctl -qw net.core.rps_auto=$orig
+}
+
+netns_add $NS_TX $NS_RX
+veth_add $NS_TX veth_tx 10.198.5.1/24 $NS_RX veth_rx 10.198.5.2/24
+
+ip netns exec $NS_RX ./tcp_bulk -l $PORT &
+SINK=$!
+sleep 1
+
+# column <n>: prints the sum of softnet_stat column n over all cpus
+column()
+{
+	awk -v n=$1 '
+		function hex(s,  i, v) {
+			for (i = 1; i <= length(s); i++)
+				v = v * 16 + index("0123456789abcdef",
+						   substr(s, i, 1)) - 1
+			return v
+		}
+		{ sum += hex($n) }
+		END { print sum + 0 }' /proc/net/softnet_stat
+}
+
+# run <0|1>: loads the link with rps_auto set, prints the column deltas
+run()
+{
+	sysctl -qw net.core.rps_auto=$1 || exit 1
+	steered=$(column 13)
+	picks=$(column 14)
+	wakes=$(column 15)
+
+	pids=
+	for i in $(seq $FLOWS); do
+		ip netns exec $NS_TX ./tcp_bulk -c 10.198.5.2 $PORT $DURATION \
+			>/dev/null &
+		pids="$pids $!"
+	done
+	wait $pids
+
+	echo "$(( $(column 13) - steered )) $(( $(column 14) - picks ))" \
+	     "$(( $(column 15) - wakes ))"
+}
+
+[ $(awk '{ print NF; exit }' /proc/net/softnet_stat) -ge 15 ] ||
+	skip "softnet_stat without steering columns"
+
+set -- $(run 0)
+echo "rps_auto=0: steered $1 packets, $2 flow picks, $3 wakes"
+off_picks=$2
+set -- $(run 1)
+echo "rps_auto=1: steered $1 packets, $2 flow picks, $3 wakes"
+
+ret=0
+if [ $1 -gt 0 ] && [ $2 -gt 0 ]; then
+	echo "[PASS] rps_auto steers flows across cpus"
+else
+	echo "[FAIL] rps_auto did not steer"
+	ret=1
+fi
+if [ $off_picks -eq 0 ]; then
+	echo "[PASS] no automatic steering with rps_auto off"
+else
+	echo "[FAIL] flows picked a cpu with rps_auto off"
+	ret=1
+fi
+exit $ret
@@ -0,0 +1,150 @@
+#!/bin/sh
+#
+# Receive rate of a usbnet link fed by pktgen, and the skb recycle pool
+# hit rate while it runs.
+#
+# dummy_hcd and g_ether give a USB loopback inside one machine. pktgen
+# floods UDP frames out of the gadget side, the host side (a usbnet
+# minidriver) receives them and the stack drops them for lack of a
+# listener, so every frame is one rx buffer allocated and freed. With
+# CONFIG_SKB_RECYCLE those buffers should come back from the per-cpu pools
+# in /proc/net/skb_recycle instead of the slab allocator.
+#
+# The packet rate is printed for comparison across kernels or across
+# net.core.skb_recycle_max settings (0 turns recycling off). The test fails
+# if nothing was received, or if the pools exist but served no allocation.
+
+COUNT=${COUNT:-200000}
+PKT_SIZE=${PKT_SIZE:-1000}
+
+NS_HOST=skb_recycle_host
+
+TEST=skb_recycle
+. "$(dirname "$0")/lib.sh"
+
+require_root
+require_tools ip
+
+loaded=
+for mod in dummy_hcd g_ether pktgen; do
+	# pktgen may be built in
+	[ $mod = pktgen ] && [ -d /proc/net/pktgen ] && continue
+	if ! grep -q "^$mod " /proc/modules; then
+		modprobe $mod 2>/dev/null || skip "cannot load $mod"
+		loaded="$mod $loaded"
+	fi
+done
+
+test_cleanup()
+{
+	[ -n "$gadget" ] && echo "rem_device_all" > /proc/net/pktgen/kpktgend_0
+	for mod in $loaded; do
+		modprobe -r $mod 2>/dev/null
+	done
+}
+
+# Wait for enumeration, then tell the two ends apart by their parent device.
+gadget=
+host=
+for i in 1 2 3 4 5 6 7 8 9 10; do
+	for dev in /sys/class/net/*; do
+		[ -e $dev/device ] || continue
+		case $(readlink $dev/device/driver) in
+		*/cdc_ether|*/rndis_host)
+			host=${dev##*/}
+			;;
+		esac
+		case $(readlink -f $dev/device) in
+		*gadget*)
+			gadget=${dev##*/}
+			;;
+		esac
+	done
+	[ -n "$gadget" ] && [ -n "$host" ] && break
+	sleep 1
+done
+[ -n "$gadget" ] && [ -n "$host" ] || skip "no usbnet loopback link"
+mac=$(cat /sys/class/net/$host/address)
+
+# pktgen only knows devices of the initial namespace: the gadget side
+# stays there, the usbnet side moves out so it gets a stack of its own.
+netns_add $NS_HOST
+ip link set $host netns $NS_HOST || exit 1
+ip -n $NS_HOST addr add 10.0.8.2/24 dev $host
+ip -n $NS_HOST link set $host up
+ip link set $gadget up
+
+# pgset <file> <command>: one pktgen command, fails the test on error
+pgset()
+{
+	echo "$2" > $1
+	if ! grep -q "Result: OK" $1; then
+		echo "skb_recycle: pktgen '$2' failed"
+		exit 1
+	fi
+}
+
+pgset /proc/net/pktgen/kpktgend_0 "rem_device_all"
+pgset /proc/net/pktgen/kpktgend_0 "add_device $gadget"
+PG=/proc/net/pktgen/$gadget
+pgset $PG "count $COUNT"
+pgset $PG "pkt_size $PKT_SIZE"
+pgset $PG "clone_skb 0"
+pgset $PG "delay 0"
+pgset $PG "src_min 10.0.8.1"
+pgset $PG "src_max 10.0.8.1"
+pgset $PG "dst 10.0.8.2"
+pgset $PG "dst_mac $mac"
+pgset $PG "udp_dst_min 9"
+pgset $PG "udp_dst_max 9"
+
+# recycle <column>: sums a column of /proc/net/skb_recycle over all cpus
+recycle()
+{
+	awk -v n=$1 'NR > 1 { sum += $n } END { print sum + 0 }' \
+		/proc/net/skb_recycle 2>/dev/null || echo 0
+}
+
+rx()
+{
+	ip netns exec $NS_HOST cat /sys/class/net/$host/statistics/rx_packets
+}
+
+packets=$(rx)
+hits=$(recycle 2)
+misses=$(recycle 3)
+start=$(date +%s.%N)
+
+echo "start" > /proc/net/pktgen/pgctrl
+
+elapsed=$(echo "$(date +%s.%N) $start" | awk '{ print $1 - $2 }')
+packets=$(( $(rx) - packets ))
+hits=$(( $(recycle 2) - hits ))
+misses=$(( $(recycle 3) - misses ))
+
+echo "usbnet rx on $host: $packets of $COUNT frames in ${elapsed}s"
+awk -v p=$packets -v t=$elapsed -v h=$hits -v m=$misses 'BEGIN {
+	printf "%.0f packets/s", p / t
+	if (h + m > 0)
+		printf ", skb recycle hit rate %.1f%% (%d/%d)", \
+			100 * h / (h + m), h, h + m
+	printf "\n"
+}'
+
+ret=0
+if [ $packets -gt 0 ]; then
+	echo "[PASS] frames received over usbnet"
+else
+	echo "[FAIL] nothing received over usbnet"
+	ret=1
+fi
+if [ -e /proc/net/skb_recycle ] &&
+   [ "$(cat /proc/sys/net/core/skb_recycle_max 2>/dev/null)" != 0 ]; then
+	if [ $hits -gt 0 ]; then
+		echo "[PASS] rx buffers served from the recycle pool"
+	else
+		echo "[FAIL] recycle pool served no rx buffer"
+		ret=1
+	fi
+fi
+exit $ret
@@ -0,0 +1,128 @@
+/*
+ * tcp_bulk: minimal bulk TCP sender/sink used to load a link
+ *
+ *   tcp_bulk -l port                 accept connections, discard data
+ *   tcp_bulk -c addr port seconds [cc]
+ *                                    send as fast as possible for seconds,
+ *                                    optionally with congestion control cc,
+ *                                    then print the number of bytes sent
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+static char buf[64 * 1024];
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s -l port\n"
+			"       %s -c addr port seconds [cc]\n", prog, prog);
+	exit(1);
+}
+
+static int sink(int port)
+{
+	struct sockaddr_in addr;
+	int fd, one = 1;
+
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) {
+		perror("socket");
+		return 1;
+	}
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) ||
+	    listen(fd, 16)) {
+		perror("bind/listen");
+		return 1;
+	}
+
+	signal(SIGCHLD, SIG_IGN);
+	for (;;) {
+		int c = accept(fd, NULL, NULL);
+
+		if (c < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("accept");
+			return 1;
+		}
+		if (!fork()) {
+			while (read(c, buf, sizeof(buf)) > 0)
+				;
+			_exit(0);
+		}
+		close(c);
+	}
+}
+
+static int source(const char *host, int port, int seconds, const char *cc)
+{
+	struct sockaddr_in addr;
+	unsigned long long sent = 0;
+	time_t end;
+	ssize_t n;
+	int fd;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	if (inet_pton(AF_INET, host, &addr.sin_addr) != 1)
+		usage("tcp_bulk");
+
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) {
+		perror("socket");
+		return 1;
+	}
+	if (cc && setsockopt(fd, IPPROTO_TCP, TCP_CONGESTION, cc, strlen(cc))) {
+		perror("TCP_CONGESTION");
+		return 1;
+	}
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+		perror("connect");
+		return 1;
+	}
+
+	end = time(NULL) + seconds;
+	while (time(NULL) < end) {
+		n = write(fd, buf, sizeof(buf));
+		if (n < 0) {
+			perror("write");
+			return 1;
+		}
+		sent += n;
+	}
+	close(fd);
+	printf("%llu\n", sent);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc == 3 && !strcmp(argv[1], "-l"))
+		return sink(atoi(argv[2]));
+	if ((argc == 5 || argc == 6) && !strcmp(argv[1], "-c"))
+		return source(argv[2], atoi(argv[3]), atoi(argv[4]),
+			      argc == 6 ? argv[5] : NULL);
+	usage(argv[0]);
+	return 1;
+}
@@ -0,0 +1,85 @@
+#!/bin/sh
+#
+# Bulk TCP throughput of cubic and bbr over a lossy path.
+#
+# Three network namespaces form a line: sender, router and receiver. The
+# router's egress towards the receiver is a netem bottleneck with a fixed
+# delay, a rate limit and random loss; the sender uses fq so that bbr's
+# pacing rate is enforced. For each loss profile a single flow of each
+# congestion control runs for a while and the goodput is reported.
+#
+# Loss based congestion control collapses under random loss that is not a
+# congestion signal, bbr should not. The test fails if bbr does not reach
+# at least twice the cubic goodput on the lossiest profile.
+
+RATE=${RATE:-20mbit}
+DELAY=${DELAY:-25ms}
+LOSSES=${LOSSES:-"0% 1% 5%"}
+SECONDS_LOAD=${SECONDS_LOAD:-15}
+PORT=5202
+
+NS_TX=tcp_cc_tx
+NS_RTR=tcp_cc_rtr
+NS_RX=tcp_cc_rx
+
+TEST=tcp_cc_loss
+. "$(dirname "$0")/lib.sh"
+
+require_root
+require_tools ip tc sysctl
+modprobe tcp_bbr 2>/dev/null
+grep -qw bbr /proc/sys/net/ipv4/tcp_available_congestion_control ||
+	skip "bbr not available"
+
+setup()
+{
+	netns_add $NS_TX $NS_RTR $NS_RX
+	veth_add $NS_TX veth_tx 10.198.1.1/24 $NS_RTR veth_rtr0 10.198.1.2/24
+	veth_add $NS_RX veth_rx 10.198.2.1/24 $NS_RTR veth_rtr1 10.198.2.2/24
+	ip -n $NS_TX route add default via 10.198.1.2
+	ip -n $NS_RX route add default via 10.198.2.2
+	ip netns exec $NS_RTR sysctl -qw net.ipv4.ip_forward=1
+
+	# Disable segmentation offloads so netem sees wire sized packets.
+	ip netns exec $NS_TX ethtool -K veth_tx tso off gso off 2>/dev/null
+	ip netns exec $NS_TX tc qdisc add dev veth_tx root fq || exit 1
+
+	ip netns exec $NS_RX ./tcp_bulk -l $PORT &
+	SINK=$!
+	sleep 1
+}
+
+# run_one <loss> <cc>: prints the goodput in kbit/s
+run_one()
+{
+	ip netns exec $NS_RTR tc qdisc replace dev veth_rtr1 root netem \
+		delay $DELAY rate $RATE loss $1 limit 1000 || return 1
+	bytes=$(ip netns exec $NS_TX ./tcp_bulk -c 10.198.2.1 $PORT \
+		$SECONDS_LOAD $2)
+	[ -n "$bytes" ] && echo $((bytes * 8 / 1000 / SECONDS_LOAD))
+}
+
+setup
+
+ret=0
+for loss in $LOSSES; do
+	cubic=$(run_one $loss cubic)
+	bbr=$(run_one $loss bbr)
+	echo "loss $loss: cubic ${cubic:-?} kbit/s bbr ${bbr:-?} kbit/s"
+	if [ -z "$cubic" ] || [ -z "$bbr" ]; then
+		echo "[FAIL] missing measurement at loss $loss"
+		ret=1
+	fi
+done
+
+kill $SINK 2>/dev/null
+SINK=
+
+[ $ret -eq 0 ] || exit $ret
+if [ $bbr -ge $((cubic * 2)) ]; then
+	echo "[PASS] bbr keeps the link busy under loss"
+else
+	echo "[FAIL] bbr goodput not above twice cubic at loss $loss"
+	ret=1
+fi
+exit $ret
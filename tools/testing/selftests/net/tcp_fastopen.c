@@ -0,0 +1,181 @@
+/*
+ * tcp_fastopen: request/response over TCP, with or without Fast Open
+ *
+ *   tcp_fastopen -l port              answer every request with a short
+ *                                     response, TCP_FASTOPEN enabled on
+ *                                     the listener
+ *   tcp_fastopen -c addr port count [plain]
+ *                                     open count connections in a row, each
+ *                                     sending one request and waiting for
+ *                                     the response, then print the average
+ *                                     time to first response byte in ms.
+ *                                     The request goes in the SYN using
+ *                                     MSG_FASTOPEN unless plain is given.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#ifndef TCP_FASTOPEN
+#define TCP_FASTOPEN	23
+#endif
+#ifndef MSG_FASTOPEN
+#define MSG_FASTOPEN	0x20000000
+#endif
+
+static const char request[] = "GET / HTTP/1.0\r\n\r\n";
+static const char response[] = "HTTP/1.0 200 OK\r\n\r\n";
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s -l port\n"
+			"       %s -c addr port count [plain]\n", prog, prog);
+	exit(1);
+}
+
+static int server(int port)
+{
+	struct sockaddr_in addr;
+	int fd, one = 1, qlen = 16;
+	char buf[256];
+
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) {
+		perror("socket");
+		return 1;
+	}
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	if (setsockopt(fd, IPPROTO_TCP, TCP_FASTOPEN, &qlen, sizeof(qlen))) {
+		perror("TCP_FASTOPEN");
+		return 1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) ||
+	    listen(fd, 16)) {
+		perror("bind/listen");
+		return 1;
+	}
+
+	for (;;) {
+		int c = accept(fd, NULL, NULL);
+
+		if (c < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("accept");
+			return 1;
+		}
+		if (read(c, buf, sizeof(buf)) > 0 &&
+		    write(c, response, sizeof(response) - 1) < 0)
+			perror("write");
+		close(c);
+	}
+}
+
+static double now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/* One request; returns the time to the first response byte in ms. */
+static double one_request(const struct sockaddr_in *addr, int plain)
+{
+	double start;
+	char buf[256];
+	ssize_t n;
+	int fd;
+
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) {
+		perror("socket");
+		return -1;
+	}
+
+	start = now_ms();
+	if (plain) {
+		if (connect(fd, (const struct sockaddr *)addr, sizeof(*addr))) {
+			perror("connect");
+			goto fail;
+		}
+		n = send(fd, request, sizeof(request) - 1, 0);
+	} else {
+		n = sendto(fd, request, sizeof(request) - 1, MSG_FASTOPEN,
+			   (const struct sockaddr *)addr, sizeof(*addr));
+	}
+	if (n != sizeof(request) - 1) {
+		perror("send");
+		goto fail;
+	}
+	if (read(fd, buf, sizeof(buf)) <= 0) {
+		perror("read");
+		goto fail;
+	}
+	close(fd);
+	return now_ms() - start;
+
+fail:
+	close(fd);
+	return -1;
+}
+
+static int client(const char *host, int port, int count, int plain)
+{
+	struct sockaddr_in addr;
+	double ms, total = 0;
+	int i;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	if (inet_pton(AF_INET, host, &addr.sin_addr) != 1)
+		usage("tcp_fastopen");
+
+	/* The first Fast Open connection only fetches the cookie. */
+	if (!plain && one_request(&addr, plain) < 0)
+		return 1;
+
+	for (i = 0; i < count; i++) {
+		ms = one_request(&addr, plain);
+		if (ms < 0)
+			return 1;
+		total += ms;
+	}
+	printf("%.1f\n", total / count);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc == 3 && !strcmp(argv[1], "-l"))
+		return server(atoi(argv[2]));
+	if ((argc == 5 || argc == 6) && !strcmp(argv[1], "-c")) {
+		if (argc == 6 && strcmp(argv[5], "plain"))
+			usage(argv[0]);
+		if (atoi(argv[4]) <= 0)
+			usage(argv[0]);
+		return client(argv[2], atoi(argv[3]), atoi(argv[4]),
+			      argc == 6);
+	}
+	usage(argv[0]);
+	return 1;
+}
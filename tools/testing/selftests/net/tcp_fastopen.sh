@@ -0,0 +1,79 @@
+#!/bin/sh
+#
+# Time to first response byte with and without TCP Fast Open.
+#
+# A network namespace gets a loopback device with a netem delay, so that
+# every segment pays half of the configured RTT. A client opens a series
+# of short request/response connections to a server in the same namespace,
+# first with a plain connect() and then with the request carried in the SYN
+# through MSG_FASTOPEN.
+#
+# Without Fast Open a request costs two round trips (handshake, then the
+# request); with a cached cookie it should cost one. The test fails if Fast
+# Open does not save at least a third of the plain time to first byte, or
+# if the TcpExt Fast Open counters did not move.
+
+DELAY=${DELAY:-50ms}
+COUNT=${COUNT:-10}
+PORT=5203
+
+NS=tcp_tfo
+
+TEST=tcp_fastopen
+. "$(dirname "$0")/lib.sh"
+
+require_root
+require_tools ip tc sysctl
+[ -e /proc/sys/net/ipv4/tcp_fastopen ] || skip "kernel without Fast Open"
+
+# counter <name>: prints the TcpExt counter of the namespace
+counter()
+{
+	ip netns exec $NS awk -v name=$1 '
+		/^TcpExt:/ {
+			if (!n) { for (i = 2; i <= NF; i++) col[$i] = i; n = 1 }
+			else print $col[name]
+		}' /proc/net/netstat
+}
+
+netns_add $NS
+ip -n $NS link set lo up
+ip netns exec $NS tc qdisc add dev lo root netem delay $DELAY || exit 1
+# Client and server both enabled.
+ip netns exec $NS sysctl -qw net.ipv4.tcp_fastopen=3 || exit 1
+
+ip netns exec $NS ./tcp_fastopen -l $PORT &
+SINK=$!
+sleep 1
+
+active=$(counter TCPFastOpenActive)
+passive=$(counter TCPFastOpenPassive)
+
+plain=$(ip netns exec $NS ./tcp_fastopen -c 127.0.0.1 $PORT $COUNT plain)
+tfo=$(ip netns exec $NS ./tcp_fastopen -c 127.0.0.1 $PORT $COUNT)
+
+active=$(( $(counter TCPFastOpenActive) - active ))
+passive=$(( $(counter TCPFastOpenPassive) - passive ))
+
+echo "time to first byte: plain ${plain:-?}ms fastopen ${tfo:-?}ms"
+echo "TCPFastOpenActive +$active TCPFastOpenPassive +$passive"
+
+if [ -z "$plain" ] || [ -z "$tfo" ]; then
+	echo "[FAIL] missing measurement"
+	exit 1
+fi
+
+ret=0
+if awk -v a="$tfo" -v b="$plain" 'BEGIN { exit !(a * 3 < b * 2) }'; then
+	echo "[PASS] fastopen saves a round trip"
+else
+	echo "[FAIL] fastopen does not cut the time to first byte"
+	ret=1
+fi
+if [ $active -ge $COUNT ] && [ $passive -ge $COUNT ]; then
+	echo "[PASS] fastopen counters"
+else
+	echo "[FAIL] expected at least $COUNT active and passive fast opens"
+	ret=1
+fi
+exit $ret
@@ -0,0 +1,323 @@
+/*
+ * tpacket_v3_tx: packet rate of a PACKET_TX_RING
+ *
+ *   tpacket_v3_tx [-v 2|3] [-s size] [-b block_size] [-n blocks] ifname seconds
+ *
+ * Fills the transmit ring with size byte Ethernet frames (broadcast, local
+ * experimental ethertype) and sends them out of ifname for seconds. With
+ * -v 3 (the default) the ring is TPACKET_V3: every block is packed with
+ * as many frames as fit and handed to the kernel whole. With -v 2 it is a
+ * TPACKET_V2 ring of frames of the same total size, one frame per packet,
+ * for comparison. Prints "packets wrong_format packets/s block_us", where
+ * wrong_format counts the blocks or frames the kernel refused and block_us
+ * is the mean time from the first to the last packet of a V3 block.
+ *
+ * Exits with 2 if the kernel has no TPACKET_V3 transmit ring.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+
+#define ETH_P_TEST	0x88b5
+#define V3_ALIGNMENT	8
+#define ALIGN(x, a)	(((x) + (a) - 1) & ~((a) - 1))
+#define BLK_HDR_LEN	ALIGN(sizeof(struct tpacket_block_desc), V3_ALIGNMENT)
+
+static int version = TPACKET_V3;
+static unsigned int size = 60, block_size = 1 << 16, blocks = 16;
+static unsigned int frame_size, data_off;
+static char *ring;
+
+static unsigned long long packets, wrong;
+static unsigned long long block_ns, blocks_done;
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-v 2|3] [-s size] [-b block_size] "
+			"[-n blocks] ifname seconds\n", prog);
+	exit(1);
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void fill_frame(unsigned char *data, unsigned int seq)
+{
+	struct ethhdr *eth = (struct ethhdr *)data;
+
+	memset(eth->h_dest, 0xff, ETH_ALEN);
+	memcpy(eth->h_source, "\x02\x00\x00\x00\x00\x01", ETH_ALEN);
+	eth->h_proto = htons(ETH_P_TEST);
+	memcpy(data + sizeof(*eth), &seq, sizeof(seq));
+}
+
+static int setup(const char *ifname)
+{
+	struct sockaddr_ll ll;
+	struct tpacket_req3 req;
+	int fd, ver = version;
+
+	fd = socket(AF_PACKET, SOCK_RAW, 0);
+	if (fd < 0) {
+		perror("socket");
+		exit(1);
+	}
+	if (setsockopt(fd, SOL_PACKET, PACKET_VERSION, &ver, sizeof(ver))) {
+		perror("PACKET_VERSION");
+		exit(1);
+	}
+
+	if (version == TPACKET_V3)
+		data_off = TPACKET3_HDRLEN - sizeof(struct sockaddr_ll);
+	else
+		data_off = TPACKET2_HDRLEN - sizeof(struct sockaddr_ll);
+	frame_size = TPACKET_ALIGN(data_off + size);
+	if (frame_size < TPACKET_ALIGN(TPACKET3_HDRLEN))
+		frame_size = TPACKET_ALIGN(TPACKET3_HDRLEN);
+	if (block_size < BLK_HDR_LEN + frame_size)
+		usage("tpacket_v3_tx");
+
+	memset(&req, 0, sizeof(req));
+	req.tp_block_size = block_size;
+	req.tp_block_nr = blocks;
+	req.tp_frame_size = frame_size;
+	req.tp_frame_nr = block_size / frame_size * blocks;
+	if (setsockopt(fd, SOL_PACKET, PACKET_TX_RING, &req,
+		       version == TPACKET_V3 ? sizeof(req) :
+		       sizeof(struct tpacket_req))) {
+		if (errno == EINVAL && version == TPACKET_V3) {
+			fprintf(stderr, "no TPACKET_V3 transmit ring\n");
+			exit(2);
+		}
+		perror("PACKET_TX_RING");
+		exit(1);
+	}
+
+	ring = mmap(NULL, (size_t)block_size * blocks, PROT_READ | PROT_WRITE,
+		    MAP_SHARED, fd, 0);
+	if (ring == MAP_FAILED) {
+		perror("mmap");
+		exit(1);
+	}
+
+	memset(&ll, 0, sizeof(ll));
+	ll.sll_family = AF_PACKET;
+	ll.sll_protocol = htons(ETH_P_TEST);
+	ll.sll_ifindex = if_nametoindex(ifname);
+	if (!ll.sll_ifindex) {
+		fprintf(stderr, "no interface %s\n", ifname);
+		exit(1);
+	}
+	if (bind(fd, (struct sockaddr *)&ll, sizeof(ll))) {
+		perror("bind");
+		exit(1);
+	}
+	return fd;
+}
+
+static void stuck(unsigned int pending)
+{
+	fprintf(stderr, "%u still not sent a second after the end\n", pending);
+	exit(1);
+}
+
+/* Packs a free V3 block with frames and hands it to the kernel. */
+static void fill_block(struct tpacket_block_desc *pbd, unsigned int *seq)
+{
+	struct tpacket_hdr_v1 *h1 = &pbd->hdr.bh1;
+	unsigned int stride = ALIGN(data_off + size, V3_ALIGNMENT);
+	unsigned int off = BLK_HDR_LEN, n = 0;
+	struct tpacket3_hdr *ph = NULL;
+
+	while (off + stride <= block_size) {
+		ph = (struct tpacket3_hdr *)((char *)pbd + off);
+		memset(ph, 0, sizeof(*ph));
+		ph->tp_len = size;
+		ph->tp_snaplen = size;
+		ph->tp_next_offset = stride;
+		fill_frame((unsigned char *)ph + data_off, (*seq)++);
+		off += stride;
+		n++;
+	}
+	ph->tp_next_offset = 0;
+
+	h1->num_pkts = n;
+	h1->offset_to_first_pkt = BLK_HDR_LEN;
+	h1->blk_len = off;
+	__sync_synchronize();
+	h1->block_status = TP_STATUS_SEND_REQUEST;
+}
+
+/* Accounts a block the kernel has given back. */
+static void reap_block(struct tpacket_block_desc *pbd)
+{
+	struct tpacket_hdr_v1 *h1 = &pbd->hdr.bh1;
+
+	if (h1->block_status & TP_STATUS_WRONG_FORMAT) {
+		wrong++;
+		return;
+	}
+	packets += h1->num_pkts;
+	block_ns += (h1->ts_last_pkt.ts_sec - h1->ts_first_pkt.ts_sec) *
+		    1000000000ULL + h1->ts_last_pkt.ts_nsec -
+		    h1->ts_first_pkt.ts_nsec;
+	blocks_done++;
+}
+
+static void run_v3(int fd, int seconds)
+{
+	unsigned char *inflight = calloc(blocks, 1);
+	struct tpacket_block_desc *pbd;
+	unsigned int seq = 0, i, status, pending = 0;
+	double end = now() + seconds;
+	int done;
+
+	for (;;) {
+		done = now() >= end;
+		for (i = 0; i < blocks; i++) {
+			pbd = (struct tpacket_block_desc *)
+				(ring + (size_t)i * block_size);
+			status = __atomic_load_n(&pbd->hdr.bh1.block_status,
+						 __ATOMIC_ACQUIRE);
+			if (status == TP_STATUS_SEND_REQUEST ||
+			    status == TP_STATUS_SENDING)
+				continue;
+			if (inflight[i]) {
+				reap_block(pbd);
+				inflight[i] = 0;
+				pending--;
+			}
+			if (!done) {
+				fill_block(pbd, &seq);
+				inflight[i] = 1;
+				pending++;
+			}
+		}
+		if (done && !pending)
+			break;
+		if (done && now() > end + 1)
+			stuck(pending);
+		/* blocks until everything handed over has left */
+		if (send(fd, NULL, 0, 0) < 0) {
+			perror("send");
+			exit(1);
+		}
+	}
+	free(inflight);
+}
+
+static void run_v2(int fd, int seconds)
+{
+	unsigned int nr = block_size / frame_size * blocks;
+	unsigned char *inflight = calloc(nr, 1);
+	unsigned int fpb = block_size / frame_size;
+	struct tpacket2_hdr *ph;
+	unsigned int seq = 0, i, status, pending = 0;
+	double end = now() + seconds;
+	int done;
+
+	for (;;) {
+		done = now() >= end;
+		for (i = 0; i < nr; i++) {
+			ph = (struct tpacket2_hdr *)(ring +
+				(size_t)(i / fpb) * block_size +
+				(i % fpb) * frame_size);
+			status = __atomic_load_n(&ph->tp_status,
+						 __ATOMIC_ACQUIRE);
+			if (status == TP_STATUS_SEND_REQUEST ||
+			    status == TP_STATUS_SENDING)
+				continue;
+			if (inflight[i]) {
+				if (status & TP_STATUS_WRONG_FORMAT)
+					wrong++;
+				else
+					packets++;
+				inflight[i] = 0;
+				pending--;
+			}
+			if (!done) {
+				ph->tp_len = size;
+				fill_frame((unsigned char *)ph + data_off, seq++);
+				__sync_synchronize();
+				ph->tp_status = TP_STATUS_SEND_REQUEST;
+				inflight[i] = 1;
+				pending++;
+			}
+		}
+		if (done && !pending)
+			break;
+		if (done && now() > end + 1)
+			stuck(pending);
+		if (send(fd, NULL, 0, 0) < 0) {
+			perror("send");
+			exit(1);
+		}
+	}
+	free(inflight);
+}
+
+int main(int argc, char **argv)
+{
+	const char *prog = argv[0];
+	double start;
+	int fd, c, seconds;
+
+	while ((c = getopt(argc, argv, "v:s:b:n:")) != -1) {
+		switch (c) {
+		case 'v':
+			version = atoi(optarg) == 2 ? TPACKET_V2 : TPACKET_V3;
+			break;
+		case 's':
+			size = atoi(optarg);
+			if (size < ETH_ZLEN || size > ETH_FRAME_LEN)
+				usage(prog);
+			break;
+		case 'b':
+			block_size = atoi(optarg);
+			if (!block_size || block_size & (getpagesize() - 1))
+				usage(prog);
+			break;
+		case 'n':
+			blocks = atoi(optarg);
+			if (!blocks)
+				usage(prog);
+			break;
+		default:
+			usage(prog);
+		}
+	}
+	if (argc - optind != 2)
+		usage(prog);
+	seconds = atoi(argv[optind + 1]);
+
+	fd = setup(argv[optind]);
+	start = now();
+	if (version == TPACKET_V3)
+		run_v3(fd, seconds);
+	else
+		run_v2(fd, seconds);
+
+	printf("%llu %llu %.0f %.1f\n", packets, wrong,
+	       packets / (now() - start),
+	       blocks_done ? block_ns / 1000.0 / blocks_done : 0.0);
+	return 0;
+}
@@ -0,0 +1,82 @@
+#!/bin/sh
+#
+# Per-uid traffic counters of /proc/net/stat/activity_uid.
+#
+# msg_zerocopy sends UDP over loopback for DURATION seconds, sender and
+# sink both running as TEST_UID (with setpriv; as root if it is missing).
+# Loopback does not fragment these datagrams, so the uid must be charged
+# exactly one transmitted packet of UDP_SIZE plus the IP and UDP headers
+# per send, and received no more than was sent.
+
+DURATION=${DURATION:-3}
+UDP_SIZE=${UDP_SIZE:-1400}
+TEST_UID=${TEST_UID:-54321}
+PORT=5207
+STATS=/proc/net/stat/activity_uid
+
+NS=uid_activity
+
+TEST=uid_activity
+. "$(dirname "$0")/lib.sh"
+
+require_root
+require_tools ip
+[ -e $STATS ] || skip "no $STATS"
+
+netns_add $NS
+ip -n $NS link set lo up
+
+as_uid=
+if command -v setpriv >/dev/null 2>&1; then
+	as_uid="setpriv --reuid=$TEST_UID --regid=$TEST_UID --clear-groups"
+else
+	TEST_UID=0
+fi
+
+# counters: prints "rx_bytes rx_packets tx_bytes tx_packets" of TEST_UID
+counters()
+{
+	awk -v uid=$TEST_UID '$1 == uid { print $2, $3, $4, $5; found = 1 }
+		END { if (!found) print 0, 0, 0, 0 }' $STATS
+}
+
+before=$(counters)
+
+ip netns exec $NS $as_uid ./msg_zerocopy -u -s $UDP_SIZE -l $PORT &
+SINK=$!
+sleep 1
+result=$(ip netns exec $NS $as_uid ./msg_zerocopy -u -s $UDP_SIZE \
+	-c 127.0.0.1 $PORT $DURATION)
+kill $SINK
+wait $SINK 2>/dev/null
+SINK=
+
+set -- $result $before $(counters)
+if [ -z "$2" ]; then
+	echo "[FAIL] sender failed"
+	exit 1
+fi
+sends=$2
+rx_bytes=$(( $7 - $3 ))
+rx_packets=$(( $8 - $4 ))
+tx_bytes=$(( $9 - $5 ))
+tx_packets=$(( ${10} - $6 ))
+
+echo "uid $TEST_UID: $sends sends; rx $rx_packets packets $rx_bytes bytes," \
+	"tx $tx_packets packets $tx_bytes bytes"
+
+ret=0
+if [ $tx_packets = $sends ] &&
+   [ $tx_bytes = $(( sends * (UDP_SIZE + 28) )) ]; then
+	echo "[PASS] every send charged once to the sender"
+else
+	echo "[FAIL] $sends sends charged as $tx_packets packets"
+	ret=1
+fi
+if [ $rx_packets -gt 0 ] && [ $rx_packets -le $tx_packets ]; then
+	echo "[PASS] received datagrams charged to the sink"
+else
+	echo "[FAIL] $rx_packets packets received for $tx_packets sent"
+	ret=1
+fi
+exit $ret
@@ -0,0 +1,211 @@
+/*
+ * unix_msg_rate: AF_UNIX message rate over a socketpair
+ *
+ *   unix_msg_rate [-t dgram|seqpacket] [-s size] [-b batch] seconds
+ *
+ * A child process receives while the parent sends size byte messages as
+ * fast as it can for seconds. With -b the sender uses sendmmsg() and the
+ * receiver recvmmsg() with MSG_WAITFORONE, batch messages per call;
+ * without it, one send() or recv() per message. Every message carries a
+ * sequence number and the receiver checks that none is lost, duplicated
+ * or reordered. Prints "sent received messages/s".
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; version 2.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#define MAX_BATCH	64
+#define MAX_SIZE	4096
+
+static char bufs[MAX_BATCH][MAX_SIZE];
+static struct iovec iovs[MAX_BATCH];
+static struct mmsghdr msgs[MAX_BATCH];
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-t dgram|seqpacket] [-s size] [-b batch] "
+			"seconds\n", prog);
+	exit(1);
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void setup(int batch, int size)
+{
+	int i;
+
+	memset(msgs, 0, sizeof(msgs));
+	for (i = 0; i < batch; i++) {
+		iovs[i].iov_base = bufs[i];
+		iovs[i].iov_len = size;
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+}
+
+/*
+ * Receives until the empty message that ends the run and returns the
+ * number of messages received, or -1 on a sequence error.
+ */
+static long long receiver(int fd, int batch, int size)
+{
+	unsigned int expect = 0, seq;
+	long long received = 0;
+	int i, n;
+
+	setup(batch, size);
+	for (;;) {
+		if (batch > 1) {
+			n = recvmmsg(fd, msgs, batch, MSG_WAITFORONE, NULL);
+		} else {
+			n = recv(fd, bufs[0], size, 0);
+			msgs[0].msg_len = n;
+			n = n < 0 ? -1 : 1;
+		}
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("recv");
+			return -1;
+		}
+		for (i = 0; i < n; i++) {
+			if (msgs[i].msg_len == 0)
+				return received;
+			memcpy(&seq, bufs[i], sizeof(seq));
+			if (seq != expect) {
+				fprintf(stderr, "message %u where %u was due\n",
+					seq, expect);
+				return -1;
+			}
+			expect++;
+			received++;
+		}
+	}
+}
+
+static long long sender(int fd, int batch, int size, int seconds)
+{
+	unsigned int seq = 0;
+	long long sent = 0;
+	double end;
+	int i, n;
+
+	setup(batch, size);
+	end = now() + seconds;
+	while (now() < end) {
+		for (i = 0; i < batch; i++) {
+			memcpy(bufs[i], &seq, sizeof(seq));
+			seq++;
+		}
+		if (batch > 1) {
+			n = sendmmsg(fd, msgs, batch, 0);
+		} else {
+			n = send(fd, bufs[0], size, 0);
+			n = n < 0 ? -1 : 1;
+		}
+		if (n < 0) {
+			perror("send");
+			return -1;
+		}
+		/* numbers a short sendmmsg() did not send go out next round */
+		seq -= batch - n;
+		sent += n;
+	}
+
+	if (send(fd, bufs[0], 0, 0) < 0) {
+		perror("send");
+		return -1;
+	}
+	return sent;
+}
+
+int main(int argc, char **argv)
+{
+	int type = SOCK_DGRAM, size = 64, batch = 1, seconds;
+	long long sent, received;
+	const char *prog = argv[0];
+	int sv[2], pipefd[2];
+	double start;
+	pid_t pid;
+	int c;
+
+	while ((c = getopt(argc, argv, "t:s:b:")) != -1) {
+		switch (c) {
+		case 't':
+			if (!strcmp(optarg, "dgram"))
+				type = SOCK_DGRAM;
+			else if (!strcmp(optarg, "seqpacket"))
+				type = SOCK_SEQPACKET;
+			else
+				usage(prog);
+			break;
+		case 's':
+			size = atoi(optarg);
+			if (size < (int)sizeof(unsigned int) || size > MAX_SIZE)
+				usage(prog);
+			break;
+		case 'b':
+			batch = atoi(optarg);
+			if (batch < 1 || batch > MAX_BATCH)
+				usage(prog);
+			break;
+		default:
+			usage(prog);
+		}
+	}
+	if (argc - optind != 1)
+		usage(prog);
+	seconds = atoi(argv[optind]);
+
+	if (socketpair(AF_UNIX, type, 0, sv) || pipe(pipefd)) {
+		perror("socketpair");
+		return 1;
+	}
+
+	pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		return 1;
+	}
+	if (!pid) {
+		close(sv[0]);
+		received = receiver(sv[1], batch, size);
+		if (write(pipefd[1], &received, sizeof(received)) < 0)
+			_exit(1);
+		_exit(0);
+	}
+	close(sv[1]);
+
+	start = now();
+	sent = sender(sv[0], batch, size, seconds);
+	if (sent < 0) {
+		kill(pid, SIGKILL);
+		return 1;
+	}
+	if (read(pipefd[0], &received, sizeof(received)) != sizeof(received))
+		received = -1;
+	waitpid(pid, NULL, 0);
+	if (received < 0)
+		return 1;
+
+	printf("%lld %lld %.0f\n", sent, received, received / (now() - start));
+	return received == sent ? 0 : 1;
+}
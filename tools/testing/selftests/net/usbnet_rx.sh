@@ -0,0 +1,118 @@
+#!/bin/sh
+#
+# Receive cost of a usbnet link, in packets per second and CPU per Mbit.
+#
+# dummy_hcd and g_ether give a USB loopback inside one machine: the gadget
+# side shows up as a plain net device and the host side binds to a usbnet
+# minidriver (cdc_ether or rndis_host). Each side goes into its own network
+# namespace and a bulk TCP stream is sent from the gadget to the host, so
+# every data segment takes the usbnet rx path.
+#
+# The numbers are printed rather than judged; compare runs with usbnet
+# loaded with rx_napi=1 (the default) and rx_napi=0 to see what polling
+# from NAPI with GRO saves. The test only fails if no traffic made it.
+
+DURATION=${DURATION:-10}
+PORT=5204
+
+NS_GADGET=usbnet_gadget
+NS_HOST=usbnet_host
+
+TEST=usbnet_rx
+. "$(dirname "$0")/lib.sh"
+
+require_root
+require_tools ip
+
+loaded=
+for mod in dummy_hcd g_ether; do
+	if ! grep -q "^$mod " /proc/modules; then
+		modprobe $mod 2>/dev/null || skip "cannot load $mod"
+		loaded="$mod $loaded"
+	fi
+done
+
+test_cleanup()
+{
+	for mod in $loaded; do
+		modprobe -r $mod 2>/dev/null
+	done
+}
+
+# Wait for enumeration, then tell the two ends apart by their parent device.
+gadget=
+host=
+for i in 1 2 3 4 5 6 7 8 9 10; do
+	for dev in /sys/class/net/*; do
+		[ -e $dev/device ] || continue
+		drv=$(readlink $dev/device/driver)
+		case $drv in
+		*/cdc_ether|*/rndis_host)
+			host=${dev##*/}
+			hostdrv=${drv##*/}
+			;;
+		esac
+		case $(readlink -f $dev/device) in
+		*gadget*)
+			gadget=${dev##*/}
+			;;
+		esac
+	done
+	[ -n "$gadget" ] && [ -n "$host" ] && break
+	sleep 1
+done
+[ -n "$gadget" ] && [ -n "$host" ] || skip "no usbnet loopback link"
+
+netns_add $NS_GADGET $NS_HOST
+ip link set $gadget netns $NS_GADGET || exit 1
+ip link set $host netns $NS_HOST || exit 1
+ip -n $NS_GADGET addr add 10.0.7.1/24 dev $gadget
+ip -n $NS_HOST addr add 10.0.7.2/24 dev $host
+ip -n $NS_GADGET link set $gadget up
+ip -n $NS_HOST link set $host up
+
+# counter <name>: prints an interface counter of the host side
+counter()
+{
+	ip netns exec $NS_HOST cat /sys/class/net/$host/statistics/$1
+}
+
+# busy: prints the jiffies all cpus spent outside idle and iowait
+busy()
+{
+	awk '/^cpu / { print $2 + $3 + $4 + $7 + $8 + $9 }' /proc/stat
+}
+
+ip netns exec $NS_HOST ./tcp_bulk -l $PORT &
+SINK=$!
+sleep 1
+
+packets=$(counter rx_packets)
+bytes=$(counter rx_bytes)
+cpu=$(busy)
+
+ip netns exec $NS_GADGET ./tcp_bulk -c 10.0.7.2 $PORT $DURATION >/dev/null
+
+packets=$(( $(counter rx_packets) - packets ))
+bytes=$(( $(counter rx_bytes) - bytes ))
+cpu=$(( $(busy) - cpu ))
+
+napi=$(cat /sys/module/usbnet/parameters/rx_napi 2>/dev/null)
+hz=$(getconf CLK_TCK)
+
+echo "usbnet rx on $host ($hostdrv), rx_napi=${napi:-?}"
+awk -v p=$packets -v b=$bytes -v c=$cpu -v t=$DURATION -v hz=$hz 'BEGIN {
+	mbit = b * 8 / 1000000
+	printf "%.0f packets/s, %.1f Mbit/s, ", p / t, mbit / t
+	if (mbit > 0)
+		printf "%.1f cpu-ms/Mbit\n", c * 1000 / hz / mbit
+	else
+		printf "no cpu figure\n"
+}'
+
+if [ $packets -gt 0 ]; then
+	echo "[PASS] traffic received over usbnet"
+	exit 0
+fi
+echo "[FAIL] nothing received over usbnet"
+exit 1